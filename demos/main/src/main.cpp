@@ -25,6 +25,7 @@
 #include "game/camera_comp.hpp"
 #include "graphics/light.hpp"
 #include "graphics/util.hpp"
+#include "graphics/frame_capture.hpp"
 #include "data/hash_table.hpp"
 #include "application/platform/fs_monitor.hpp"
 #include "application/platform/fs_events.hpp"
@@ -47,6 +48,21 @@ public:
         {
            screen_shot("screen_shot");
         }
+        if (key_pressed(Key::F6))
+        {
+            if (is_capturing())
+            {
+                stop_capture();
+            }
+            else
+            {
+                start_capture("capture");
+            }
+        }
+        if (key_pressed(Key::F7) && !is_capturing_frames())
+        {
+            capture_frames("frame_capture.pgef", 10);
+        }
     }
 };
 
@@ -585,8 +601,19 @@ public:
 
             ImGui::Begin("Statistics", &stats_window_open);
 
-            auto str = fmt::format("fps: {}\nFrame time: {}\ndraw calls: {}\nvertices: {}",
-                stats.fps, stats.delta_time, render_stats.draw_calls, render_stats.vertices);
+			auto saved_fragments = render_stats.prepass_fragments > render_stats.shaded_fragments
+				? render_stats.prepass_fragments - render_stats.shaded_fragments : 0;
+
+            auto str = fmt::format("fps: {}\nFrame time: {}\ndraw calls: {}\nvertices: {}\nshadow map updates: {}\n"
+				"cascade updates: {}\nshadowed lights: {}\nshadow memory: {:.1f} MB\nshaded fragments: {}\nfragments saved by pre-pass: {}\nfrustum culled draws: {}\n"
+				"occluded draws: {}\noccluder triangles: {}\ntriangles: {}\ngpu frame time: {:.2f} ms\nresolution scale: {:.2f}\n"
+				"state changes: {}\nfiltered state changes: {}",
+                stats.fps, stats.delta_time, render_stats.draw_calls, render_stats.vertices,
+				render_stats.shadow_map_updates, render_stats.cascade_updates, render_stats.shadowed_lights,
+				render_stats.shadow_memory / (1024.0 * 1024.0), render_stats.shaded_fragments,
+				saved_fragments, render_stats.frustum_culled_draws, render_stats.occluded_draws, render_stats.occluder_triangles,
+				render_stats.triangles, render_stats.gpu_frame_ms, render_stats.resolution_scale,
+				render_stats.state_changes, render_stats.filtered_state_changes);
 
             ImGui::Text(str.data());
 
@@ -618,8 +645,26 @@ public:
 						auto settings = Engine::renderer->get_shadow_settings();
 
 						CHECK_CHANGE(changed, ImGui::Checkbox("Soft Shadows", &settings.enable_soft));
-						CHECK_CHANGE(changed, ImGui::DragInt("PCF samples", &settings.pcf_samples));
+
+						static const char *shadow_qualities[] = {"Low", "Medium", "High", "Ultra"};
+						auto shadow_quality = (int)settings.quality;
+
+						if (ImGui::Combo("Shadow quality", &shadow_quality, shadow_qualities, IM_ARRAYSIZE(shadow_qualities)))
+						{
+							settings.quality = (ShadowQuality)shadow_quality;
+							changed = true;
+						}
+
+						CHECK_CHANGE(changed, ImGui::DragFloat("Filter radius", &settings.filter_radius, 0.1, 0, 16));
 						CHECK_CHANGE(changed, ImGui::DragFloat("Bias", &settings.bias, 0.1));
+						CHECK_CHANGE(changed, ImGui::Checkbox("Geometry shader", &settings.use_geometry_shader));
+						CHECK_CHANGE(changed, ImGui::DragInt("Max resolution", &settings.max_resolution, 16, 16, 8192));
+						CHECK_CHANGE(changed, ImGui::DragInt("Min resolution", &settings.min_resolution, 16, 16, 4096));
+						CHECK_CHANGE(changed, ImGui::DragInt("Memory budget (MB)", &settings.memory_budget_mb, 1, 1, 4096));
+						CHECK_CHANGE(changed, ImGui::SliderInt("Cascades", &settings.cascade_count, 1, MAX_SHADOW_CASCADES));
+						CHECK_CHANGE(changed, ImGui::DragFloat("Cascade distance", &settings.cascade_distance, 1, 1, 1000));
+						CHECK_CHANGE(changed, ImGui::SliderFloat("Cascade split", &settings.cascade_split_lambda, 0, 1));
+						CHECK_CHANGE(changed, ImGui::Checkbox("Stagger cascades", &settings.stagger_cascades));
 
 						if (changed)
 						{
@@ -627,6 +672,61 @@ public:
 						}
 					}
 
+					{
+						ImGui::SeparatorText("Pipeline");
+
+						auto changed = false;
+						auto settings = Engine::renderer->get_pipeline_settings();
+
+						static const char *paths[] = {"Forward", "Deferred"};
+						auto path = (int)settings.path;
+
+						if (ImGui::Combo("Render path", &path, paths, IM_ARRAYSIZE(paths)))
+						{
+							settings.path = (RenderPath)path;
+							changed = true;
+						}
+
+						static const char *transparency_modes[] = {"Sorted", "Weighted blended"};
+						auto transparency = (int)settings.transparency;
+
+						if (ImGui::Combo("Transparency", &transparency, transparency_modes, IM_ARRAYSIZE(transparency_modes)))
+						{
+							settings.transparency = (TransparencyMode)transparency;
+							changed = true;
+						}
+
+						CHECK_CHANGE(changed, ImGui::Checkbox("Depth pre-pass", &settings.depth_prepass));
+						CHECK_CHANGE(changed, ImGui::Checkbox("Occlusion culling", &settings.occlusion_culling));
+						CHECK_CHANGE(changed, ImGui::Checkbox("Dynamic resolution", &settings.dynamic_resolution));
+						CHECK_CHANGE(changed, ImGui::DragFloat("Target frame time (ms)", &settings.target_frame_ms, 0.1f, 1.0f, 100.0f));
+						CHECK_CHANGE(changed, ImGui::SliderFloat("Min resolution scale", &settings.min_resolution_scale, 0.25f, 1.0f));
+
+						if (changed)
+						{
+							Engine::renderer->set_pipeline_settings(settings);
+						}
+					}
+
+					{
+						ImGui::SeparatorText("Level of detail");
+
+						auto changed = false;
+						auto settings = Engine::renderer->get_geometry_settings();
+						auto shadow_bias = (int)settings.shadow_lod_bias;
+
+						CHECK_CHANGE(changed, ImGui::Checkbox("Use LODs", &settings.use_lods));
+						CHECK_CHANGE(changed, ImGui::DragFloat("LOD threshold (pixels)", &settings.lod_threshold, 0.1, 0));
+						CHECK_CHANGE(changed, ImGui::SliderFloat("LOD hysteresis", &settings.lod_hysteresis, 0, 0.9));
+						CHECK_CHANGE(changed, ImGui::SliderInt("Shadow LOD bias", &shadow_bias, 0, MAX_MESH_LODS - 1));
+
+						if (changed)
+						{
+							settings.shadow_lod_bias = shadow_bias;
+							Engine::renderer->set_geometry_settings(settings);
+						}
+					}
+
 					{
 						ImGui::SeparatorText("Textures");
 
@@ -702,7 +802,17 @@ public:
 						if (settings.enable_bloom)
 						{
 							CHECK_CHANGE(changed, ImGui::DragFloat("Bright threshold", &settings.bright_threshold, 0.1));
-							CHECK_CHANGE(changed, ImGui::DragInt("Bloom blur passes", &settings.bloom_blur_passes, 0.1));
+							static const char *qualities[] = {"Low", "Medium", "High"};
+							auto quality = (int)settings.bloom_quality;
+
+							if (ImGui::Combo("Bloom quality", &quality, qualities, IM_ARRAYSIZE(qualities)))
+							{
+								settings.bloom_quality = (BloomQuality)quality;
+								changed = true;
+							}
+
+							CHECK_CHANGE(changed, ImGui::DragFloat("Bloom radius", &settings.bloom_radius, 0.05, 0));
+							CHECK_CHANGE(changed, ImGui::DragFloat("Bloom intensity", &settings.bloom_intensity, 0.05, 0));
 						}
 
 						if (changed)
@@ -808,6 +918,8 @@ public:
         return
         {
             {"Spotlight", &data.is_spot},
+            {"Directional", &data.is_directional},
+            {"Direction", Drag3Control(glm::value_ptr(data.direction), 0.01f, -1.0f, 1.0f)},
             {"Color", ColorEdit(glm::value_ptr(data.color))},
             {"Power", DragControl(&data.power)},
             {"Ambient", DragControl(&data.ambient)},
@@ -1003,12 +1115,14 @@ private:
 	inline static int m_count = 0;
 };
 
-void run_engine()
+// headless runs use the null renderer and stop after the given number of frames
+void run_engine(bool headless, uint64_t frames)
 {
 	ASSERT_ERR(Engine::init({
             .title = "playground engine",
             .window_size = {1920, 1080},
-            .graphics_api = GraphicsApi::OpenGl,
+            .graphics_api = headless ? GraphicsApi::Null : GraphicsApi::OpenGl,
+            .max_frames = headless ? frames : 0,
         }));
 
     Engine::entity_manager.create<ControlTest>("ControlTest");
@@ -1058,7 +1172,11 @@ void run_engine()
     Engine::shutdown();
 }
 
-int main()
+int main(int argc, char **argv)
 {
-    run_engine();
+    // --headless [frames] runs the scene without a window or gpu to measure the cpu side of a frame
+    auto headless = argc > 1 && std::string_view(argv[1]) == "--headless";
+    auto frames = headless && argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000;
+
+    run_engine(headless, frames);
 }
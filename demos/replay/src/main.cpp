@@ -0,0 +1,332 @@
+// replays the frames of a capture file written by pge::capture_frames and reports how long they took.
+// the working directory has to be the one the capture was made in since assets are referenced by path.
+//
+// usage: playgroundEngineReplay <capture> [iterations] [--null]
+//
+// --null replays with the null renderer to time only the cpu side. on a machine without a gpu
+// the gl path runs on a software implementation such as mesa llvmpipe under a virtual display
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <optional>
+
+#include "application/engine.hpp"
+#include "graphics/frame_capture.hpp"
+#include "graphics/light.hpp"
+
+using namespace pge;
+
+struct Timing
+{
+	double total = 0;
+	double min = std::numeric_limits<double>::max();
+	double max = 0;
+	uint64_t count = 0;
+
+	void add(double value)
+	{
+		total += value;
+		min = std::min(min, value);
+		max = std::max(max, value);
+		count++;
+	}
+
+	[[nodiscard]]
+	std::string to_string() const
+	{
+		if (count == 0)
+		{
+			return "-";
+		}
+
+		return fmt::format("{:.3f} avg {:.3f} min {:.3f} max", total / count, min, max);
+	}
+};
+
+static Texture load_texture(const FrameCaptureFile &capture, CapturedTexture texture)
+{
+	Texture output {.id = 0, .scale = texture.scale};
+
+	if (texture.index == UINT32_MAX)
+	{
+		return output;
+	}
+
+	auto *loaded = Engine::asset_manager.get_texture(capture.textures[texture.index]);
+
+	if (loaded != nullptr)
+	{
+		output.id = loaded->id;
+		output.enabled = true;
+		output.path = loaded->path;
+	}
+
+	return output;
+}
+
+static Material load_material(const FrameCaptureFile &capture, const CapturedMaterial &material)
+{
+	Material output;
+
+	output.shininess = material.shininess;
+	output.alpha = material.alpha;
+	output.diffuse = load_texture(capture, material.diffuse);
+	output.bump = load_texture(capture, material.bump);
+	output.depth = load_texture(capture, material.depth);
+	output.flags = material.flags;
+	output.depth_strength = material.depth_strength;
+	output.bump_strength = material.bump_strength;
+	output.specular = material.specular;
+	output.color = material.color;
+	output.emission = material.emission;
+
+	return output;
+}
+
+static void apply_settings(const AllRenderSettings &settings)
+{
+	auto *renderer = Engine::renderer;
+
+	renderer->set_texture_settings(settings.texture);
+	renderer->set_shadow_settings(settings.shadow);
+	renderer->set_screen_space_settings(settings.screen_space);
+	renderer->set_geometry_settings(settings.geometry);
+	renderer->set_pipeline_settings(settings.pipeline);
+}
+
+static int replay(const FrameCaptureFile &capture, uint64_t iterations)
+{
+	// meshes stored in the capture are owned here, meshes from model files by the asset manager
+	std::vector<Mesh> embedded;
+	std::vector<std::optional<MeshView>> meshes;
+
+	embedded.reserve(capture.meshes.size());
+	meshes.reserve(capture.meshes.size());
+
+	for (auto &captured : capture.meshes)
+	{
+		auto &mesh_opt = meshes.emplace_back();
+
+		if (captured.model_path.empty())
+		{
+			auto &mesh = embedded.emplace_back();
+
+			mesh.vertices = captured.vertices;
+			mesh.indices = captured.indices;
+			mesh.lods = captured.lods;
+
+			Engine::renderer->create_buffers(mesh);
+
+			mesh_opt.emplace(mesh);
+			continue;
+		}
+
+		auto model = Engine::asset_manager.get_model(captured.model_path);
+
+		if (!model || captured.mesh_index >= model->meshes.size())
+		{
+			Logger::warn("could not load mesh {} of {}, its draws are skipped", captured.mesh_index, captured.model_path);
+			continue;
+		}
+
+		mesh_opt.emplace(model->meshes[captured.mesh_index]);
+	}
+
+	// every draw gets a view with its own material, built before timing so only the renderer is measured
+	std::vector<std::vector<MeshView>> frame_draws(capture.frames.size());
+	size_t max_lights = 0;
+
+	for (size_t i = 0; i < capture.frames.size(); i++)
+	{
+		auto &frame = capture.frames[i];
+
+		frame_draws[i].reserve(frame.draws.size());
+		max_lights = std::max(max_lights, frame.lights.size());
+
+		for (auto &draw : frame.draws)
+		{
+			if (!meshes[draw.mesh])
+			{
+				continue;
+			}
+
+			auto &view = frame_draws[i].emplace_back(*meshes[draw.mesh]);
+
+			view.material = load_material(capture, draw.material);
+		}
+	}
+
+	// the light table holds pointers so the lights and their positions have to stay in place
+	std::vector<std::unique_ptr<Light>> lights;
+	std::vector<glm::vec3> light_positions(max_lights);
+
+	for (size_t i = 0; i < max_lights; i++)
+	{
+		auto &light = lights.emplace_back(std::make_unique<Light>());
+
+		light->position = &light_positions[i];
+		Light::table.push_back(light.get());
+	}
+
+	Camera camera;
+	std::vector<Timing> cpu_times(capture.frames.size());
+	Timing gpu_times;
+	const AllRenderSettings *applied = nullptr;
+
+	Engine::renderer->set_camera(&camera);
+
+	// the first pass renders every shadow map and uploads every texture, it is not counted
+	for (uint64_t iteration = 0; iteration <= iterations; iteration++)
+	{
+		for (size_t i = 0; i < capture.frames.size(); i++)
+		{
+			auto &frame = capture.frames[i];
+
+			if (!Engine::window.is_headless())
+			{
+				glfwPollEvents();
+			}
+
+			auto start = std::chrono::steady_clock::now();
+
+			if (applied == nullptr || std::memcmp(applied, &frame.settings, sizeof(AllRenderSettings)) != 0)
+			{
+				apply_settings(frame.settings);
+				applied = &frame.settings;
+			}
+
+			camera = frame.camera;
+
+			for (size_t j = 0; j < lights.size(); j++)
+			{
+				auto &light = *lights[j];
+
+				if (j >= frame.lights.size())
+				{
+					light.is_active = false;
+					continue;
+				}
+
+				auto &captured = frame.lights[j];
+
+				light_positions[j] = captured.position;
+				light.is_active = captured.is_active;
+				light.is_spot = captured.is_spot;
+				light.is_directional = captured.is_directional;
+				light.cast_shadows = captured.cast_shadows;
+				light.direction = captured.direction;
+				light.inner_cutoff = captured.inner_cutoff;
+				light.outer_cutoff = captured.outer_cutoff;
+				light.color = captured.color;
+				light.ambient = captured.ambient;
+				light.diffuse = captured.diffuse;
+				light.specular = captured.specular;
+				light.power = captured.power;
+				light.constant = captured.constant;
+				light.linear = captured.linear;
+				light.quadratic = captured.quadratic;
+			}
+
+			auto view = frame_draws[i].begin();
+
+			for (auto &draw : frame.draws)
+			{
+				if (meshes[draw.mesh])
+				{
+					Engine::renderer->draw(*view++, draw.model, draw.options);
+				}
+			}
+
+			Engine::renderer->new_frame();
+			Engine::renderer->end_frame();
+
+			auto cpu_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			Engine::window.swap_buffers();
+
+			if (iteration == 0)
+			{
+				continue;
+			}
+
+			cpu_times[i].add(cpu_ms);
+
+			// read a frame late, so it belongs to the frame before this one
+			auto gpu_ms = Engine::renderer->get_stats().gpu_frame_ms;
+
+			if (gpu_ms > 0)
+			{
+				gpu_times.add(gpu_ms);
+			}
+		}
+	}
+
+	Engine::renderer->wait();
+
+	Light::table.clear();
+
+	fmt::print("replayed {} frames {} times\n", capture.frames.size(), iterations);
+
+	for (size_t i = 0; i < capture.frames.size(); i++)
+	{
+		fmt::print("frame {}: {} draws, {} lights, cpu ms {}\n", i, capture.frames[i].draws.size(),
+			capture.frames[i].lights.size(), cpu_times[i].to_string());
+	}
+
+	fmt::print("gpu ms {}\n", gpu_times.to_string());
+
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2)
+	{
+		fmt::print("usage: {} <capture> [iterations] [--null]\n", argv[0]);
+		return 1;
+	}
+
+	auto capture = FrameCaptureFile::load(argv[1]);
+
+	if (!capture || capture->frames.empty())
+	{
+		fmt::print("could not load the capture {}, it may be broken or from a different version of the engine\n", argv[1]);
+		return 1;
+	}
+
+	uint64_t iterations = 100;
+	auto api = GraphicsApi::OpenGl;
+
+	for (int i = 2; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--null") == 0)
+		{
+			api = GraphicsApi::Null;
+		}
+		else
+		{
+			iterations = std::max(std::strtoull(argv[i], nullptr, 10), 1ull);
+		}
+	}
+
+	auto result = Engine::init(
+	{
+		.title = "playground engine replay",
+		.window_size = {capture->width, capture->height},
+		.graphics_api = api,
+	});
+
+	if (result != ErrorCode::Ok)
+	{
+		fmt::print("could not initialize the engine: {}\n", error_message(result));
+		return 1;
+	}
+
+	auto code = replay(*capture, iterations);
+
+	Engine::shutdown();
+
+	return code;
+}
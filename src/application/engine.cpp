@@ -1,12 +1,19 @@
 #include "engine.hpp"
 
+#include <chrono>
+
 #include "./time.hpp"
 #include "imgui_handler.hpp"
 #include "input.hpp"
 #include "../graphics/openGL/opengl_renderer.hpp"
+#include "../graphics/openGL/gl_program_cache.hpp"
+#include "../graphics/null/null_renderer.hpp"
+#include "../graphics/util.hpp"
 
 pge::ErrorCode pge::Engine::init(AppInfo info)
 {
+	m_init_time = program_time();
+
     window.set_graphics_api(info.graphics_api);
 	window.set_resizable(true);
 
@@ -17,7 +24,13 @@ pge::ErrorCode pge::Engine::init(AppInfo info)
         return ErrorCode::WindowCouldNotOpen;
     }
 
-    init_input();
+    // input comes from the window callbacks, a headless window has none
+    if (!window.is_headless())
+    {
+        init_input();
+    }
+
+    m_max_frames = info.max_frames;
 
     set_graphics_api(info.graphics_api);
 
@@ -53,9 +66,17 @@ pge::ErrorCode pge::Engine::run()
 
     entity_manager.start();
 
-    while (!window.should_close())
+    uint64_t frame = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    while (!window.should_close() && (m_max_frames == 0 || frame < m_max_frames))
     {
-        glfwPollEvents();
+        frame++;
+
+        if (!window.is_headless())
+        {
+            glfwPollEvents();
+        }
 
         statistics.calculate();
 
@@ -74,6 +95,8 @@ pge::ErrorCode pge::Engine::run()
 
         entity_manager.update(statistics.delta_time());
 
+        capture_frame();
+
         renderer->new_frame();
 
         renderer->end_frame();
@@ -83,9 +106,32 @@ pge::ErrorCode pge::Engine::run()
         reset_input();
 
         window.swap_buffers();
+
+		// most of the startup cost is compiling programs, the first frame also builds the variants it draws with
+		if (frame == 1)
+		{
+			Logger::info("first frame after {:.1f} ms", (program_time() - m_init_time) * 1000.0);
+
+			if (gl_program_cache.hits() + gl_program_cache.misses() > 0)
+			{
+				Logger::info("{} programs loaded from the binary cache, {} compiled",
+					gl_program_cache.hits(), gl_program_cache.misses());
+			}
+		}
     }
 
+	if (window.is_headless())
+	{
+		auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		Logger::info("ran {} frames in {:.1f} ms, {:.3f} ms per frame", frame, elapsed, elapsed / std::max(frame, uint64_t(1)));
+	}
+
+	stop_capture();
+
+	// the last reads are handed to the writer by the wait, everything has to be on disk before returning
 	renderer->wait();
+	image_writer.wait();
 
     return ErrorCode::Ok;
 }
@@ -114,5 +160,6 @@ void pge::Engine::set_graphics_api(GraphicsApi api)
     {
         //case Vulkan: m_graphics_manager = new VulkanManager(); break;
         case OpenGl: renderer = new OpenglRenderer(); break;
+        case Null: renderer = new NullRenderer(); break;
     }
 }
\ No newline at end of file
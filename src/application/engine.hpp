@@ -5,6 +5,7 @@
 #include "error.hpp"
 #include "statistics.hpp"
 #include "../graphics/renderer_interface.hpp"
+#include "../graphics/image_writer.hpp"
 #include "../graphics/vulkan/vulkan_manager.hpp"
 #include "window.hpp"
 #include "../data/asset_manager.hpp"
@@ -17,6 +18,8 @@ namespace pge
 		std::string_view title;
 		glm::ivec2		 window_size;
         GraphicsApi      graphics_api;
+		// run returns after this many frames, 0 keeps running until the window closes
+		uint64_t		 max_frames = 0;
 	};
 
 	class Engine
@@ -35,9 +38,14 @@ namespace pge
 		inline static Statistics	statistics;
 		inline static AssetManager	asset_manager;
 		inline static FsMonitor 	fs_monitor;
+		// saves screenshots and captured frames off the main thread
+		inline static ImageWriter	image_writer;
 		inline static float			time_scale = 1;
 	private:
 		inline static bool m_initialized = false;
+		inline static uint64_t m_max_frames = 0;
+		// program time when init started, the time to the first frame is measured from here
+		inline static double m_init_time = 0;
         static void set_graphics_api(GraphicsApi api);
 	};
 }
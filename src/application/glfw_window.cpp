@@ -67,6 +67,14 @@ pge::GlfwWindow::GlfwWindow()
 
 bool pge::GlfwWindow::open(std::string_view title, int width, int height)
 {
+    if (m_headless)
+    {
+        m_width = width;
+        m_height = height;
+
+        return true;
+    }
+
     if (!m_is_init)
     {
         glfwInit();
@@ -93,26 +101,51 @@ bool pge::GlfwWindow::open(std::string_view title, int width, int height)
 
 void pge::GlfwWindow::set_title(std::string_view title)
 {
+    if (m_window == nullptr)
+    {
+        return;
+    }
+
     glfwSetWindowTitle(m_window, title.data());
 }
 
 void pge::GlfwWindow::resize(int width, int height)
 {
+    if (m_window == nullptr)
+    {
+        return;
+    }
+
     glfwSetWindowSize(m_window, width, height);
 }
 
 void pge::GlfwWindow::change(int width, int height, int refresh_rate, int xpos, int ypos)
 {
+    if (m_window == nullptr)
+    {
+        return;
+    }
+
     glfwSetWindowMonitor(m_window, m_monitor, xpos, ypos, width, height, refresh_rate);
 }
 
 void pge::GlfwWindow::cap_refresh_rate(bool value)
 {
+    if (m_window == nullptr)
+    {
+        return;
+    }
+
     glfwSwapInterval(value);
 }
 
 void pge::GlfwWindow::set_fullscreen(bool value)
 {
+    if (m_window == nullptr)
+    {
+        return;
+    }
+
     auto mode = glfwGetVideoMode(glfwGetPrimaryMonitor());
 
     int xpos, ypos;
@@ -133,17 +166,33 @@ void pge::GlfwWindow::set_fullscreen(bool value)
 
 void pge::GlfwWindow::close()
 {
+    if (m_window == nullptr)
+    {
+        return;
+    }
+
     glfwDestroyWindow(m_window);
     m_window = nullptr;
 }
 
 bool pge::GlfwWindow::should_close()
 {
+    if (m_window == nullptr)
+    {
+        return m_should_close;
+    }
+
     return glfwWindowShouldClose(m_window);
 }
 
 void pge::GlfwWindow::set_should_close(bool value)
 {
+    if (m_window == nullptr)
+    {
+        m_should_close = value;
+        return;
+    }
+
     glfwSetWindowShouldClose(m_window, value);
 }
 
@@ -161,6 +210,11 @@ void* pge::GlfwWindow::handle()
 
 void pge::GlfwWindow::set_resizable(bool value)
 {
+    if (m_headless)
+    {
+        return;
+    }
+
     glfwWindowHint(GLFW_RESIZABLE, value);
 }
 
@@ -170,8 +224,14 @@ void pge::GlfwWindow::set_graphics_api(GraphicsApi api)
 
     using enum GraphicsApi;
 
+    m_headless = api == Null;
+
     switch (api)
     {
+        case Null:
+        {
+            break;
+        }
         case Vulkan:
         {
             glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
@@ -195,12 +255,22 @@ std::pair<uint32_t, uint32_t> pge::GlfwWindow::framebuffer_size()
 
 bool pge::GlfwWindow::is_key_held(Key key)
 {
+    if (m_window == nullptr)
+    {
+        return false;
+    }
+
     return glfwGetKey(m_window, (int)key) == GLFW_PRESS;
 }
 
 glm::dvec2 pge::GlfwWindow::mouse_xy()
 {
-    glm::dvec2 output;
+    glm::dvec2 output {0.0};
+
+    if (m_window == nullptr)
+    {
+        return output;
+    }
 
     glfwGetCursorPos(m_window, &output.x, &output.y);
 
@@ -209,11 +279,21 @@ glm::dvec2 pge::GlfwWindow::mouse_xy()
 
 void pge::GlfwWindow::set_cursor(CursorMode mode)
 {
+    if (m_window == nullptr)
+    {
+        return;
+    }
+
     glfwSetInputMode(m_window, GLFW_CURSOR, (int)mode);
 }
 
 void pge::GlfwWindow::set_raw_input(bool value)
 {
+    if (m_window == nullptr)
+    {
+        return;
+    }
+
     if (glfwRawMouseMotionSupported())
     {
         glfwSetInputMode(m_window, GLFW_RAW_MOUSE_MOTION, value);
@@ -227,6 +307,11 @@ bool pge::GlfwWindow::is_fullscreen() const
 
 void pge::GlfwWindow::swap_buffers()
 {
+    if (m_window == nullptr)
+    {
+        return;
+    }
+
     glfwSwapBuffers(m_window);
 }
 
@@ -45,6 +45,11 @@ namespace pge
 
         void set_graphics_api(GraphicsApi api) override;
 
+        bool is_headless() const override
+        {
+            return m_headless;
+        }
+
         std::pair<uint32_t, uint32_t> framebuffer_size() override;
 
         bool is_key_held(Key key) override;
@@ -61,10 +66,12 @@ namespace pge
 
     private:
         GLFWmonitor *m_monitor = nullptr;
-        GLFWwindow *m_window;
+        GLFWwindow *m_window = nullptr;
         int m_width;
         int m_height;
         bool m_is_init = false;
+        bool m_headless = false;
+        bool m_should_close = false;
 
         static void glfw_error_cb(int code, const char* description);
 
@@ -16,6 +16,24 @@ void pge::init_imgui(IWindow* window, GraphicsApi api)
     io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
     io.IniFilename = "pge_imgui.ini";
 
+    g_using_api = api;
+
+    // without a window imgui still runs so the ui code gets measured too, its output is thrown away
+    if (window->is_headless())
+    {
+        auto [width, height] = window->framebuffer_size();
+
+        io.DisplaySize = {(float)width, (float)height};
+        io.IniFilename = nullptr;
+
+        unsigned char *pixels;
+        int font_width, font_height;
+
+        io.Fonts->GetTexDataAsRGBA32(&pixels, &font_width, &font_height);
+
+        return;
+    }
+
 #if defined(PGE_IMGUI_USE_GLFW)
     ImGui_ImplGlfw_InitForOpenGL((GLFWwindow*)window->handle(), true);
 #endif
@@ -24,8 +42,6 @@ void pge::init_imgui(IWindow* window, GraphicsApi api)
     {
         ImGui_ImplOpenGL3_Init();
     }
-
-    g_using_api = api;
 }
 
 void pge::cleanup_imgui()
@@ -36,7 +52,10 @@ void pge::cleanup_imgui()
     }
 
 #if defined(PGE_IMGUI_USE_GLFW)
-    ImGui_ImplGlfw_Shutdown();
+    if (g_using_api != GraphicsApi::Null)
+    {
+        ImGui_ImplGlfw_Shutdown();
+    }
 #endif
 
     ImGui::DestroyContext();
@@ -50,9 +69,18 @@ void pge::imgui_new_frame()
     }
 
 #if defined(PGE_IMGUI_USE_GLFW)
-    ImGui_ImplGlfw_NewFrame();
+    if (g_using_api != GraphicsApi::Null)
+    {
+        ImGui_ImplGlfw_NewFrame();
+    }
 #endif
 
+    // the platform backend would set the frame time, imgui asserts on a zero delta
+    if (g_using_api == GraphicsApi::Null)
+    {
+        ImGui::GetIO().DeltaTime = 1.0f / 60.0f;
+    }
+
     ImGui::NewFrame();
 }
 
@@ -1,19 +1,15 @@
 #pragma once
 
-#include "../common_util/macros.hpp"
-
-#if defined(__linux__) || defined(__WIN32__)
-#include "GLFW/glfw3.h"
-#endif
+#include <chrono>
 
 namespace pge
 {
-    static double program_time()
+    // seconds since the first call. a steady clock instead of the window library timer so headless runs,
+    // which never initialize a window, still get real frame times
+    inline double program_time()
     {
-#if PGE_SUPPORTED_PLATFORM
-        return glfwGetTime();
-#else
-#error "a get time function has not been defined for this platform"
-#endif
+        static const auto start = std::chrono::steady_clock::now();
+
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
     }
 }
@@ -41,6 +41,10 @@ namespace pge
 
         virtual void set_graphics_api(GraphicsApi api) = 0;
 
+        // true when no window is opened because the graphics api does not need one,
+        // the window then only keeps its size and close flag
+        virtual bool is_headless() const = 0;
+
         virtual void swap_buffers() = 0;
 
         virtual std::pair<uint32_t, uint32_t> framebuffer_size() = 0;
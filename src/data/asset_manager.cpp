@@ -108,6 +108,29 @@ void pge::AssetManager::free_asset(std::string_view path)
     }
 }
 
+std::optional<pge::MeshSource> pge::AssetManager::find_mesh_source(uint32_t mesh_id) const
+{
+    for (auto &[path, data] : m_assets)
+    {
+        auto *model = std::get_if<Model>(&data.asset);
+
+        if (model == nullptr)
+        {
+            continue;
+        }
+
+        for (uint32_t i = 0; i < model->meshes.size(); i++)
+        {
+            if (model->meshes[i].id == mesh_id)
+            {
+                return MeshSource{path.string(), i};
+            }
+        }
+    }
+
+    return std::nullopt;
+}
+
 std::optional<pge::Model> pge::AssetManager::load_model(std::string_view path)
 {
     ModelLoader loader;
@@ -12,6 +12,13 @@ namespace pge
 {
     using Asset = std::variant<Model, Texture>;
 
+    // where a mesh created by the asset manager was loaded from
+    struct MeshSource
+    {
+        std::string model_path;
+        uint32_t mesh_index;
+    };
+
     class AssetManager
     {
         struct AssetData
@@ -30,6 +37,9 @@ namespace pge
 
         void free_asset(std::string_view path);
 
+        // looks through every loaded model, meant for tools rather than every frame
+        std::optional<MeshSource> find_mesh_source(uint32_t mesh_id) const;
+
     private:
         using AssetTable = std::unordered_map<std::filesystem::path, AssetData>;
         inline static uint32_t asset_id = 0;
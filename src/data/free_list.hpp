@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pge
+{
+	// first fit allocator for ranges inside a fixed size block, such as a region of a gpu buffer.
+	// it only keeps track of offsets, the memory itself is owned by the user
+	class FreeList
+	{
+	public:
+		static constexpr size_t INVALID = SIZE_MAX;
+
+		FreeList() = default;
+
+		explicit FreeList(size_t capacity)
+		{
+			reset(capacity);
+		}
+
+		// forgets every allocation and makes the whole block free
+		void reset(size_t capacity)
+		{
+			m_capacity = capacity;
+			m_blocks.clear();
+
+			if (capacity > 0)
+			{
+				m_blocks.push_back({0, capacity});
+			}
+		}
+
+		// returns the offset of the allocated range or INVALID if there is no free range large enough
+		size_t allocate(size_t size)
+		{
+			for (auto iter = m_blocks.begin(); iter != m_blocks.end(); ++iter)
+			{
+				if (iter->size < size)
+				{
+					continue;
+				}
+
+				auto offset = iter->offset;
+
+				iter->offset += size;
+				iter->size -= size;
+
+				if (iter->size == 0)
+				{
+					m_blocks.erase(iter);
+				}
+
+				return offset;
+			}
+
+			return INVALID;
+		}
+
+		// returns a range to the free list and merges it with its neighbours
+		void free(size_t offset, size_t size)
+		{
+			if (size == 0)
+			{
+				return;
+			}
+
+			auto iter = m_blocks.begin();
+
+			while (iter != m_blocks.end() && iter->offset < offset)
+			{
+				++iter;
+			}
+
+			iter = m_blocks.insert(iter, {offset, size});
+
+			auto next = iter + 1;
+
+			if (next != m_blocks.end() && iter->offset + iter->size == next->offset)
+			{
+				iter->size += next->size;
+				m_blocks.erase(next);
+			}
+
+			if (iter != m_blocks.begin())
+			{
+				auto previous = iter - 1;
+
+				if (previous->offset + previous->size == iter->offset)
+				{
+					previous->size += iter->size;
+					m_blocks.erase(iter);
+				}
+			}
+		}
+
+		[[nodiscard]]
+		size_t capacity() const
+		{
+			return m_capacity;
+		}
+
+		// the total amount of free space, which may be spread across several ranges
+		[[nodiscard]]
+		size_t free_space() const
+		{
+			size_t output = 0;
+
+			for (auto &block : m_blocks)
+			{
+				output += block.size;
+			}
+
+			return output;
+		}
+
+		// the amount of free ranges, more than one means the block is fragmented
+		[[nodiscard]]
+		size_t fragments() const
+		{
+			return m_blocks.size();
+		}
+
+	private:
+		struct Block
+		{
+			size_t offset;
+			size_t size;
+		};
+
+		size_t m_capacity = 0;
+		// free ranges sorted by offset
+		std::vector<Block> m_blocks;
+	};
+}
@@ -14,4 +14,13 @@ namespace pge
 			  class AllocatorOrContainer = std::allocator<std::pair<Key, T>>,
 			  class Bucket = ankerl::unordered_dense::bucket_type::standard>
     using HashMap = ankerl::unordered_dense::map<Key, T, Hash, KeyEqual, AllocatorOrContainer, Bucket>;
+
+	// mixes the raw bytes of value into seed. only use with types that have no padding
+	template<class T>
+	void hash_combine(uint64_t &seed, const T &value)
+	{
+		auto hash = ankerl::unordered_dense::detail::wyhash::hash(&value, sizeof(T));
+
+		seed = ankerl::unordered_dense::detail::wyhash::mix(seed ^ hash, UINT64_C(0x9E3779B97F4A7C15));
+	}
 }
\ No newline at end of file
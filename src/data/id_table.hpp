@@ -1,5 +1,6 @@
 #pragma once
 #include <atomic>
+#include <memory>
 #include <stack>
 #include <vector>
 
@@ -11,8 +12,19 @@ namespace pge
     public:
         size_t create(T &t)
         {
-            m_table.emplace_back(t);
-            return get_free();
+            if (m_free_list.empty())
+            {
+                m_table.emplace_back(t);
+                return m_table.size()-1;
+            }
+
+            auto id = m_free_list.top();
+
+            m_free_list.pop();
+
+            std::construct_at(&m_table[id], t);
+
+            return id;
         }
 
         bool valid_id(size_t id)
@@ -25,6 +37,13 @@ namespace pge
             return m_table[id];
         }
 
+        // the amount of slots including ones that have been removed
+        [[nodiscard]]
+        size_t size() const
+        {
+            return m_table.size();
+        }
+
         void remove(size_t id)
         {
             if (id >= m_table.size())
@@ -43,19 +62,5 @@ namespace pge
     private:
         std::vector<T> m_table;
         std::stack<size_t> m_free_list;
-
-        size_t get_free()
-        {
-            if (m_free_list.empty())
-            {
-                return m_table.size()-1;
-            }
-
-            auto id = m_free_list.top();
-
-            m_free_list.pop();
-
-            return id;
-        }
     };
-}
+}
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include "../common_util/macros.hpp"
 #include "../application/engine.hpp"
 #include "../common_util/os.hpp"
+#include "../graphics/mesh_simplify.hpp"
 #include <glm/gtc/type_ptr.hpp>
 
 // TODO replace assimp with custom model loader
@@ -27,6 +28,9 @@ std::optional<pge::Model> pge::ModelLoader::load(std::string_view path, int flag
 
 	m_path.remove_filename();
 
+	// simplifying is the slowest part of an import, models loaded while lods are off get none
+	m_generate_lods = Engine::renderer->get_geometry_settings().use_lods;
+
     Model model;
 
     model.transform = process_node(model, scene->mRootNode, scene);
@@ -122,13 +126,20 @@ std::vector<uint32_t> pge::ModelLoader::load_mesh_indices(aiMesh* mesh)
 
 pge::Mesh pge::ModelLoader::process_mesh(aiMesh* mesh, const aiScene* scene)
 {
-    return
+    Mesh output
 	{
 		.name 	  = mesh->mName.C_Str(),
 		.vertices = load_mesh_vertices(mesh),
 		.indices  = load_mesh_indices(mesh),
 		.material = load_mesh_material(mesh, scene),
 	};
+
+	if (m_generate_lods)
+	{
+		generate_lods(output);
+	}
+
+	return output;
 }
 
 pge::Material pge::ModelLoader::load_mesh_material(const aiMesh *mesh, const aiScene *scene)
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace pge
+{
+	// stable least significant digit radix sort over the 64 bit key returned by get_key.
+	// scratch is used as the second buffer so no memory is allocated once both vectors have grown to size
+	template<class T, class F>
+	void radix_sort(std::vector<T> &items, std::vector<T> &scratch, F get_key)
+	{
+		constexpr int DIGIT_BITS = 8;
+		constexpr int BUCKETS = 1 << DIGIT_BITS;
+		constexpr int PASSES = 64 / DIGIT_BITS;
+
+		if (items.size() < 2)
+		{
+			return;
+		}
+
+		std::array<std::array<uint32_t, BUCKETS>, PASSES> counts {};
+
+		// histograms for every digit are built in a single pass over the keys
+		for (const auto &item : items)
+		{
+			uint64_t key = get_key(item);
+
+			for (int pass = 0; pass < PASSES; pass++)
+			{
+				counts[pass][(key >> (pass * DIGIT_BITS)) & (BUCKETS - 1)]++;
+			}
+		}
+
+		scratch.resize(items.size());
+
+		auto *src = &items;
+		auto *dst = &scratch;
+
+		for (int pass = 0; pass < PASSES; pass++)
+		{
+			auto &count = counts[pass];
+
+			// every key has the same digit so this pass would not change the order
+			if (count[(get_key(items.front()) >> (pass * DIGIT_BITS)) & (BUCKETS - 1)] == items.size())
+			{
+				continue;
+			}
+
+			uint32_t offset = 0;
+
+			for (auto &bucket : count)
+			{
+				auto size = bucket;
+				bucket = offset;
+				offset += size;
+			}
+
+			for (const auto &item : *src)
+			{
+				auto digit = (get_key(item) >> (pass * DIGIT_BITS)) & (BUCKETS - 1);
+				(*dst)[count[digit]++] = item;
+			}
+
+			std::swap(src, dst);
+		}
+
+		if (src != &items)
+		{
+			items.swap(scratch);
+		}
+	}
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <glm/glm.hpp>
+
+#include "model.hpp"
+
+namespace pge
+{
+	struct Sphere
+	{
+		glm::vec3 center {};
+		float radius = 0;
+	};
+
+	// the six planes of a view frustum with their normals pointing inwards
+	struct Frustum
+	{
+		std::array<glm::vec4, 6> planes;
+	};
+
+	// extracts the frustum planes from a view projection matrix
+	static Frustum make_frustum(const glm::mat4 &vp)
+	{
+		auto row = [&vp](int i)
+		{
+			return glm::vec4{vp[0][i], vp[1][i], vp[2][i], vp[3][i]};
+		};
+
+		Frustum output
+		{
+			row(3) + row(0),
+			row(3) - row(0),
+			row(3) + row(1),
+			row(3) - row(1),
+			row(3) + row(2),
+			row(3) - row(2),
+		};
+
+		for (auto &plane : output.planes)
+		{
+			plane /= glm::length(glm::vec3(plane));
+		}
+
+		return output;
+	}
+
+	// transforms the bounds of a mesh into a world space bounding sphere
+	static Sphere transform_sphere(const Bounds &bounds, const glm::mat4 &model)
+	{
+		auto scale = glm::max(glm::length(glm::vec3(model[0])),
+			glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+
+		return
+		{
+			.center = glm::vec3(model * glm::vec4(bounds.center(), 1.0f)),
+			.radius = bounds.radius() * scale,
+		};
+	}
+
+	static bool intersects(const Sphere &a, const Sphere &b)
+	{
+		auto distance = a.center - b.center;
+		auto radius = a.radius + b.radius;
+
+		return glm::dot(distance, distance) <= radius * radius;
+	}
+
+	static bool intersects(const Frustum &frustum, const Sphere &sphere)
+	{
+		for (const auto &plane : frustum.planes)
+		{
+			if (glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
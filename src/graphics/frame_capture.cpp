@@ -0,0 +1,445 @@
+#include "frame_capture.hpp"
+
+#include <cstdio>
+#include <memory>
+#include <type_traits>
+
+#include "light.hpp"
+#include "../application/engine.hpp"
+
+// PGEF in little endian
+#define CAPTURE_MAGIC 0x46454750u
+// bump whenever one of the captured structs changes
+#define CAPTURE_VERSION 5u
+
+namespace
+{
+	class Writer
+	{
+	public:
+		explicit Writer(FILE *file) :
+			m_file(file)
+		{}
+
+		template<class T> requires std::is_trivially_copyable_v<T>
+		void write(const T &value)
+		{
+			m_ok &= fwrite(&value, sizeof(T), 1, m_file) == 1;
+		}
+
+		template<class T> requires std::is_trivially_copyable_v<T>
+		void write(const std::vector<T> &values)
+		{
+			write((uint64_t)values.size());
+
+			if (!values.empty())
+			{
+				m_ok &= fwrite(values.data(), sizeof(T), values.size(), m_file) == values.size();
+			}
+		}
+
+		void write(const std::string &value)
+		{
+			write((uint64_t)value.size());
+			m_ok &= fwrite(value.data(), 1, value.size(), m_file) == value.size();
+		}
+
+		[[nodiscard]]
+		bool ok() const
+		{
+			return m_ok;
+		}
+
+	private:
+		FILE *m_file;
+		bool m_ok = true;
+	};
+
+	class Reader
+	{
+	public:
+		explicit Reader(FILE *file) :
+			m_file(file)
+		{}
+
+		template<class T> requires std::is_trivially_copyable_v<T>
+		void read(T &value)
+		{
+			m_ok &= fread(&value, sizeof(T), 1, m_file) == 1;
+		}
+
+		template<class T> requires std::is_trivially_copyable_v<T>
+		void read(std::vector<T> &values)
+		{
+			values.resize(read_size(sizeof(T)));
+
+			if (!values.empty())
+			{
+				m_ok &= fread(values.data(), sizeof(T), values.size(), m_file) == values.size();
+			}
+		}
+
+		void read(std::string &value)
+		{
+			value.resize(read_size(1));
+			m_ok &= fread(value.data(), 1, value.size(), m_file) == value.size();
+		}
+
+		[[nodiscard]]
+		bool ok() const
+		{
+			return m_ok;
+		}
+
+	private:
+		FILE *m_file;
+		bool m_ok = true;
+
+		// a broken file must not make the reader allocate more than the file can hold
+		size_t read_size(size_t element_size)
+		{
+			uint64_t size = 0;
+
+			read(size);
+
+			auto position = ftell(m_file);
+
+			fseek(m_file, 0, SEEK_END);
+			auto remaining = uint64_t(ftell(m_file) - position);
+			fseek(m_file, position, SEEK_SET);
+
+			if (!m_ok || size > remaining / element_size)
+			{
+				m_ok = false;
+				return 0;
+			}
+
+			return size;
+		}
+	};
+
+	std::unique_ptr<pge::FrameRecorder> recorder;
+}
+
+bool pge::FrameCaptureFile::save(std::string_view path) const
+{
+	auto *file = fopen(std::string(path).c_str(), "wb");
+
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	Writer writer(file);
+
+	writer.write(CAPTURE_MAGIC);
+	writer.write(CAPTURE_VERSION);
+	// the settings and cameras are stored as they are in memory so their layout has to match when loading
+	writer.write((uint32_t)sizeof(AllRenderSettings));
+	writer.write((uint32_t)sizeof(Camera));
+	writer.write(width);
+	writer.write(height);
+
+	writer.write((uint64_t)textures.size());
+
+	for (auto &texture : textures)
+	{
+		writer.write(texture);
+	}
+
+	writer.write((uint64_t)meshes.size());
+
+	for (auto &mesh : meshes)
+	{
+		writer.write(mesh.model_path);
+		writer.write(mesh.mesh_index);
+		writer.write(mesh.vertices);
+		writer.write(mesh.indices);
+		writer.write((uint64_t)mesh.lods.size());
+
+		for (auto &lod : mesh.lods)
+		{
+			writer.write(lod.error);
+			writer.write(lod.indices);
+		}
+	}
+
+	writer.write((uint64_t)frames.size());
+
+	for (auto &frame : frames)
+	{
+		writer.write(frame.camera);
+		writer.write(frame.settings);
+		writer.write(frame.lights);
+		writer.write(frame.draws);
+	}
+
+	auto ok = writer.ok();
+
+	fclose(file);
+
+	return ok;
+}
+
+std::optional<pge::FrameCaptureFile> pge::FrameCaptureFile::load(std::string_view path)
+{
+	auto *file = fopen(std::string(path).c_str(), "rb");
+
+	if (file == nullptr)
+	{
+		return std::nullopt;
+	}
+
+	Reader reader(file);
+	FrameCaptureFile output;
+
+	uint32_t magic = 0, version = 0, settings_size = 0, camera_size = 0;
+
+	reader.read(magic);
+	reader.read(version);
+	reader.read(settings_size);
+	reader.read(camera_size);
+
+	if (!reader.ok() || magic != CAPTURE_MAGIC || version != CAPTURE_VERSION
+		|| settings_size != sizeof(AllRenderSettings) || camera_size != sizeof(Camera))
+	{
+		fclose(file);
+		return std::nullopt;
+	}
+
+	reader.read(output.width);
+	reader.read(output.height);
+
+	uint64_t count = 0;
+
+	reader.read(count);
+
+	for (uint64_t i = 0; i < count && reader.ok(); i++)
+	{
+		reader.read(output.textures.emplace_back());
+	}
+
+	count = 0;
+	reader.read(count);
+
+	for (uint64_t i = 0; i < count && reader.ok(); i++)
+	{
+		auto &mesh = output.meshes.emplace_back();
+
+		reader.read(mesh.model_path);
+		reader.read(mesh.mesh_index);
+		reader.read(mesh.vertices);
+		reader.read(mesh.indices);
+
+		uint64_t lod_count = 0;
+
+		reader.read(lod_count);
+
+		for (uint64_t j = 0; j < lod_count && j < MAX_MESH_LODS && reader.ok(); j++)
+		{
+			auto &lod = mesh.lods.emplace_back();
+
+			reader.read(lod.error);
+			reader.read(lod.indices);
+		}
+	}
+
+	count = 0;
+	reader.read(count);
+
+	for (uint64_t i = 0; i < count && reader.ok(); i++)
+	{
+		auto &frame = output.frames.emplace_back();
+
+		reader.read(frame.camera);
+		reader.read(frame.settings);
+		reader.read(frame.lights);
+		reader.read(frame.draws);
+	}
+
+	auto ok = reader.ok();
+
+	fclose(file);
+
+	if (!ok)
+	{
+		return std::nullopt;
+	}
+
+	// the replay indexes the meshes and textures with the values of the draws as they are
+	auto valid_texture = [&](const CapturedTexture &texture)
+	{
+		return texture.index == UINT32_MAX || texture.index < output.textures.size();
+	};
+
+	for (auto &frame : output.frames)
+	{
+		for (auto &draw : frame.draws)
+		{
+			auto &material = draw.material;
+
+			if (draw.mesh >= output.meshes.size() || !valid_texture(material.diffuse)
+				|| !valid_texture(material.bump) || !valid_texture(material.depth))
+			{
+				return std::nullopt;
+			}
+		}
+	}
+
+	return output;
+}
+
+pge::FrameRecorder::FrameRecorder(std::string path, uint32_t frame_count) :
+	m_path(std::move(path)),
+	m_frame_count(frame_count)
+{
+	auto [width, height] = Engine::window.framebuffer_size();
+
+	m_file.width = width;
+	m_file.height = height;
+}
+
+void pge::FrameRecorder::record(std::span<const DrawData> draws, const Camera &camera,
+	const AllRenderSettings &settings)
+{
+	if (done())
+	{
+		return;
+	}
+
+	auto &frame = m_file.frames.emplace_back();
+
+	frame.camera = camera;
+	frame.settings = settings;
+
+	for (auto *light : Light::table)
+	{
+		if (light == nullptr || light->position == nullptr)
+		{
+			continue;
+		}
+
+		frame.lights.push_back(
+		{
+			.position = *light->position,
+			.is_active = light->is_active,
+			.is_spot = light->is_spot,
+			.is_directional = light->is_directional,
+			.cast_shadows = light->cast_shadows,
+			.direction = light->direction,
+			.inner_cutoff = light->inner_cutoff,
+			.outer_cutoff = light->outer_cutoff,
+			.color = light->color,
+			.ambient = light->ambient,
+			.diffuse = light->diffuse,
+			.specular = light->specular,
+			.power = light->power,
+			.constant = light->constant,
+			.linear = light->linear,
+			.quadratic = light->quadratic,
+		});
+	}
+
+	frame.draws.reserve(draws.size());
+
+	for (auto &[mesh, model, options] : draws)
+	{
+		auto &material = mesh.material;
+
+		frame.draws.push_back(
+		{
+			.mesh = add_mesh(mesh),
+			.model = model,
+			.material =
+			{
+				.shininess = material.shininess,
+				.alpha = material.alpha,
+				.diffuse = add_texture(material.diffuse),
+				.bump = add_texture(material.bump),
+				.depth = add_texture(material.depth),
+				.flags = material.flags,
+				.depth_strength = material.depth_strength,
+				.bump_strength = material.bump_strength,
+				.specular = material.specular,
+				.color = material.color,
+				.emission = material.emission,
+			},
+			.options = options,
+		});
+	}
+
+	if (!done())
+	{
+		return;
+	}
+
+	if (m_file.save(m_path))
+	{
+		Logger::info("captured {} frames to {}", m_file.frames.size(), m_path);
+	}
+	else
+	{
+		Logger::warn("could not write the frame capture {}", m_path);
+	}
+}
+
+uint32_t pge::FrameRecorder::add_mesh(const MeshView &mesh)
+{
+	auto [iter, inserted] = m_meshes.try_emplace(mesh.id, (uint32_t)m_file.meshes.size());
+
+	if (!inserted)
+	{
+		return iter->second;
+	}
+
+	auto &captured = m_file.meshes.emplace_back();
+	auto source = Engine::asset_manager.find_mesh_source(mesh.id);
+
+	if (source)
+	{
+		captured.model_path = source->model_path;
+		captured.mesh_index = source->mesh_index;
+	}
+	else
+	{
+		captured.vertices.assign(mesh.vertices.begin(), mesh.vertices.end());
+		captured.indices.assign(mesh.indices.begin(), mesh.indices.end());
+		captured.lods.assign(mesh.lods.begin(), mesh.lods.end());
+	}
+
+	return iter->second;
+}
+
+pge::CapturedTexture pge::FrameRecorder::add_texture(const Texture &texture)
+{
+	CapturedTexture output {UINT32_MAX, texture.scale};
+
+	// textures created from memory have no file the replay could load them from
+	if (!texture.enabled || texture.path.empty())
+	{
+		return output;
+	}
+
+	auto [iter, inserted] = m_textures.try_emplace(texture.id, (uint32_t)m_file.textures.size());
+
+	if (inserted)
+	{
+		m_file.textures.emplace_back(texture.path);
+	}
+
+	output.index = iter->second;
+
+	return output;
+}
+
+void pge::capture_frames(std::string_view path, uint32_t frame_count)
+{
+	recorder = std::make_unique<FrameRecorder>(std::string(path), frame_count);
+
+	Engine::renderer->set_frame_recorder(recorder.get());
+}
+
+bool pge::is_capturing_frames()
+{
+	return recorder != nullptr && !recorder->done();
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Camera.hpp"
+#include "model.hpp"
+#include "renderer_structs.hpp"
+#include "../data/hash_table.hpp"
+
+namespace pge
+{
+	// a mesh a captured draw uses. meshes loaded from a model file are referenced by the file and
+	// their index in it, every other mesh is stored with its geometry
+	struct CapturedMesh
+	{
+		std::string model_path;
+		uint32_t mesh_index = 0;
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		std::vector<MeshLod> lods;
+	};
+
+	struct CapturedTexture
+	{
+		// index into the texture paths of the capture, UINT32_MAX if the texture is disabled or was not loaded from a file
+		uint32_t index = UINT32_MAX;
+		float scale = 1;
+	};
+
+	// the material of a draw with its textures turned into paths
+	struct CapturedMaterial
+	{
+		float shininess;
+		float alpha;
+		CapturedTexture diffuse;
+		CapturedTexture bump;
+		CapturedTexture depth;
+		uint32_t flags;
+		float depth_strength;
+		float bump_strength;
+		float specular;
+		glm::vec3 color;
+		float emission;
+	};
+
+	struct CapturedDraw
+	{
+		uint32_t mesh;
+		glm::mat4 model;
+		CapturedMaterial material;
+		DrawOptions options;
+	};
+
+	// the values of a light without its shadow map
+	struct CapturedLight
+	{
+		glm::vec3 position;
+		bool is_active;
+		bool is_spot;
+		bool is_directional;
+		bool cast_shadows;
+		glm::vec3 direction;
+		float inner_cutoff;
+		float outer_cutoff;
+		glm::vec3 color;
+		float ambient;
+		float diffuse;
+		float specular;
+		float power;
+		float constant;
+		float linear;
+		float quadratic;
+	};
+
+	struct CapturedFrame
+	{
+		Camera camera;
+		AllRenderSettings settings;
+		std::vector<CapturedLight> lights;
+		std::vector<CapturedDraw> draws;
+	};
+
+	// everything the renderer was given during a few frames, enough to render them again without the game
+	struct FrameCaptureFile
+	{
+		int width = 0;
+		int height = 0;
+		std::vector<std::string> textures;
+		std::vector<CapturedMesh> meshes;
+		std::vector<CapturedFrame> frames;
+
+		bool save(std::string_view path) const;
+
+		// fails on files written by a different version of the engine since settings are stored as they are in memory,
+		// and on draws referencing meshes or textures the file does not have
+		static std::optional<FrameCaptureFile> load(std::string_view path);
+	};
+
+	// collects the frames handed to it by the renderer and writes them once enough were recorded
+	class FrameRecorder
+	{
+	public:
+		FrameRecorder(std::string path, uint32_t frame_count);
+
+		// called by the renderer at the end of every frame with every draw queued in it
+		void record(std::span<const DrawData> draws, const Camera &camera, const AllRenderSettings &settings);
+
+		[[nodiscard]]
+		bool done() const
+		{
+			return m_file.frames.size() >= m_frame_count;
+		}
+
+	private:
+		std::string m_path;
+		uint32_t m_frame_count;
+		FrameCaptureFile m_file;
+		// renderer mesh ids and texture ids to their index in the file
+		HashMap<uint32_t, uint32_t> m_meshes;
+		HashMap<uint32_t, uint32_t> m_textures;
+
+		uint32_t add_mesh(const MeshView &mesh);
+		CapturedTexture add_texture(const Texture &texture);
+	};
+
+	// records the next frame_count frames into a capture file at path, the file is written after the last one
+	void capture_frames(std::string_view path, uint32_t frame_count = 1);
+
+	[[nodiscard]]
+	bool is_capturing_frames();
+}
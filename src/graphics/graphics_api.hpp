@@ -9,6 +9,8 @@ namespace pge
     {
         OpenGl,
         Vulkan,
+        // records the renderer calls without drawing anything, runs without a window or gpu
+        Null,
     };
 
     static bool is_implemented(GraphicsApi api)
@@ -19,6 +21,7 @@ namespace pge
         {
             case Vulkan: return false;
             case OpenGl: return true;
+            case Null: return true;
             default: return false;
         }
     }
@@ -31,6 +34,7 @@ namespace pge
         {
             case Vulkan: return "Vulkan";
             case OpenGl: return "OpenGL";
+            case Null: return "Null";
             default: return "Unknown";
         }
     }
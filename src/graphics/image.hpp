@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -22,12 +23,12 @@ namespace pge
     // image container for png, jpg, and bmp
     struct Image
     {
-        int width;
-        int height;
-        int channels;
-        ImgFmt format;
+        int width = 0;
+        int height = 0;
+        int channels = 0;
+        ImgFmt format = ImgFmt::Png;
         // image quality only relevent to jpg
-        int quality;
+        int quality = 90;
         std::vector<uint8_t> data;
 
         [[nodiscard]]
@@ -39,5 +40,8 @@ namespace pge
         void save(std::string_view path, bool add_ext = true);
     };
 
+    // receives an image that was read back from the gpu
+    using ImageCallback = std::function<void(Image)>;
+
 
 }
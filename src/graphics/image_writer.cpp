@@ -0,0 +1,87 @@
+#include "image_writer.hpp"
+
+pge::ImageWriter::~ImageWriter()
+{
+	{
+		std::lock_guard lock(m_mutex);
+		m_stop = true;
+	}
+
+	m_wake.notify_one();
+
+	if (m_thread.joinable())
+	{
+		m_thread.join();
+	}
+}
+
+void pge::ImageWriter::save(Image image, std::string path)
+{
+	{
+		std::lock_guard lock(m_mutex);
+
+		m_jobs.push_back({std::move(image), std::move(path)});
+
+		// the thread is only started once something is saved
+		if (!m_thread.joinable())
+		{
+			m_thread = std::thread(&ImageWriter::run, this);
+		}
+	}
+
+	m_wake.notify_one();
+}
+
+size_t pge::ImageWriter::pending() const
+{
+	std::lock_guard lock(m_mutex);
+
+	return m_jobs.size() + m_busy;
+}
+
+void pge::ImageWriter::wait()
+{
+	std::unique_lock lock(m_mutex);
+
+	m_idle.wait(lock, [this]
+	{
+		return m_jobs.empty() && !m_busy;
+	});
+}
+
+void pge::ImageWriter::run()
+{
+	std::unique_lock lock(m_mutex);
+
+	while (true)
+	{
+		m_wake.wait(lock, [this]
+		{
+			return m_stop || !m_jobs.empty();
+		});
+
+		// the queue is drained before stopping so no image is lost on shutdown
+		if (m_jobs.empty())
+		{
+			return;
+		}
+
+		auto job = std::move(m_jobs.front());
+
+		m_jobs.pop_front();
+		m_busy = true;
+
+		lock.unlock();
+
+		job.image.save(job.path);
+
+		lock.lock();
+
+		m_busy = false;
+
+		if (m_jobs.empty())
+		{
+			m_idle.notify_all();
+		}
+	}
+}
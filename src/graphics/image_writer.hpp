@@ -0,0 +1,53 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "image.hpp"
+
+namespace pge
+{
+	// encodes and writes images on a worker thread so saving never holds up a frame.
+	// images are written in the order they were queued
+	class ImageWriter
+	{
+	public:
+		ImageWriter() = default;
+
+		// writes every image still queued before returning
+		~ImageWriter();
+
+		ImageWriter(const ImageWriter&) = delete;
+		ImageWriter& operator=(const ImageWriter&) = delete;
+
+		// queues the image to be saved at path, the extension of the image format gets added
+		void save(Image image, std::string path);
+
+		// images queued or being written
+		[[nodiscard]]
+		size_t pending() const;
+
+		// blocks until every queued image is written
+		void wait();
+
+	private:
+		struct Job
+		{
+			Image image;
+			std::string path;
+		};
+
+		std::thread m_thread;
+		mutable std::mutex m_mutex;
+		std::condition_variable m_wake;
+		std::condition_variable m_idle;
+		std::deque<Job> m_jobs;
+		bool m_busy = false;
+		bool m_stop = false;
+
+		void run();
+	};
+}
@@ -1,19 +1,21 @@
 #pragma once
-#include <glm/vec3.hpp>
+#include <limits>
+#include <list>
+#include <glm/glm.hpp>
 
 namespace pge
 {
     struct Light
     {
-		~Light()
-		{
-			delete shadow_map;
-		}
-
         bool is_active = true;
         glm::vec3 *position = nullptr;
 
         bool is_spot = false;
+        // lights the whole scene from one direction like the sun, the position and attenuation are ignored.
+        // the first directional light that casts shadows gets cascaded shadow maps
+        bool is_directional = false;
+        // where a spot or directional light points. left at zero a spot light follows the camera
+        // and a directional light points straight down
         glm::vec3 direction {};
         float inner_cutoff = glm::cos(glm::radians(12.5f));
         float outer_cutoff = glm::cos(glm::radians(14.f));
@@ -28,9 +30,35 @@ namespace pge
         float linear    = 0.09f;
         float quadratic = 0.032f;
 
-		// the texture id internally to be used for shadow maps, this is very temporary until i rework the lighting system
-		int texture_id = 0;
-		IFramebuffer *shadow_map = nullptr;
+		// the shadow atlas is shared by every light, the ones covering the least of the screen
+		// get smaller tiles or none when it is full
+		bool cast_shadows = true;
+
+		// hash of the light position and every shadow caster in range the last time the shadow map was rendered
+		uint64_t shadow_hash = 0;
+		// forces the shadow map to be rendered again on the next frame
+		bool shadow_dirty = true;
+
+		// the distance where the light contributes less than 1/256 of its intensity, past it the light is ignored
+		[[nodiscard]]
+		float range() const
+		{
+			auto intensity = power * glm::max(diffuse, ambient) * glm::max(color.r, glm::max(color.g, color.b));
+			// solves constant + linear * d + quadratic * d^2 = 256 * intensity
+			auto c = constant - 256.0f * intensity;
+
+			if (c >= 0)
+			{
+				return 0;
+			}
+
+			if (quadratic <= 0)
+			{
+				return linear > 0 ? -c / linear : std::numeric_limits<float>::max();
+			}
+
+			return (-linear + glm::sqrt(linear * linear - 4.0f * quadratic * c)) / (2.0f * quadratic);
+		}
 
         using LightTable = std::list<Light*>;
         inline static LightTable table;
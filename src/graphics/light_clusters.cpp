@@ -0,0 +1,146 @@
+#include "light_clusters.hpp"
+
+#include <cmath>
+#include <limits>
+
+void pge::LightClusters::build(std::span<const Sphere> lights, const glm::mat4 &view, const glm::mat4 &projection,
+	float near, float far)
+{
+	slice_scale = SLICES / std::log(far / near);
+	slice_bias = -std::log(near) * slice_scale;
+
+	clusters.assign(COUNT, glm::uvec2{0});
+	indices.clear();
+	m_ranges.resize(lights.size());
+
+	// count the lights of every cluster first so the indices can be stored in one tightly packed list
+	for (size_t i = 0; i < lights.size(); i++)
+	{
+		auto &range = m_ranges[i];
+
+		if (!find_range(lights[i], view, projection, near, far, range))
+		{
+			range.min = glm::uvec3{1};
+			range.max = glm::uvec3{0};
+			continue;
+		}
+
+		for (auto z = range.min.z; z <= range.max.z; z++)
+		{
+			for (auto y = range.min.y; y <= range.max.y; y++)
+			{
+				for (auto x = range.min.x; x <= range.max.x; x++)
+				{
+					clusters[x + TILES_X * (y + TILES_Y * z)].y++;
+				}
+			}
+		}
+	}
+
+	uint32_t offset = 0;
+
+	for (auto &cluster : clusters)
+	{
+		cluster.x = offset;
+		offset += cluster.y;
+	}
+
+	indices.resize(offset);
+	m_heads.resize(COUNT);
+
+	for (size_t i = 0; i < COUNT; i++)
+	{
+		m_heads[i] = clusters[i].x;
+	}
+
+	for (size_t i = 0; i < lights.size(); i++)
+	{
+		auto &range = m_ranges[i];
+
+		for (auto z = range.min.z; z <= range.max.z; z++)
+		{
+			for (auto y = range.min.y; y <= range.max.y; y++)
+			{
+				for (auto x = range.min.x; x <= range.max.x; x++)
+				{
+					indices[m_heads[x + TILES_X * (y + TILES_Y * z)]++] = i;
+				}
+			}
+		}
+	}
+}
+
+bool pge::LightClusters::find_range(const Sphere &light, const glm::mat4 &view, const glm::mat4 &projection,
+	float near, float far, LightRange &out) const
+{
+	auto center = glm::vec3(view * glm::vec4(light.center, 1.0f));
+
+	// the camera looks down negative z
+	auto min_depth = -center.z - light.radius;
+	auto max_depth = -center.z + light.radius;
+
+	if (max_depth < near || min_depth > far)
+	{
+		return false;
+	}
+
+	auto slice = [this](float depth)
+	{
+		auto value = std::floor(std::log(depth) * slice_scale + slice_bias);
+
+		return (uint32_t)glm::clamp(value, 0.0f, float(SLICES - 1));
+	};
+
+	out.min.z = slice(glm::max(min_depth, near));
+	out.max.z = slice(glm::min(max_depth, far));
+
+	// a sphere that crosses the near plane can cover any part of the screen
+	if (min_depth <= near)
+	{
+		out.min.x = 0;
+		out.min.y = 0;
+		out.max.x = TILES_X - 1;
+		out.max.y = TILES_Y - 1;
+
+		return true;
+	}
+
+	// the screen rectangle of the view space bounding box is a conservative bound of the sphere
+	glm::vec2 screen_min {std::numeric_limits<float>::max()};
+	glm::vec2 screen_max {-std::numeric_limits<float>::max()};
+
+	for (int i = 0; i < 8; i++)
+	{
+		auto corner = center + glm::vec3
+		{
+			i & 1 ? light.radius : -light.radius,
+			i & 2 ? light.radius : -light.radius,
+			i & 4 ? light.radius : -light.radius,
+		};
+
+		auto clip = projection * glm::vec4(corner, 1.0f);
+		auto ndc = glm::vec2(clip) / clip.w;
+
+		screen_min = glm::min(screen_min, ndc);
+		screen_max = glm::max(screen_max, ndc);
+	}
+
+	if (screen_max.x < -1.0f || screen_max.y < -1.0f || screen_min.x > 1.0f || screen_min.y > 1.0f)
+	{
+		return false;
+	}
+
+	auto tile = [](float ndc, uint32_t tiles)
+	{
+		auto value = std::floor((ndc * 0.5f + 0.5f) * tiles);
+
+		return (uint32_t)glm::clamp(value, 0.0f, float(tiles - 1));
+	};
+
+	out.min.x = tile(screen_min.x, TILES_X);
+	out.min.y = tile(screen_min.y, TILES_Y);
+	out.max.x = tile(screen_max.x, TILES_X);
+	out.max.y = tile(screen_max.y, TILES_Y);
+
+	return true;
+}
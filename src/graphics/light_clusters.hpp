@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "culling.hpp"
+
+namespace pge
+{
+	// bins lights into a grid of screen tiles split into exponential depth slices (froxels)
+	// so a fragment only has to look at the lights that can reach its cluster
+	class LightClusters
+	{
+	public:
+		static constexpr uint32_t TILES_X = 16;
+		static constexpr uint32_t TILES_Y = 9;
+		static constexpr uint32_t SLICES = 24;
+		static constexpr uint32_t COUNT = TILES_X * TILES_Y * SLICES;
+
+		// assigns the world space light spheres to the clusters of the camera.
+		// the index of a light in the lists is its index in lights
+		void build(std::span<const Sphere> lights, const glm::mat4 &view, const glm::mat4 &projection,
+			float near, float far);
+
+		// offset into indices and light count for every cluster, x fastest then y then the slice
+		std::vector<glm::uvec2> clusters;
+		std::vector<uint32_t> indices;
+
+		// scale and bias that turn the log of the view depth into a slice
+		float slice_scale = 0;
+		float slice_bias = 0;
+
+	private:
+		// the inclusive cluster range touched by each light
+		struct LightRange
+		{
+			glm::uvec3 min;
+			glm::uvec3 max;
+		};
+
+		std::vector<LightRange> m_ranges;
+		// the next free slot of every cluster while the indices are written
+		std::vector<uint32_t> m_heads;
+
+		// returns false if the light does not touch the clusters at all
+		bool find_range(const Sphere &light, const glm::mat4 &view, const glm::mat4 &projection, float near,
+			float far, LightRange &out) const;
+	};
+}
@@ -0,0 +1,434 @@
+#include "mesh_simplify.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "../data/hash_table.hpp"
+
+// meshes with fewer triangles than this are cheap enough to always draw in full
+#define MIN_LOD_TRIANGLES 64
+
+namespace
+{
+	// the sum of squared distances to a set of planes, weighted by the area of the triangle each plane came from
+	struct Quadric
+	{
+		double xx = 0, xy = 0, xz = 0, yy = 0, yz = 0, zz = 0;
+		double x = 0, y = 0, z = 0;
+		double w = 0;
+		double area = 0;
+
+		Quadric& operator+=(const Quadric &other)
+		{
+			xx += other.xx; xy += other.xy; xz += other.xz;
+			yy += other.yy; yz += other.yz; zz += other.zz;
+			x += other.x; y += other.y; z += other.z;
+			w += other.w;
+			area += other.area;
+
+			return *this;
+		}
+
+		// the mean squared distance of the point to the planes
+		[[nodiscard]]
+		double error(glm::dvec3 p) const
+		{
+			if (area <= 0)
+			{
+				return 0;
+			}
+
+			auto value = xx * p.x * p.x + yy * p.y * p.y + zz * p.z * p.z
+				+ 2 * (xy * p.x * p.y + xz * p.x * p.z + yz * p.y * p.z)
+				+ 2 * (x * p.x + y * p.y + z * p.z) + w;
+
+			return std::max(value, 0.0) / area;
+		}
+	};
+
+	Quadric make_quadric(glm::dvec3 normal, double distance, double area)
+	{
+		auto &n = normal;
+
+		return
+		{
+			n.x * n.x * area, n.x * n.y * area, n.x * n.z * area,
+			n.y * n.y * area, n.y * n.z * area, n.z * n.z * area,
+			n.x * distance * area, n.y * distance * area, n.z * distance * area,
+			distance * distance * area,
+			area,
+		};
+	}
+
+	struct PositionHash
+	{
+		using is_avalanching = void;
+
+		uint64_t operator()(const glm::vec3 &position) const
+		{
+			return ankerl::unordered_dense::detail::wyhash::hash(&position, sizeof(position));
+		}
+	};
+
+	struct Collapse
+	{
+		double cost;
+		// the welded vertex that is removed and the one it moves onto
+		uint32_t from;
+		uint32_t to;
+	};
+}
+
+std::vector<uint32_t> pge::simplify_mesh(std::span<const Vertex> vertices, std::span<const uint32_t> indices,
+	size_t target_index_count, float &out_error)
+{
+	out_error = 0;
+
+	std::vector<uint32_t> output(indices.begin(), indices.end());
+
+	// vertices that share a position are welded so seams do not look like open borders.
+	// every vertex points to the first vertex at its position and the vertices of a position form a ring
+	std::vector<uint32_t> weld(vertices.size());
+	std::vector<uint32_t> wedges(vertices.size());
+
+	{
+		HashMap<glm::vec3, uint32_t, PositionHash> positions;
+
+		positions.reserve(vertices.size());
+
+		for (uint32_t i = 0; i < vertices.size(); i++)
+		{
+			// adding zero turns -0 into 0 so both hash the same
+			auto [iter, inserted] = positions.try_emplace(vertices[i].position + 0.0f, i);
+			auto first = iter->second;
+
+			weld[i] = first;
+			wedges[i] = inserted ? i : wedges[first];
+
+			if (!inserted)
+			{
+				wedges[first] = i;
+			}
+		}
+	}
+
+	auto position = [&](uint32_t vertex) -> glm::dvec3
+	{
+		return vertices[vertex].position;
+	};
+
+	std::vector<Quadric> quadrics(vertices.size());
+	std::vector<bool> locked(vertices.size(), false);
+
+	{
+		// the number of triangles using each welded edge, borders are used once and non manifold edges more than twice
+		HashMap<uint64_t, uint32_t> edges;
+
+		for (size_t i = 0; i + 2 < output.size(); i += 3)
+		{
+			uint32_t corners[3] = {weld[output[i]], weld[output[i + 1]], weld[output[i + 2]]};
+
+			auto p0 = position(corners[0]);
+			auto cross = glm::cross(position(corners[1]) - p0, position(corners[2]) - p0);
+			auto length = glm::length(cross);
+
+			if (length > 0)
+			{
+				auto normal = cross / length;
+				auto quadric = make_quadric(normal, -glm::dot(normal, p0), length * 0.5);
+
+				for (auto corner : corners)
+				{
+					quadrics[corner] += quadric;
+				}
+			}
+
+			for (int j = 0; j < 3; j++)
+			{
+				auto a = corners[j];
+				auto b = corners[(j + 1) % 3];
+
+				edges[uint64_t(std::min(a, b)) << 32 | std::max(a, b)]++;
+			}
+		}
+
+		// moving a vertex off a border would open a crack to whatever the mesh borders on
+		for (auto [edge, count] : edges)
+		{
+			if (count != 2)
+			{
+				locked[edge >> 32] = true;
+				locked[edge & UINT32_MAX] = true;
+			}
+		}
+	}
+
+	// where every vertex goes after the collapses of a pass
+	std::vector<uint32_t> targets(vertices.size());
+	// blocks vertices next to a collapse so every collapse of a pass sees the positions it was checked against
+	std::vector<bool> touched(vertices.size());
+	// triangles around every welded vertex, stored as offsets into one list
+	std::vector<uint32_t> adjacency_offsets(vertices.size() + 1);
+	std::vector<uint32_t> adjacency;
+	std::vector<Collapse> collapses;
+
+	while (output.size() > target_index_count)
+	{
+		auto triangle_count = output.size() / 3;
+
+		std::fill(adjacency_offsets.begin(), adjacency_offsets.end(), 0);
+
+		for (auto index : output)
+		{
+			adjacency_offsets[weld[index] + 1]++;
+		}
+
+		for (size_t i = 1; i < adjacency_offsets.size(); i++)
+		{
+			adjacency_offsets[i] += adjacency_offsets[i - 1];
+		}
+
+		adjacency.resize(output.size());
+
+		{
+			auto heads = adjacency_offsets;
+
+			for (size_t i = 0; i < output.size(); i++)
+			{
+				adjacency[heads[weld[output[i]]]++] = i / 3;
+			}
+		}
+
+		auto triangles_of = [&](uint32_t vertex)
+		{
+			return std::span(adjacency).subspan(adjacency_offsets[vertex],
+				adjacency_offsets[vertex + 1] - adjacency_offsets[vertex]);
+		};
+
+		collapses.clear();
+
+		for (size_t i = 0; i < output.size(); i += 3)
+		{
+			for (int j = 0; j < 3; j++)
+			{
+				auto a = weld[output[i + j]];
+				auto b = weld[output[i + (j + 1) % 3]];
+
+				if (a > b || (locked[a] && locked[b]))
+				{
+					continue;
+				}
+
+				auto quadric = quadrics[a];
+				quadric += quadrics[b];
+
+				auto a_cost = locked[a] ? INFINITY : quadric.error(position(b));
+				auto b_cost = locked[b] ? INFINITY : quadric.error(position(a));
+
+				if (a_cost <= b_cost)
+				{
+					collapses.push_back({a_cost, a, b});
+				}
+				else
+				{
+					collapses.push_back({b_cost, b, a});
+				}
+			}
+		}
+
+		std::ranges::sort(collapses, {}, &Collapse::cost);
+
+		for (uint32_t i = 0; i < vertices.size(); i++)
+		{
+			targets[i] = i;
+		}
+
+		std::fill(touched.begin(), touched.end(), false);
+
+		size_t removed = 0;
+		auto remaining = triangle_count - target_index_count / 3;
+
+		for (auto &[cost, from, to] : collapses)
+		{
+			if (removed >= remaining)
+			{
+				break;
+			}
+
+			if (touched[from] || touched[to])
+			{
+				continue;
+			}
+
+			auto triangles = triangles_of(from);
+
+			// every vertex at the removed position has to land on the vertex at the target position
+			// it shares a triangle with, otherwise the collapse would tear the uvs of a seam
+			auto valid = true;
+			auto vertex = from;
+
+			do
+			{
+				auto used = false;
+				auto found = UINT32_MAX;
+
+				for (auto triangle : triangles)
+				{
+					for (int j = 0; j < 3; j++)
+					{
+						if (output[triangle * 3 + j] != vertex)
+						{
+							continue;
+						}
+
+						used = true;
+
+						for (int k = 0; k < 3; k++)
+						{
+							if (weld[output[triangle * 3 + k]] == to)
+							{
+								found = output[triangle * 3 + k];
+							}
+						}
+					}
+				}
+
+				// vertices no triangle uses anymore have nothing to move
+				if (used)
+				{
+					valid &= found != UINT32_MAX;
+					targets[vertex] = found;
+				}
+
+				vertex = wedges[vertex];
+			}
+			while (valid && vertex != from);
+
+			// the triangles that stay must not flip over
+			auto shared = 0;
+
+			for (auto triangle : triangles)
+			{
+				if (!valid)
+				{
+					break;
+				}
+
+				glm::dvec3 before[3];
+				glm::dvec3 after[3];
+				auto has_target = false;
+
+				for (int j = 0; j < 3; j++)
+				{
+					auto corner = weld[output[triangle * 3 + j]];
+
+					has_target |= corner == to;
+					before[j] = position(corner);
+					after[j] = corner == from ? position(to) : before[j];
+				}
+
+				if (has_target)
+				{
+					shared++;
+					continue;
+				}
+
+				auto normal_before = glm::cross(before[1] - before[0], before[2] - before[0]);
+				auto normal_after = glm::cross(after[1] - after[0], after[2] - after[0]);
+
+				valid &= glm::dot(normal_before, normal_after) > 0.25 * glm::length(normal_before) * glm::length(normal_after);
+			}
+
+			if (!valid)
+			{
+				vertex = from;
+
+				do
+				{
+					targets[vertex] = vertex;
+					vertex = wedges[vertex];
+				}
+				while (vertex != from);
+
+				continue;
+			}
+
+			quadrics[to] += quadrics[from];
+			out_error = std::max(out_error, (float)std::sqrt(cost));
+			removed += shared;
+
+			for (auto triangle : triangles)
+			{
+				for (int j = 0; j < 3; j++)
+				{
+					touched[weld[output[triangle * 3 + j]]] = true;
+				}
+			}
+		}
+
+		if (removed == 0)
+		{
+			break;
+		}
+
+		// move the collapsed vertices and drop the triangles that lost their area
+		size_t write = 0;
+
+		for (size_t i = 0; i < output.size(); i += 3)
+		{
+			uint32_t triangle[3] = {targets[output[i]], targets[output[i + 1]], targets[output[i + 2]]};
+
+			auto a = weld[triangle[0]];
+			auto b = weld[triangle[1]];
+			auto c = weld[triangle[2]];
+
+			if (a == b || b == c || a == c)
+			{
+				continue;
+			}
+
+			std::copy_n(triangle, 3, output.begin() + write);
+			write += 3;
+		}
+
+		output.resize(write);
+	}
+
+	return output;
+}
+
+void pge::generate_lods(Mesh &mesh)
+{
+	mesh.lods.clear();
+
+	if (mesh.indices.size() / 3 < MIN_LOD_TRIANGLES)
+	{
+		return;
+	}
+
+	// every level references the one before it
+	mesh.lods.reserve(MAX_MESH_LODS - 1);
+
+	std::span<const uint32_t> source = mesh.indices;
+	float error = 0;
+
+	for (uint32_t level = 1; level < MAX_MESH_LODS; level++)
+	{
+		auto target = source.size() / 12 * 3;
+		float level_error;
+
+		auto indices = simplify_mesh(mesh.vertices, source, target, level_error);
+
+		// not worth storing a level the mesh barely got simpler in
+		if (indices.empty() || indices.size() * 5 > source.size() * 4)
+		{
+			break;
+		}
+
+		// each level is simplified from the last so the errors add up
+		error += level_error;
+
+		mesh.lods.push_back({std::move(indices), error});
+		source = mesh.lods.back().indices;
+	}
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include "model.hpp"
+
+namespace pge
+{
+	// removes triangles by collapsing edges into one of their vertices, cheapest first by the quadric error
+	// of the surface around the removed vertex. open borders stay in place and vertices on uv seams only move
+	// along the seam so the result can keep using the original vertices.
+	// out_error is roughly the distance the surface moved, in the space of the vertices
+	std::vector<uint32_t> simplify_mesh(std::span<const Vertex> vertices, std::span<const uint32_t> indices,
+		size_t target_index_count, float &out_error);
+
+	// fills the lods of the mesh, every level has about a quarter of the triangles of the one before it
+	void generate_lods(Mesh &mesh);
+}
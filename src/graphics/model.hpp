@@ -23,6 +23,8 @@ namespace pge
 	constexpr uint8_t MAT_RECEIVE_LIGHT { 1 << 2};
 	constexpr uint8_t MAT_CAST_SHADOW { 1 << 3};
 	constexpr uint8_t MAT_CONTRIBUTE_BLOOM { 1 << 4};
+	// always consider the mesh as an occluder for occlusion culling, even when it is small or has alpha textures
+	constexpr uint8_t MAT_OCCLUDER { 1 << 5};
 	constexpr uint32_t DEFAULT_MAT_FLAGS = MAT_RECEIVE_LIGHT | MAT_CAST_SHADOW | MAT_CONTRIBUTE_BLOOM;
 
     struct Material
@@ -49,6 +51,54 @@ namespace pge
 		glm::vec3 bitangent  {};
     };
 
+    // axis aligned bounding box in the local space of a mesh
+    struct Bounds
+    {
+        glm::vec3 min {0.0f};
+        glm::vec3 max {0.0f};
+
+        [[nodiscard]]
+        glm::vec3 center() const
+        {
+            return (min + max) * 0.5f;
+        }
+
+        [[nodiscard]]
+        float radius() const
+        {
+            return glm::length(max - min) * 0.5f;
+        }
+    };
+
+    static Bounds calculate_bounds(std::span<const Vertex> vertices)
+    {
+        if (vertices.empty())
+        {
+            return {};
+        }
+
+        Bounds output {vertices.front().position, vertices.front().position};
+
+        for (const auto &vertex : vertices)
+        {
+            output.min = glm::min(output.min, vertex.position);
+            output.max = glm::max(output.max, vertex.position);
+        }
+
+        return output;
+    }
+
+    // the original indices of a mesh count as the first lod
+    constexpr uint32_t MAX_MESH_LODS = 4;
+
+    // a simplified version of a mesh that reuses its vertices
+    struct MeshLod
+    {
+        std::vector<uint32_t> indices;
+        // roughly how far the simplified surface is from the original, in mesh space
+        float error = 0;
+    };
+
     struct Mesh
     {
         uint32_t id = UINT32_MAX;
@@ -56,6 +106,9 @@ namespace pge
         std::vector<Vertex> vertices;
         std::vector<uint32_t> indices;
         Material material {};
+        Bounds bounds {};
+        // coarser every level, at most MAX_MESH_LODS - 1
+        std::vector<MeshLod> lods;
     };
 
     // a read only view of a mesh with owned materials
@@ -66,13 +119,17 @@ namespace pge
         const std::span<const Vertex> vertices;
         const std::span<const uint32_t> indices;
         Material material {};
+        const Bounds bounds;
+        const std::span<const MeshLod> lods;
 
         MeshView(const Mesh &mesh) :
             id(mesh.id),
             name(mesh.name),
             vertices(mesh.vertices),
             indices(mesh.indices),
-            material(mesh.material)
+            material(mesh.material),
+            bounds(mesh.bounds),
+            lods(mesh.lods)
         {}
     };
 
@@ -0,0 +1,280 @@
+#include "null_renderer.hpp"
+
+#include <filesystem>
+
+#include "../frame_capture.hpp"
+#include "../../application/engine.hpp"
+
+std::string_view pge::to_string(NullCommandType type)
+{
+	using enum NullCommandType;
+
+	switch (type)
+	{
+		case CreateShader: return "create shader";
+		case CreateBuffers: return "create buffers";
+		case DeleteBuffers: return "delete buffers";
+		case Draw: return "draw";
+		case CreateTexture: return "create texture";
+		case CreateCubemap: return "create cubemap";
+		case DeleteTexture: return "delete texture";
+		case SetSkybox: return "set skybox";
+		case AddView: return "add view";
+		case RemoveView: return "remove view";
+		case ReadImage: return "read image";
+		case SetSettings: return "set settings";
+		case EndFrame: return "end frame";
+		default: return "unknown";
+	}
+}
+
+// files that do not exist count as empty, the null renderer never reads them
+static uint64_t file_size(std::string_view path)
+{
+	std::error_code error;
+
+	auto size = std::filesystem::file_size(path, error);
+
+	return error ? 0 : size;
+}
+
+pge::Image pge::NullFramebuffer::get_image() const
+{
+	auto [width, height] = Engine::window.framebuffer_size();
+
+	Image image;
+
+	image.width = width;
+	image.height = height;
+	image.channels = 3;
+	image.data.resize((size_t)width * height * 3);
+
+	return image;
+}
+
+uint32_t pge::NullRenderer::init()
+{
+	return 0;
+}
+
+pge::IShader* pge::NullRenderer::create_shader(ShaderList shaders)
+{
+	record(NullCommandType::CreateShader, m_shaders.size());
+
+	return &m_shaders.emplace_back();
+}
+
+void pge::NullRenderer::create_buffers(Mesh &mesh)
+{
+	mesh.bounds = calculate_bounds(mesh.vertices);
+	mesh.id = m_next_mesh++;
+
+	auto bytes = mesh.vertices.size() * sizeof(Vertex) + mesh.indices.size() * sizeof(uint32_t);
+
+	for (auto &lod : mesh.lods)
+	{
+		bytes += lod.indices.size() * sizeof(uint32_t);
+	}
+
+	record(NullCommandType::CreateBuffers, mesh.id, bytes);
+}
+
+void pge::NullRenderer::delete_buffers(Mesh &mesh)
+{
+	record(NullCommandType::DeleteBuffers, mesh.id);
+}
+
+void pge::NullRenderer::new_frame()
+{
+	// draws are queued before new_frame is called so the frame is only cut off by end_frame
+}
+
+void pge::NullRenderer::end_frame()
+{
+	record(NullCommandType::EndFrame);
+
+	if (m_frame_recorder != nullptr)
+	{
+		m_frame_recorder->record(m_draws, *m_camera, m_settings);
+
+		if (m_frame_recorder->done())
+		{
+			m_frame_recorder = nullptr;
+		}
+	}
+
+	m_draws.clear();
+
+	// reads are answered right away since there is nothing to wait for
+	for (auto &callback : m_image_requests)
+	{
+		callback(m_framebuffer.get_image());
+	}
+
+	m_image_requests.clear();
+
+	m_stats = m_frame_stats;
+	m_frame_stats = {};
+
+	std::swap(m_frame, m_last_frame);
+	m_frame.clear();
+	m_frame_count++;
+}
+
+void pge::NullRenderer::draw(const MeshView &mesh, glm::mat4 transform, DrawOptions options)
+{
+	// what the gl renderer uploads for every draw, the transform and material data
+	record(NullCommandType::Draw, mesh.id, sizeof(transform) + sizeof(Material));
+
+	// only kept for a frame recorder, the draws are not used otherwise
+	if (m_frame_recorder != nullptr)
+	{
+		m_draws.push_back({mesh, transform, options});
+	}
+
+	m_frame_stats.draw_calls++;
+	m_frame_stats.vertices += mesh.vertices.size();
+	m_frame_stats.triangles += mesh.indices.size() / 3;
+}
+
+pge::RendererProperties pge::NullRenderer::properties()
+{
+	return
+	{
+		.device_name = "none",
+		.version_major = 0,
+		.version_minor = 0,
+		.api = GraphicsApi::Null,
+	};
+}
+
+uint32_t pge::NullRenderer::create_texture_from_path(std::string_view path, uint32_t &out_texture,
+	TextureOptions options)
+{
+	out_texture = m_next_texture++;
+
+	record(NullCommandType::CreateTexture, out_texture, file_size(path));
+
+	return 0;
+}
+
+uint32_t pge::NullRenderer::create_texture(ustring_view data, int width, int height, int channels,
+	uint32_t &out_texture, TextureWrapMode wrap_mode, bool gamma_correct)
+{
+	out_texture = m_next_texture++;
+
+	record(NullCommandType::CreateTexture, out_texture, (uint64_t)width * height * channels);
+
+	return 0;
+}
+
+uint32_t pge::NullRenderer::create_cubemap_from_path(std::array<std::string_view, 6> faces, uint32_t &out_texture)
+{
+	out_texture = m_next_texture++;
+
+	uint64_t bytes = 0;
+
+	for (auto face : faces)
+	{
+		bytes += file_size(face);
+	}
+
+	record(NullCommandType::CreateCubemap, out_texture, bytes);
+
+	return 0;
+}
+
+void pge::NullRenderer::read_image_async(IFramebuffer *framebuffer, ImageCallback callback)
+{
+	auto [width, height] = Engine::window.framebuffer_size();
+
+	record(NullCommandType::ReadImage, UINT32_MAX, (uint64_t)width * height * 3);
+
+	m_image_requests.push_back(std::move(callback));
+}
+
+void pge::NullRenderer::delete_texture(uint32_t id)
+{
+	record(NullCommandType::DeleteTexture, id);
+}
+
+void pge::NullRenderer::set_skybox(uint32_t id)
+{
+	record(NullCommandType::SetSkybox, id);
+}
+
+pge::RenderView* pge::NullRenderer::add_view(Camera *camera)
+{
+	auto *fb = &m_view_framebuffers.emplace_back();
+	auto &view = m_render_views.emplace_back(camera, fb, true);
+
+	view.iter = --m_render_views.end();
+
+	record(NullCommandType::AddView, m_render_views.size() - 1);
+
+	return &view;
+}
+
+void pge::NullRenderer::remove_view(RenderView *view)
+{
+	if (view == nullptr)
+	{
+		return;
+	}
+
+	record(NullCommandType::RemoveView);
+
+	m_view_framebuffers.remove_if([view](const NullFramebuffer &fb)
+	{
+		return &fb == view->framebuffer;
+	});
+
+	view->framebuffer = nullptr;
+
+	m_render_views.erase(view->iter);
+}
+
+void pge::NullRenderer::set_shadow_settings(ShadowSettings settings)
+{
+	record(NullCommandType::SetSettings);
+
+	m_settings.shadow = settings;
+}
+
+void pge::NullRenderer::set_screen_space_settings(ScreenSpaceSettings settings)
+{
+	record(NullCommandType::SetSettings);
+
+	m_settings.screen_space = settings;
+}
+
+void pge::NullRenderer::set_texture_settings(TextureSettings settings)
+{
+	record(NullCommandType::SetSettings);
+
+	m_settings.texture = settings;
+}
+
+uint32_t pge::NullRenderer::set_pipeline_settings(PipelineSettings settings)
+{
+	record(NullCommandType::SetSettings);
+
+	m_settings.pipeline = settings;
+
+	return 0;
+}
+
+void pge::NullRenderer::set_geometry_settings(GeometrySettings settings)
+{
+	record(NullCommandType::SetSettings);
+
+	m_settings.geometry = settings;
+}
+
+void pge::NullRenderer::record(NullCommandType type, uint32_t id, uint64_t bytes)
+{
+	NullCommand command {type, id, bytes};
+
+	m_frame.push_back(command);
+	m_totals.add(command);
+}
@@ -0,0 +1,253 @@
+#pragma once
+
+#include <array>
+#include <list>
+#include <vector>
+
+#include "../renderer_interface.hpp"
+#include "../renderer_structs.hpp"
+
+namespace pge
+{
+	enum class NullCommandType : uint8_t
+	{
+		CreateShader,
+		CreateBuffers,
+		DeleteBuffers,
+		Draw,
+		CreateTexture,
+		CreateCubemap,
+		DeleteTexture,
+		SetSkybox,
+		AddView,
+		RemoveView,
+		ReadImage,
+		SetSettings,
+		EndFrame,
+		Count,
+	};
+
+	std::string_view to_string(NullCommandType type);
+
+	// one call made to the null renderer
+	struct NullCommand
+	{
+		NullCommandType type;
+		// the mesh, texture or view the call was about, UINT32_MAX if there is none
+		uint32_t id = UINT32_MAX;
+		// bytes of data a gpu backend would have uploaded or read for the call
+		uint64_t bytes = 0;
+	};
+
+	// calls and bytes per command type
+	struct NullCommandTotals
+	{
+		std::array<uint64_t, (size_t)NullCommandType::Count> counts {};
+		std::array<uint64_t, (size_t)NullCommandType::Count> bytes {};
+
+		void add(const NullCommand &command)
+		{
+			counts[(size_t)command.type]++;
+			bytes[(size_t)command.type] += command.bytes;
+		}
+
+		[[nodiscard]]
+		uint64_t count(NullCommandType type) const
+		{
+			return counts[(size_t)type];
+		}
+	};
+
+	class NullShader : public IShader
+	{
+	public:
+		uint32_t create(ShaderList) override { return 0; }
+		IShader& use() override { return *this; }
+		IShader& set(std::string_view, int) override { return *this; }
+		IShader& set(std::string_view, float) override { return *this; }
+		IShader& set(std::string_view, glm::vec2) override { return *this; }
+		IShader& set(std::string_view, glm::vec3) override { return *this; }
+		IShader& set(std::string_view, glm::vec4) override { return *this; }
+		IShader& set(std::string_view, glm::mat4) override { return *this; }
+	};
+
+	class NullFramebuffer : public IFramebuffer
+	{
+	public:
+		void bind() override {}
+		void unbind() override {}
+		void set_samples(int) override {}
+		void blit(IFramebuffer*, int, int, int, int, int) override {}
+		void blit_all_targets(IFramebuffer*, int, int, int, int) override {}
+
+		[[nodiscard]]
+		uint32_t get_texture() const override
+		{
+			return 0;
+		}
+
+		// a black image the size of the window
+		[[nodiscard]]
+		Image get_image() const override;
+	};
+
+	// a renderer without a gpu. every call is accepted and recorded so the cpu side of the engine
+	// can run and be measured on machines without a display, nothing is ever drawn
+	class NullRenderer : public IRenderer
+	{
+	public:
+		uint32_t init() override;
+
+		IShader* create_shader(ShaderList shaders) override;
+
+		void create_buffers(Mesh &mesh) override;
+
+		void delete_buffers(Mesh &mesh) override;
+
+		void set_visualize_depth(bool) override {}
+
+		void new_frame() override;
+
+		void end_frame() override;
+
+		void draw(const MeshView &mesh, glm::mat4 transform, DrawOptions options = {}) override;
+
+		void set_wireframe_mode(bool) override {}
+
+		void set_clear_color(glm::vec4 value) override
+		{
+			m_clear_color = value;
+		}
+
+		glm::vec4 get_clear_color() override
+		{
+			return m_clear_color;
+		}
+
+		void set_offline(bool) override {}
+
+		void wait() override {}
+
+		RendererProperties properties() override;
+
+		std::string_view error_message(uint32_t) override
+		{
+			return "";
+		}
+
+		uint32_t create_texture_from_path(std::string_view path, uint32_t &out_texture, TextureOptions options) override;
+
+		uint32_t create_texture(ustring_view data, int width, int height, int channels, uint32_t &out_texture,
+			TextureWrapMode wrap_mode, bool gamma_correct) override;
+
+		uint32_t create_cubemap_from_path(std::array<std::string_view, 6> faces, uint32_t &out_texture) override;
+
+		Image get_image() override
+		{
+			return m_framebuffer.get_image();
+		}
+
+		void read_image_async(IFramebuffer *framebuffer, ImageCallback callback) override;
+
+		void delete_texture(uint32_t id) override;
+
+		void set_skybox(uint32_t id) override;
+
+		RenderView* add_view(Camera *camera) override;
+
+		void remove_view(RenderView *view) override;
+
+		IFramebuffer* get_framebuffer() override
+		{
+			return &m_framebuffer;
+		}
+
+		IFramebuffer* get_render_framebuffer() override
+		{
+			return &m_framebuffer;
+		}
+
+		void set_shadow_settings(ShadowSettings settings) override;
+
+		ShadowSettings get_shadow_settings() override
+		{
+			return m_settings.shadow;
+		}
+
+		void set_screen_space_settings(ScreenSpaceSettings settings) override;
+
+		ScreenSpaceSettings get_color_settings() override
+		{
+			return m_settings.screen_space;
+		}
+
+		void set_texture_settings(TextureSettings settings) override;
+
+		TextureSettings get_texture_settings() override
+		{
+			return m_settings.texture;
+		}
+
+		uint32_t set_pipeline_settings(PipelineSettings settings) override;
+
+		PipelineSettings get_pipeline_settings() override
+		{
+			return m_settings.pipeline;
+		}
+
+		void set_geometry_settings(GeometrySettings settings) override;
+
+		GeometrySettings get_geometry_settings() override
+		{
+			return m_settings.geometry;
+		}
+
+		RenderStats get_stats() override
+		{
+			return m_stats;
+		}
+
+		// the calls of the last finished frame, from the end of the frame before it up to its end_frame
+		[[nodiscard]]
+		std::span<const NullCommand> last_frame() const
+		{
+			return m_last_frame;
+		}
+
+		// every call since the renderer was created
+		[[nodiscard]]
+		const NullCommandTotals& totals() const
+		{
+			return m_totals;
+		}
+
+		[[nodiscard]]
+		uint64_t frame_count() const
+		{
+			return m_frame_count;
+		}
+
+	private:
+		std::list<NullShader> m_shaders;
+		std::list<NullFramebuffer> m_view_framebuffers;
+		RenderViewList m_render_views;
+		NullFramebuffer m_framebuffer;
+		glm::vec4 m_clear_color {0.0f};
+		uint32_t m_next_mesh = 0;
+		uint32_t m_next_texture = 0;
+
+		std::vector<NullCommand> m_frame;
+		std::vector<NullCommand> m_last_frame;
+		NullCommandTotals m_totals;
+		uint64_t m_frame_count = 0;
+		std::vector<ImageCallback> m_image_requests;
+		std::vector<DrawData> m_draws;
+
+		AllRenderSettings m_settings;
+		RenderStats m_stats;
+		// counted while the frame is recorded, handed to m_stats by end_frame
+		RenderStats m_frame_stats;
+
+		void record(NullCommandType type, uint32_t id = UINT32_MAX, uint64_t bytes = 0);
+	};
+}
@@ -0,0 +1,400 @@
+#include "occlusion.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PGE_OCCLUSION_AVX2 1
+#endif
+
+// a triangle turned into edge functions and a depth plane, all of the form a * x + b * y + c in pixel space
+struct TriangleSetup
+{
+	glm::vec3 edges[3];
+	glm::vec3 depth;
+	// inclusive pixel bounds clamped to the buffer
+	int min_x, min_y, max_x, max_y;
+};
+
+static void fill_scalar(float *buffer, const TriangleSetup &setup)
+{
+	for (int y = setup.min_y; y <= setup.max_y; y++)
+	{
+		auto py = y + 0.5f;
+		auto *row = buffer + y * pge::OcclusionBuffer::WIDTH;
+
+		for (int x = setup.min_x; x <= setup.max_x; x++)
+		{
+			auto px = x + 0.5f;
+			auto inside = true;
+
+			for (auto &edge : setup.edges)
+			{
+				inside &= edge.x * px + edge.y * py + edge.z >= 0.0f;
+			}
+
+			if (inside)
+			{
+				row[x] = std::min(row[x], setup.depth.x * px + setup.depth.y * py + setup.depth.z);
+			}
+		}
+	}
+}
+
+#if PGE_OCCLUSION_AVX2
+// tests and writes 8 pixels of a row at once. the start is aligned down to 8 pixels,
+// the extra pixels are outside the bounds of the triangle so the edge functions reject them
+__attribute__((target("avx2,fma")))
+static void fill_avx2(float *buffer, const TriangleSetup &setup)
+{
+	auto zero = _mm256_setzero_ps();
+	auto lanes = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+
+	__m256 edge_x[3];
+
+	for (int i = 0; i < 3; i++)
+	{
+		edge_x[i] = _mm256_set1_ps(setup.edges[i].x);
+	}
+
+	auto depth_x = _mm256_set1_ps(setup.depth.x);
+	auto start = setup.min_x & ~7;
+
+	for (int y = setup.min_y; y <= setup.max_y; y++)
+	{
+		auto py = y + 0.5f;
+		auto *row = buffer + y * pge::OcclusionBuffer::WIDTH;
+
+		__m256 row_edges[3];
+
+		for (int i = 0; i < 3; i++)
+		{
+			row_edges[i] = _mm256_set1_ps(setup.edges[i].y * py + setup.edges[i].z);
+		}
+
+		auto row_depth = _mm256_set1_ps(setup.depth.y * py + setup.depth.z);
+
+		for (int x = start; x <= setup.max_x; x += 8)
+		{
+			auto px = _mm256_add_ps(_mm256_set1_ps((float)x), lanes);
+
+			auto w0 = _mm256_fmadd_ps(edge_x[0], px, row_edges[0]);
+			auto w1 = _mm256_fmadd_ps(edge_x[1], px, row_edges[1]);
+			auto w2 = _mm256_fmadd_ps(edge_x[2], px, row_edges[2]);
+
+			auto inside = _mm256_and_ps(_mm256_cmp_ps(w0, zero, _CMP_GE_OQ),
+				_mm256_and_ps(_mm256_cmp_ps(w1, zero, _CMP_GE_OQ), _mm256_cmp_ps(w2, zero, _CMP_GE_OQ)));
+
+			if (_mm256_movemask_ps(inside) == 0)
+			{
+				continue;
+			}
+
+			auto depth = _mm256_fmadd_ps(depth_x, px, row_depth);
+			auto current = _mm256_loadu_ps(row + x);
+			auto nearest = _mm256_min_ps(current, depth);
+
+			_mm256_storeu_ps(row + x, _mm256_blendv_ps(current, nearest, inside));
+		}
+	}
+}
+#endif
+
+static void (*select_fill())(float*, const TriangleSetup&)
+{
+#if PGE_OCCLUSION_AVX2
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+	{
+		return fill_avx2;
+	}
+#endif
+
+	return fill_scalar;
+}
+
+static void (*const fill)(float*, const TriangleSetup&) = select_fill();
+
+// the edge function of a to b, positive on the left side when looking from a to b
+static glm::vec3 make_edge(glm::vec2 a, glm::vec2 b)
+{
+	return {a.y - b.y, b.x - a.x, a.x * b.y - a.y * b.x};
+}
+
+// the pixel containing a screen coordinate, clamped to the buffer before converting so huge values cannot overflow
+static int pixel(float value, uint32_t size)
+{
+	return (int)std::floor(std::clamp(value, 0.0f, size - 1.0f));
+}
+
+// the bits of inner are set for the edges bc, ca and ab when the mesh continues on their other side
+static void rasterize_triangle(float *buffer, glm::vec3 a, glm::vec3 b, glm::vec3 c, uint32_t inner = 0)
+{
+	auto area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+
+	if (std::abs(area) < 1e-6f)
+	{
+		return;
+	}
+
+	// occluders are rasterized double sided so the winding of the mesh does not matter
+	if (area < 0)
+	{
+		std::swap(b, c);
+		area = -area;
+
+		// bc stays the same edge, ca and ab trade places
+		inner = (inner & 1) | (inner & 2) << 1 | (inner & 4) >> 1;
+	}
+
+	auto min = glm::min(a, glm::min(b, c));
+	auto max = glm::max(a, glm::max(b, c));
+
+	if (max.x < 0.0f || max.y < 0.0f || min.x >= pge::OcclusionBuffer::WIDTH || min.y >= pge::OcclusionBuffer::HEIGHT)
+	{
+		return;
+	}
+
+	TriangleSetup setup
+	{
+		.edges
+		{
+			make_edge(b, c),
+			make_edge(c, a),
+			make_edge(a, b),
+		},
+		.min_x = pixel(min.x, pge::OcclusionBuffer::WIDTH),
+		.min_y = pixel(min.y, pge::OcclusionBuffer::HEIGHT),
+		.max_x = pixel(max.x, pge::OcclusionBuffer::WIDTH),
+		.max_y = pixel(max.y, pge::OcclusionBuffer::HEIGHT),
+	};
+
+	// the edge functions are the barycentric weights scaled by the area
+	setup.depth = (setup.edges[0] * a.z + setup.edges[1] * b.z + setup.edges[2] * c.z) / area;
+
+	// store the farthest depth the triangle can have inside a pixel so occludees are never culled too early
+	setup.depth.z += 0.5f * (std::abs(setup.depth.x) + std::abs(setup.depth.y));
+
+	// for the same reason a pixel is only written when the mesh covers all of it. moving an edge inwards by half
+	// a pixel makes the test at the center fail for pixels a corner of the triangle lies outside of.
+	// edges inside the mesh stay so the pixels along them are still written by one of their triangles
+	for (int i = 0; i < 3; i++)
+	{
+		auto &edge = setup.edges[i];
+
+		if (!(inner & 1 << i))
+		{
+			edge.z -= 0.5f * (std::abs(edge.x) + std::abs(edge.y));
+		}
+	}
+
+	fill(buffer, setup);
+}
+
+static glm::vec3 to_screen(const glm::vec4 &clip)
+{
+	auto ndc = glm::vec3(clip) / clip.w;
+
+	return
+	{
+		(ndc.x * 0.5f + 0.5f) * pge::OcclusionBuffer::WIDTH,
+		(ndc.y * 0.5f + 0.5f) * pge::OcclusionBuffer::HEIGHT,
+		ndc.z,
+	};
+}
+
+pge::OcclusionBuffer::OcclusionBuffer() :
+	m_depth(WIDTH * HEIGHT, 1.0f)
+{}
+
+void pge::OcclusionBuffer::clear()
+{
+	std::fill(m_depth.begin(), m_depth.end(), 1.0f);
+}
+
+uint32_t pge::OcclusionBuffer::rasterize(std::span<const Vertex> vertices, std::span<const uint32_t> indices,
+	const glm::mat4 &mvp)
+{
+	uint32_t rasterized = 0;
+
+	m_clip.resize(vertices.size());
+
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		m_clip[i] = mvp * glm::vec4(vertices[i].position, 1.0f);
+	}
+
+	// distance to the near plane, z >= -w in clip space
+	auto distance = [&](uint32_t vertex)
+	{
+		return m_clip[vertex].z + m_clip[vertex].w;
+	};
+
+	// the vertices across from every edge, an edge with exactly two is shared by two triangles
+	m_edges.clear();
+
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		for (int j = 0; j < 3; j++)
+		{
+			auto a = indices[i + (j + 1) % 3];
+			auto b = indices[i + (j + 2) % 3];
+			auto &edge = m_edges[uint64_t(std::min(a, b)) << 32 | std::max(a, b)];
+
+			if (edge.count < 2)
+			{
+				edge.opposite[edge.count] = indices[i + j];
+			}
+
+			edge.count++;
+		}
+	}
+
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		glm::vec4 clip[3];
+		int behind = 0;
+
+		for (int j = 0; j < 3; j++)
+		{
+			clip[j] = m_clip[indices[i + j]];
+			behind += distance(indices[i + j]) < 0.0f;
+		}
+
+		if (behind == 3)
+		{
+			continue;
+		}
+
+		if (behind == 0)
+		{
+			glm::vec3 screen[3] = {to_screen(clip[0]), to_screen(clip[1]), to_screen(clip[2])};
+			uint32_t inner = 0;
+
+			// an edge is inside the mesh on screen when the triangle across it lies on its other side
+			for (int j = 0; j < 3; j++)
+			{
+				auto a = indices[i + (j + 1) % 3];
+				auto b = indices[i + (j + 2) % 3];
+				auto &edge = m_edges[uint64_t(std::min(a, b)) << 32 | std::max(a, b)];
+
+				if (edge.count != 2)
+				{
+					continue;
+				}
+
+				auto other = edge.opposite[0] == indices[i + j] ? edge.opposite[1] : edge.opposite[0];
+
+				if (distance(other) < 0.0f)
+				{
+					continue;
+				}
+
+				auto function = make_edge(screen[(j + 1) % 3], screen[(j + 2) % 3]);
+				auto side = glm::dot(function, glm::vec3(glm::vec2(screen[j]), 1.0f));
+				auto other_side = glm::dot(function, glm::vec3(glm::vec2(to_screen(m_clip[other])), 1.0f));
+
+				if (side * other_side < 0.0f)
+				{
+					inner |= 1 << j;
+				}
+			}
+
+			rasterize_triangle(m_depth.data(), screen[0], screen[1], screen[2], inner);
+			rasterized++;
+			continue;
+		}
+
+		// walls and floors often reach behind the camera, clipping them keeps the part in front as an occluder
+		glm::vec4 polygon[4];
+		int count = 0;
+
+		for (int j = 0; j < 3; j++)
+		{
+			auto next = (j + 1) % 3;
+
+			auto here = distance(indices[i + j]);
+			auto there = distance(indices[i + next]);
+
+			if (here >= 0.0f)
+			{
+				polygon[count++] = clip[j];
+			}
+
+			if ((here < 0.0f) != (there < 0.0f))
+			{
+				auto t = here / (here - there);
+				polygon[count++] = glm::mix(clip[j], clip[next], t);
+			}
+		}
+
+		// only the diagonals of the fan are known to be inside the mesh, the clipped edges are treated as borders
+		for (int j = 1; j + 1 < count; j++)
+		{
+			auto inner = (j > 1 ? 4u : 0u) | (j + 2 < count ? 2u : 0u);
+
+			rasterize_triangle(m_depth.data(), to_screen(polygon[0]), to_screen(polygon[j]), to_screen(polygon[j + 1]),
+				inner);
+			rasterized++;
+		}
+	}
+
+	return rasterized;
+}
+
+bool pge::OcclusionBuffer::is_occluded(const Bounds &bounds, const glm::mat4 &mvp) const
+{
+	glm::vec3 screen_min {std::numeric_limits<float>::max()};
+	glm::vec3 screen_max {-std::numeric_limits<float>::max()};
+
+	for (int i = 0; i < 8; i++)
+	{
+		auto corner = glm::vec3
+		{
+			i & 1 ? bounds.max.x : bounds.min.x,
+			i & 2 ? bounds.max.y : bounds.min.y,
+			i & 4 ? bounds.max.z : bounds.min.z,
+		};
+
+		auto clip = mvp * glm::vec4(corner, 1.0f);
+
+		if (clip.z + clip.w <= 0.0f)
+		{
+			return false;
+		}
+
+		auto screen = to_screen(clip);
+
+		screen_min = glm::min(screen_min, screen);
+		screen_max = glm::max(screen_max, screen);
+	}
+
+	if (screen_max.x < 0.0f || screen_max.y < 0.0f || screen_min.x >= WIDTH || screen_min.y >= HEIGHT)
+	{
+		return false;
+	}
+
+	auto min_x = pixel(screen_min.x, WIDTH);
+	auto min_y = pixel(screen_min.y, HEIGHT);
+	auto max_x = pixel(screen_max.x, WIDTH);
+	auto max_y = pixel(screen_max.y, HEIGHT);
+
+	// the nearest point of the box has to be behind the occluders at every pixel the box touches
+	for (int y = min_y; y <= max_y; y++)
+	{
+		auto *row = m_depth.data() + y * WIDTH;
+
+		for (int x = min_x; x <= max_x; x++)
+		{
+			if (row[x] >= screen_min.z)
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
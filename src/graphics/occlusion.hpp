@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "model.hpp"
+#include "../data/hash_table.hpp"
+
+namespace pge
+{
+	// a low resolution depth buffer the cpu rasterizes a few large occluders into
+	// so draws hidden behind them can be skipped before they ever reach the gpu
+	class OcclusionBuffer
+	{
+	public:
+		// the width is a multiple of the 8 pixels the avx2 path works on at once
+		static constexpr uint32_t WIDTH = 320;
+		static constexpr uint32_t HEIGHT = 180;
+
+		OcclusionBuffer();
+
+		// resets every pixel to the far plane
+		void clear();
+
+		// rasterizes the triangles of a mesh, mvp takes the mesh positions into clip space. only pixels the mesh
+		// fully covers are written, edges are matched by vertex index so meshes with split vertices lose the pixels
+		// along those seams. returns the number of triangles that were rasterized after clipping
+		uint32_t rasterize(std::span<const Vertex> vertices, std::span<const uint32_t> indices, const glm::mat4 &mvp);
+
+		// true if the box is behind the occluders at every pixel it can cover.
+		// boxes crossing the near plane or outside the screen are never occluded
+		[[nodiscard]]
+		bool is_occluded(const Bounds &bounds, const glm::mat4 &mvp) const;
+
+		// normalized device depth of every pixel, rows start at the bottom of the screen
+		[[nodiscard]]
+		std::span<const float> depth() const
+		{
+			return m_depth;
+		}
+
+	private:
+		struct EdgeTriangles
+		{
+			uint32_t opposite[2];
+			uint32_t count = 0;
+		};
+
+		std::vector<float> m_depth;
+		// reused by rasterize so a mesh does not allocate every frame
+		std::vector<glm::vec4> m_clip;
+		HashMap<uint64_t, EdgeTriangles> m_edges;
+	};
+}
@@ -0,0 +1,89 @@
+#include "bloom.hpp"
+#include "gl_state.hpp"
+#include "../../application/engine.hpp"
+
+pge::Bloom::~Bloom()
+{
+	glDeleteFramebuffers(1, &fbo);
+	glDeleteTextures(1, &texture);
+
+	gl_state.forget_framebuffer(fbo);
+	gl_state.forget_texture(texture);
+}
+
+uint32_t pge::Bloom::init()
+{
+	VALIDATE_ERR(downsample_shader.create(
+	{
+		{PGE_FIND_SHADER("quad.vert.glsl"), ShaderType::Vertex},
+		{PGE_FIND_SHADER("bloom_downsample.frag"), ShaderType::Fragment},
+	}));
+
+	VALIDATE_ERR(upsample_shader.create(
+	{
+		{PGE_FIND_SHADER("quad.vert.glsl"), ShaderType::Vertex},
+		{PGE_FIND_SHADER("bloom_upsample.frag"), ShaderType::Fragment},
+	}));
+
+	downsample_shader.use().set("image", 0);
+	upsample_shader.use().set("image", 0);
+
+	glGenFramebuffers(1, &fbo);
+
+	auto [width, height] = Engine::window.framebuffer_size();
+
+	create_texture(width, height);
+
+	gl_state.bind_framebuffer(GL_FRAMEBUFFER, fbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		return OPENGL_ERROR_FRAMEBUFFER_CREATION;
+	}
+
+	gl_state.bind_framebuffer(GL_FRAMEBUFFER, 0);
+
+	Engine::window.on_framebuffer_resize.connect(this, &Bloom::on_resize);
+
+	return OPENGL_ERROR_OK;
+}
+
+void pge::Bloom::create_texture(int width, int height)
+{
+	glDeleteTextures(1, &texture);
+	gl_state.forget_texture(texture);
+
+	mip_count = 0;
+
+	auto size = glm::max(glm::ivec2{width, height} / 2, glm::ivec2{1});
+
+	while (mip_count < MAX_MIPS)
+	{
+		mip_sizes[mip_count++] = size;
+
+		if (size.x == 1 && size.y == 1)
+		{
+			break;
+		}
+
+		size = glm::max(size / 2, glm::ivec2{1});
+	}
+
+	glGenTextures(1, &texture);
+	gl_state.edit_texture(GL_TEXTURE_2D, texture);
+
+	// bloom only adds light so the missing sign and alpha of the packed float format are never needed
+	glTexStorage2D(GL_TEXTURE_2D, mip_count, GL_R11F_G11F_B10F, mip_sizes[0].x, mip_sizes[0].y);
+
+	// every pass reads a single level so the filtering never has to pick in between them
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+void pge::Bloom::on_resize(pge::IWindow *, int width, int height)
+{
+	create_texture(width, height);
+}
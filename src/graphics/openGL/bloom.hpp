@@ -0,0 +1,35 @@
+#pragma once
+
+#include <array>
+
+#include "opengl_shader.hpp"
+#include "../../application/window_interface.hpp"
+
+namespace pge
+{
+	// a chain of textures each half the size of the one before it. the bright parts of the image get filtered
+	// down the chain and added back up, so wide blurs only ever touch a few small textures
+	struct Bloom
+	{
+		static constexpr int MAX_MIPS = 8;
+
+		~Bloom();
+
+		uint32_t init();
+
+		// filters with 13 taps when halving a mip so bright pixels do not flicker as they move
+		GlShader downsample_shader;
+		// adds a mip to the one above it through a 3x3 tent filter
+		GlShader upsample_shader;
+		GLuint fbo = 0;
+		// half the size of the framebuffer with a mip level for every step of the chain
+		GLuint texture = 0;
+		int mip_count = 0;
+		std::array<glm::ivec2, MAX_MIPS> mip_sizes {};
+
+	private:
+		void create_texture(int width, int height);
+
+		void on_resize(IWindow*, int width, int height);
+	};
+}
@@ -1,9 +1,27 @@
 #include "gl_buffers.hpp"
 
+void pge::set_vertex_attribute(uint32_t layout, uint32_t size, uint32_t stride, uint32_t offset, GLenum type,
+	bool normalized)
+{
+	auto is_integer = type == GL_BYTE || type == GL_UNSIGNED_BYTE || type == GL_SHORT ||
+		type == GL_UNSIGNED_SHORT || type == GL_INT || type == GL_UNSIGNED_INT;
+
+	if (is_integer && !normalized)
+	{
+		glVertexAttribIPointer(layout, size, type, stride, (void*)(uintptr_t)offset);
+	}
+	else
+	{
+		glVertexAttribPointer(layout, size, type, normalized, stride, (void*)(uintptr_t)offset);
+	}
+
+	glEnableVertexAttribArray(layout);
+}
+
 pge::GlBufferBuilder& pge::GlBufferBuilder::start()
 {
     glGenVertexArrays(1, &m_buffer.vao);
-    glBindVertexArray(m_buffer.vao);
+    gl_state.bind_vertex_array(m_buffer.vao);
 
     return *this;
 }
@@ -37,21 +55,18 @@ pge::GlBufferBuilder& pge::GlBufferBuilder::stride(uint32_t value)
     return *this;
 }
 
-pge::GlBufferBuilder& pge::GlBufferBuilder::attr(uint32_t size, uint32_t offset)
+pge::GlBufferBuilder& pge::GlBufferBuilder::attr(uint32_t size, uint32_t offset, GLenum type, bool normalized)
 {
     assert(m_stride != UINT32_MAX && "stride has not been set");
 
-    auto layout = m_layout++;
-
-    glVertexAttribPointer(layout, size, GL_FLOAT, GL_FALSE, m_stride, (void*)offset);
-    glEnableVertexAttribArray(layout);
+    set_vertex_attribute(m_layout++, size, m_stride, offset, type, normalized);
 
     return *this;
 }
 
 pge::GlBuffers pge::GlBufferBuilder::finish() const
 {
-    glBindVertexArray(0);
+    gl_state.bind_vertex_array(0);
     return m_buffer;
 }
 
@@ -4,9 +4,15 @@
 #include <glad/glad.h>
 
 #include "../model.hpp"
+#include "gl_state.hpp"
 
 namespace pge
 {
+	// sets up a vertex attribute of the bound vao reading from the bound array buffer.
+	// integer types that are not normalized are passed to the shader as integers
+	void set_vertex_attribute(uint32_t layout, uint32_t size, uint32_t stride, uint32_t offset,
+		GLenum type = GL_FLOAT, bool normalized = false);
+
     struct GlBuffers
     {
         GLuint vbo;
@@ -18,6 +24,8 @@ namespace pge
             glDeleteVertexArrays(1, &vao);
             glDeleteBuffers(1, &vbo);
             glDeleteBuffers(1, &ebo);
+
+            gl_state.forget_vertex_array(vao);
         }
     };
 
@@ -34,7 +42,8 @@ namespace pge
 
         GlBufferBuilder& stride(uint32_t value);
 
-        GlBufferBuilder& attr(uint32_t size, uint32_t offset);
+        // type and normalized follow glVertexAttribPointer, for example GL_INT_2_10_10_10_REV normalized for packed normals
+        GlBufferBuilder& attr(uint32_t size, uint32_t offset, GLenum type = GL_FLOAT, bool normalized = false);
 
         [[nodiscard]]
         GlBuffers finish() const;
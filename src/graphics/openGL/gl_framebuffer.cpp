@@ -1,13 +1,16 @@
 #include "gl_framebuffer.hpp"
 
+#include <algorithm>
+
 #include <glad/glad.h>
 
 #include "opengl_error.hpp"
+#include "gl_state.hpp"
 #include "../../application/engine.hpp"
 
-#define SET_TEX_IMAGE(fb, width, height) (fb.samples) > 0 ? \
-	glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, (fb.samples), (fb.internal_format), (width), (height), GL_TRUE) : \
-	glTexImage2D(GL_TEXTURE_2D, 0, (fb.internal_format), (width), (height), 0, (fb.pixel_format), GL_UNSIGNED_BYTE, nullptr)
+#define SET_TEX_IMAGE(fb, format, width, height) (fb.samples) > 0 ? \
+	glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, (fb.samples), (format), (width), (height), GL_TRUE) : \
+	glTexImage2D(GL_TEXTURE_2D, 0, (format), (width), (height), 0, (fb.pixel_format), GL_UNSIGNED_BYTE, nullptr)
 
 #define SET_RENDER_BUFFER(fb, width, height) (fb.samples) > 0 ? \
 	glRenderbufferStorageMultisample(GL_RENDERBUFFER, (fb.samples), GL_DEPTH24_STENCIL8, (width), (height))  : \
@@ -21,6 +24,13 @@ pge::GlFramebuffer::~GlFramebuffer()
     glDeleteRenderbuffers(1, &rbo);
     glDeleteTextures(texture_count, textures);
 
+	gl_state.forget_framebuffer(fbo);
+
+	for (int i = 0; i < texture_count; i++)
+	{
+		gl_state.forget_texture(textures[i]);
+	}
+
 	if (m_on_resize_con)
 	{
     	Engine::window.on_framebuffer_resize.disconnect(m_on_resize_con);
@@ -34,17 +44,17 @@ uint32_t pge::GlFramebuffer::get_texture() const
 
 void pge::GlFramebuffer::bind()
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    gl_state.bind_framebuffer(GL_FRAMEBUFFER, fbo);
 }
 
 void pge::GlFramebuffer::unbind()
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    gl_state.bind_framebuffer(GL_FRAMEBUFFER, 0);
 }
 
 pge::Image pge::GlFramebuffer::get_image() const
 {
-    glBindTexture(tex_target, textures[0]);
+    gl_state.edit_texture(tex_target, textures[0]);
 
     Image img;
 
@@ -55,8 +65,6 @@ pge::Image pge::GlFramebuffer::get_image() const
 
     glGetTexImage(tex_target, 0, GL_RGB, GL_UNSIGNED_BYTE, img.data.data());
 
-    glBindTexture(tex_target, 0);
-
     img.channels = 3;
 
     return img;
@@ -82,9 +90,11 @@ void set_textures(const pge::GlFramebuffer &fb, int width, int height)
 {
 	for (int i = 0; i < fb.texture_count; i++)
 	{
-		glBindTexture(fb.tex_target, fb.textures[i]);
+		pge::gl_state.edit_texture(fb.tex_target, fb.textures[i]);
+
+		auto format = fb.texture_formats[i] != 0 ? fb.texture_formats[i] : fb.internal_format;
 
-		SET_TEX_IMAGE(fb, width, height);
+		SET_TEX_IMAGE(fb, format, width, height);
 
 		glTexParameteri(fb.tex_target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 		glTexParameteri(fb.tex_target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -109,7 +119,6 @@ void pge::GlFramebuffer::set_buffers(int width, int height)
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo);
 
 	glBindRenderbuffer(GL_RENDERBUFFER, 0);
-	glBindTexture(tex_target, 0);
 }
 
 void pge::GlFramebuffer::blit(pge::IFramebuffer *src, int width, int height, int attachment, int x, int y)
@@ -123,10 +132,10 @@ void pge::GlFramebuffer::blit(pge::IFramebuffer *src, int width, int height, int
 		height = wh.second;
 	}
 
-	glBindFramebuffer(GL_READ_FRAMEBUFFER, gl_src->fbo);
+	gl_state.bind_framebuffer(GL_READ_FRAMEBUFFER, gl_src->fbo);
 	glReadBuffer(GL_COLOR_ATTACHMENT0 + attachment);
 
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
+	gl_state.bind_framebuffer(GL_DRAW_FRAMEBUFFER, fbo);
 	glDrawBuffer(GL_COLOR_ATTACHMENT0 + attachment);
 
 	glBlitFramebuffer(x, y, width, height, x, y, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
@@ -147,7 +156,7 @@ uint32_t pge::create_color_buffer(GlFramebuffer &fb)
 	auto [width, height] = Engine::window.framebuffer_size();
 
     glGenFramebuffers(1, &fb.fbo);
-    glBindFramebuffer(GL_FRAMEBUFFER, fb.fbo);
+    gl_state.bind_framebuffer(GL_FRAMEBUFFER, fb.fbo);
 
 	fb.tex_target = GET_TARGET(fb.samples);
 
@@ -164,26 +173,23 @@ uint32_t pge::create_color_buffer(GlFramebuffer &fb)
 
 	if (fb.texture_count > 1)
 	{
-		GLuint attachments[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
-		glDrawBuffers(2, attachments);
+		GLuint attachments[PGE_GL_MAX_FB_TEXTURES];
+
+		for (int i = 0; i < fb.texture_count && i < PGE_GL_MAX_FB_TEXTURES; i++)
+		{
+			attachments[i] = GL_COLOR_ATTACHMENT0 + i;
+		}
+
+		glDrawBuffers(std::min(fb.texture_count, PGE_GL_MAX_FB_TEXTURES), attachments);
 	}
-//	GLuint attachment[PGE_GL_MAX_FB_TEXTURES];
-//
-//	for (int i = 0; i < fb.texture_count && i < PGE_GL_MAX_FB_TEXTURES; i++)
-//	{
-//		attachment[i] = GL_COLOR_ATTACHMENT0 + i;
-//	}
-//
-//	glDrawBuffers(fb.texture_count, attachment);
 
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
     {
         return OPENGL_ERROR_FRAMEBUFFER_CREATION;
     }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    gl_state.bind_framebuffer(GL_FRAMEBUFFER, 0);
 	glBindRenderbuffer(GL_RENDERBUFFER, 0);
-	glBindTexture(fb.tex_target, 0);
 
 	fb.m_on_resize_con = Engine::window.on_framebuffer_resize.connect(&fb, &GlFramebuffer::on_resize);
 
@@ -5,16 +5,18 @@
 #include "../../application/engine.hpp"
 #include "../../application/window_interface.hpp"
 
-#define PGE_GL_MAX_FB_TEXTURES 2
+#define PGE_GL_MAX_FB_TEXTURES 4
 
 namespace pge
 {
     struct GlFramebuffer : public IFramebuffer
     {
-        GLuint fbo;
-        GLuint rbo;
+        GLuint fbo = 0;
+        GLuint rbo = 0;
 		GLsizei texture_count = 1;
         GLuint textures[PGE_GL_MAX_FB_TEXTURES];
+		// the internal format of each attachment, 0 uses internal_format
+		GLuint texture_formats[PGE_GL_MAX_FB_TEXTURES] {};
 		GLsizei samples = 0;
 		GLuint tex_target = GL_TEXTURE_2D;
 		GLuint internal_format = GL_RGB16F;
@@ -0,0 +1,280 @@
+#include "gl_mesh_pool.hpp"
+
+#include <glm/gtc/packing.hpp>
+
+#include "opengl_error.hpp"
+#include "gl_buffers.hpp"
+#include "gl_state.hpp"
+#include "../../application/log.hpp"
+
+pge::GlMeshPool::~GlMeshPool()
+{
+	glDeleteVertexArrays(1, &vao);
+	glDeleteBuffers(1, &m_vbo);
+	glDeleteBuffers(1, &m_ebo);
+
+	gl_state.forget_vertex_array(vao);
+}
+
+uint32_t pge::GlMeshPool::init(size_t vertex_capacity, size_t index_capacity, VertexFormat format)
+{
+	m_format = format;
+	m_vertex_size = format == VertexFormat::Packed ? sizeof(PackedVertex) : sizeof(Vertex);
+
+	glGenVertexArrays(1, &vao);
+
+	reallocate(vertex_capacity, index_capacity);
+
+	return OPENGL_ERROR_OK;
+}
+
+pge::PackedVertex pack_vertex(const pge::Vertex &vertex, glm::vec3 offset, glm::vec3 scale)
+{
+	pge::PackedVertex output {};
+
+	auto position = glm::clamp((vertex.position - offset) / scale, 0.0f, 1.0f);
+
+	for (int i = 0; i < 3; i++)
+	{
+		output.position[i] = (uint16_t)glm::round(position[i] * 65535.0f);
+	}
+
+	auto bitangent_sign = glm::dot(glm::cross(vertex.normal, vertex.tangent), vertex.bitangent) < 0 ? -1.0f : 1.0f;
+
+	output.normal  = glm::packSnorm3x10_1x2(glm::vec4{vertex.normal, 0.0f});
+	output.tangent = glm::packSnorm3x10_1x2(glm::vec4{vertex.tangent, bitangent_sign});
+	output.coord   = glm::packHalf2x16(vertex.coord);
+
+	return output;
+}
+
+// the capacity needed to fit size more items, doubling the current capacity until it does
+size_t grow_capacity(const pge::FreeList &list, size_t size)
+{
+	auto capacity = list.capacity();
+	auto used = capacity - list.free_space();
+
+	while (used + size > capacity)
+	{
+		capacity *= 2;
+	}
+
+	return capacity;
+}
+
+uint32_t pge::GlMeshPool::create(std::span<const Vertex> vertices, std::span<const uint32_t> indices,
+	std::span<const MeshLod> lods)
+{
+	std::array<GlLodRange, MAX_MESH_LODS> lod_ranges {};
+	uint32_t lod_count = 0;
+	uint32_t index_count = 0;
+
+	auto add_lod = [&](std::span<const uint32_t> lod_indices)
+	{
+		lod_ranges[lod_count++] = {index_count, (uint32_t)lod_indices.size()};
+		index_count += lod_indices.size();
+	};
+
+	add_lod(indices);
+
+	for (auto &lod : lods.first(std::min<size_t>(lods.size(), MAX_MESH_LODS - 1)))
+	{
+		add_lod(lod.indices);
+	}
+
+	auto vertex_offset = m_vertices.allocate(vertices.size());
+	auto index_offset = m_indices.allocate(index_count);
+
+	if (vertex_offset == FreeList::INVALID || index_offset == FreeList::INVALID)
+	{
+		if (vertex_offset != FreeList::INVALID)
+		{
+			m_vertices.free(vertex_offset, vertices.size());
+		}
+		if (index_offset != FreeList::INVALID)
+		{
+			m_indices.free(index_offset, index_count);
+		}
+
+		auto vertex_capacity = grow_capacity(m_vertices, vertices.size());
+		auto index_capacity = grow_capacity(m_indices, index_count);
+
+		if (vertex_capacity != m_vertices.capacity() || index_capacity != m_indices.capacity())
+		{
+			Logger::info("growing mesh pool to {} vertices and {} indices", vertex_capacity, index_capacity);
+		}
+
+		// also packs the existing meshes so a fragmented pool gets defragmented instead of growing
+		reallocate(vertex_capacity, index_capacity);
+
+		vertex_offset = m_vertices.allocate(vertices.size());
+		index_offset = m_indices.allocate(index_count);
+	}
+
+	glm::vec3 position_offset {0.0f};
+	glm::vec3 position_scale {1.0f};
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_vbo);
+
+	if (m_format == VertexFormat::Packed)
+	{
+		auto bounds = calculate_bounds(vertices);
+
+		position_offset = bounds.min;
+		// a flat axis would divide by zero
+		position_scale = glm::max(bounds.max - bounds.min, glm::vec3{1e-6f});
+
+		m_packed.clear();
+
+		for (const auto &vertex : vertices)
+		{
+			m_packed.push_back(pack_vertex(vertex, position_offset, position_scale));
+		}
+
+		glBufferSubData(GL_COPY_WRITE_BUFFER, vertex_offset * m_vertex_size, m_packed.size() * m_vertex_size,
+			m_packed.data());
+	}
+	else
+	{
+		glBufferSubData(GL_COPY_WRITE_BUFFER, vertex_offset * m_vertex_size, vertices.size_bytes(), vertices.data());
+	}
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_ebo);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, index_offset * sizeof(uint32_t), indices.size_bytes(), indices.data());
+
+	for (uint32_t i = 1; i < lod_count; i++)
+	{
+		auto &lod = lods[i - 1].indices;
+
+		glBufferSubData(GL_COPY_WRITE_BUFFER, (index_offset + lod_ranges[i].offset) * sizeof(uint32_t),
+			lod.size() * sizeof(uint32_t), lod.data());
+	}
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	GlMeshRange range
+	{
+		.base_vertex  = (uint32_t)vertex_offset,
+		.vertex_count = (uint32_t)vertices.size(),
+		.first_index  = (uint32_t)index_offset,
+		.index_count  = index_count,
+		.lods 		  = lod_ranges,
+		.lod_count 	  = lod_count,
+		.position_offset = position_offset,
+		.position_scale  = position_scale,
+		.in_use 	  = true,
+	};
+
+	return m_ranges.create(range);
+}
+
+void pge::GlMeshPool::remove(uint32_t id)
+{
+	if (!valid_id(id))
+	{
+		return;
+	}
+
+	auto &range = m_ranges.get(id);
+
+	m_vertices.free(range.base_vertex, range.vertex_count);
+	m_indices.free(range.first_index, range.index_count);
+
+	range.in_use = false;
+
+	m_ranges.remove(id);
+}
+
+void pge::GlMeshPool::defragment()
+{
+	if (m_vertices.fragments() <= 1 && m_indices.fragments() <= 1)
+	{
+		return;
+	}
+
+	reallocate(m_vertices.capacity(), m_indices.capacity());
+}
+
+void pge::GlMeshPool::reallocate(size_t vertex_capacity, size_t index_capacity)
+{
+	GLuint vbo;
+	GLuint ebo;
+
+	glGenBuffers(1, &vbo);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+	glBufferData(GL_COPY_WRITE_BUFFER, vertex_capacity * m_vertex_size, nullptr, GL_STATIC_DRAW);
+
+	glGenBuffers(1, &ebo);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, ebo);
+	glBufferData(GL_COPY_WRITE_BUFFER, index_capacity * sizeof(uint32_t), nullptr, GL_STATIC_DRAW);
+
+	m_vertices.reset(vertex_capacity);
+	m_indices.reset(index_capacity);
+
+	for (size_t id = 0; id < m_ranges.size(); id++)
+	{
+		auto &range = m_ranges.get(id);
+
+		if (!range.in_use)
+		{
+			continue;
+		}
+
+		auto vertex_offset = m_vertices.allocate(range.vertex_count);
+		auto index_offset = m_indices.allocate(range.index_count);
+
+		glBindBuffer(GL_COPY_READ_BUFFER, m_vbo);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, range.base_vertex * m_vertex_size,
+			vertex_offset * m_vertex_size, range.vertex_count * m_vertex_size);
+
+		glBindBuffer(GL_COPY_READ_BUFFER, m_ebo);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, ebo);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, range.first_index * sizeof(uint32_t),
+			index_offset * sizeof(uint32_t), range.index_count * sizeof(uint32_t));
+
+		range.base_vertex = vertex_offset;
+		range.first_index = index_offset;
+	}
+
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	glDeleteBuffers(1, &m_vbo);
+	glDeleteBuffers(1, &m_ebo);
+
+	m_vbo = vbo;
+	m_ebo = ebo;
+
+	set_attributes();
+}
+
+void pge::GlMeshPool::set_attributes()
+{
+	gl_state.bind_vertex_array(vao);
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+
+	if (m_format == VertexFormat::Packed)
+	{
+		auto stride = sizeof(PackedVertex);
+
+		set_vertex_attribute(0, 3, stride, offsetof(PackedVertex, position), GL_UNSIGNED_SHORT, true);
+		set_vertex_attribute(1, 4, stride, offsetof(PackedVertex, normal), GL_INT_2_10_10_10_REV, true);
+		set_vertex_attribute(2, 2, stride, offsetof(PackedVertex, coord), GL_HALF_FLOAT);
+		set_vertex_attribute(3, 4, stride, offsetof(PackedVertex, tangent), GL_INT_2_10_10_10_REV, true);
+	}
+	else
+	{
+		auto stride = sizeof(Vertex);
+
+		set_vertex_attribute(0, 3, stride, offsetof(Vertex, position));
+		set_vertex_attribute(1, 3, stride, offsetof(Vertex, normal));
+		set_vertex_attribute(2, 2, stride, offsetof(Vertex, coord));
+		set_vertex_attribute(3, 3, stride, offsetof(Vertex, tangent));
+		set_vertex_attribute(4, 3, stride, offsetof(Vertex, bitangent));
+	}
+
+	gl_state.bind_vertex_array(0);
+}
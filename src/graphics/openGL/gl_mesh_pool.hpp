@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <span>
+#include <glad/glad.h>
+
+#include "../model.hpp"
+#include "../renderer_structs.hpp"
+#include "../../data/free_list.hpp"
+#include "../../data/id_table.hpp"
+
+namespace pge
+{
+	// the indices of one lod, relative to the first index of the mesh
+	struct GlLodRange
+	{
+		uint32_t offset;
+		uint32_t count;
+	};
+
+	// where a mesh lives inside the shared vertex and index buffers
+	struct GlMeshRange
+	{
+		uint32_t base_vertex;
+		uint32_t vertex_count;
+		uint32_t first_index;
+		// the indices of every lod together
+		uint32_t index_count;
+		// the original indices followed by the simplified ones
+		std::array<GlLodRange, MAX_MESH_LODS> lods;
+		uint32_t lod_count;
+		// maps the stored positions back to mesh space, position = offset + stored * scale
+		glm::vec3 position_offset;
+		glm::vec3 position_scale;
+		bool in_use;
+	};
+
+	// the vertex layout used by VertexFormat::Packed
+	struct PackedVertex
+	{
+		// unsigned normalized position relative to the mesh bounds, the last value is padding
+		uint16_t position[4];
+		// signed normalized 10:10:10:2, the tangent w holds the sign of the bitangent
+		uint32_t normal;
+		uint32_t tangent;
+		// two half floats
+		uint32_t coord;
+	};
+
+	static_assert(sizeof(PackedVertex) == 20);
+
+	// the layout glMultiDrawElementsIndirect expects for every command
+	struct GlDrawCommand
+	{
+		uint32_t count;
+		uint32_t instance_count;
+		uint32_t first_index;
+		int32_t  base_vertex;
+		uint32_t base_instance;
+	};
+
+	// sub allocates every mesh from one vertex and one index buffer so they can all be drawn with a single vao.
+	// all meshes in the pool share the same vertex format
+	class GlMeshPool
+	{
+	public:
+		~GlMeshPool();
+
+		uint32_t init(size_t vertex_capacity, size_t index_capacity, VertexFormat format);
+
+		// copies the mesh and its lods into the pool and returns its id
+		uint32_t create(std::span<const Vertex> vertices, std::span<const uint32_t> indices,
+			std::span<const MeshLod> lods = {});
+
+		void remove(uint32_t id);
+
+		[[nodiscard]]
+		bool valid_id(uint32_t id)
+		{
+			return m_ranges.valid_id(id) && m_ranges.get(id).in_use;
+		}
+
+		const GlMeshRange& get(uint32_t id)
+		{
+			return m_ranges.get(id);
+		}
+
+		[[nodiscard]]
+		GlDrawCommand draw_command(uint32_t id, uint32_t lod = 0)
+		{
+			auto &range = m_ranges.get(id);
+			auto &indices = range.lods[std::min(lod, range.lod_count - 1)];
+
+			return
+			{
+				.count 			= indices.count,
+				.instance_count = 1,
+				.first_index 	= range.first_index + indices.offset,
+				.base_vertex 	= (int32_t)range.base_vertex,
+				.base_instance 	= 0,
+			};
+		}
+
+		// moves every mesh next to each other so the free space is one contiguous range
+		void defragment();
+
+		GLuint vao = 0;
+
+	private:
+		VertexFormat m_format = VertexFormat::Full;
+		size_t m_vertex_size = sizeof(Vertex);
+		// reused when packing vertices so uploads do not allocate every time
+		std::vector<PackedVertex> m_packed;
+		GLuint m_vbo = 0;
+		GLuint m_ebo = 0;
+		FreeList m_vertices;
+		FreeList m_indices;
+		IdTable<GlMeshRange> m_ranges;
+
+		// creates new buffers with the given capacities and copies every mesh into them packed together
+		void reallocate(size_t vertex_capacity, size_t index_capacity);
+
+		void set_attributes();
+	};
+}
@@ -0,0 +1,197 @@
+#include "gl_program_cache.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "../../application/log.hpp"
+#include "../../data/hash_table.hpp"
+
+#define PROGRAM_CACHE_DIRECTORY "shader_cache"
+// PGEP in little endian
+#define PROGRAM_CACHE_MAGIC 0x50454750u
+
+namespace
+{
+	struct BinaryHeader
+	{
+		uint32_t magic;
+		uint32_t format;
+		// the key is stored too so a hash collision of the file name is caught
+		uint64_t key;
+		uint64_t size;
+	};
+
+	uint64_t hash_bytes(uint64_t seed, const void *data, size_t size)
+	{
+		auto hash = ankerl::unordered_dense::detail::wyhash::hash(data, size);
+
+		return ankerl::unordered_dense::detail::wyhash::mix(seed ^ hash, UINT64_C(0x9E3779B97F4A7C15));
+	}
+}
+
+uint64_t pge::GlProgramCache::make_key(std::span<const std::string> sources)
+{
+	is_supported();
+
+	auto key = m_driver_hash;
+
+	for (auto &source : sources)
+	{
+		key = hash_bytes(key, source.data(), source.size());
+	}
+
+	return key;
+}
+
+void pge::GlProgramCache::prepare(GLuint program)
+{
+	glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+bool pge::GlProgramCache::load(uint64_t key, GLuint program)
+{
+	if (!is_supported())
+	{
+		m_misses++;
+		return false;
+	}
+
+	auto file = fopen(path_of(key).c_str(), "rb");
+
+	if (file == nullptr)
+	{
+		m_misses++;
+		return false;
+	}
+
+	BinaryHeader header {};
+	std::vector<char> binary;
+
+	auto ok = fread(&header, sizeof(header), 1, file) == 1
+		&& header.magic == PROGRAM_CACHE_MAGIC && header.key == key;
+
+	// a truncated or broken file must not make the cache allocate more than the file holds
+	if (ok)
+	{
+		auto position = ftell(file);
+
+		fseek(file, 0, SEEK_END);
+		auto remaining = uint64_t(ftell(file) - position);
+		fseek(file, position, SEEK_SET);
+
+		ok = header.size == remaining && header.size <= (uint64_t)std::numeric_limits<GLsizei>::max();
+	}
+
+	if (ok)
+	{
+		binary.resize(header.size);
+		ok = fread(binary.data(), 1, binary.size(), file) == binary.size();
+	}
+
+	fclose(file);
+
+	GLint linked = GL_FALSE;
+
+	if (ok)
+	{
+		glProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+		glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	}
+
+	// drivers are allowed to reject a binary they produced themselves, the program is then simply compiled
+	if (!linked)
+	{
+		m_misses++;
+		return false;
+	}
+
+	m_hits++;
+
+	return true;
+}
+
+void pge::GlProgramCache::save(uint64_t key, GLuint program)
+{
+	if (!is_supported())
+	{
+		return;
+	}
+
+	GLint size = 0;
+
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+
+	if (size <= 0)
+	{
+		return;
+	}
+
+	std::vector<char> binary(size);
+	GLenum format;
+
+	glGetProgramBinary(program, size, &size, &format, binary.data());
+
+	std::error_code error;
+	std::filesystem::create_directories(PROGRAM_CACHE_DIRECTORY, error);
+
+	auto path = path_of(key);
+	auto file = fopen(path.c_str(), "wb");
+
+	if (file == nullptr)
+	{
+		Logger::warn("could not write the program binary {}", path.string());
+		return;
+	}
+
+	BinaryHeader header {PROGRAM_CACHE_MAGIC, format, key, (uint64_t)size};
+
+	auto ok = fwrite(&header, sizeof(header), 1, file) == 1
+		&& fwrite(binary.data(), 1, size, file) == (size_t)size;
+
+	fclose(file);
+
+	// a partly written binary would only be rejected on every later run
+	if (!ok)
+	{
+		std::filesystem::remove(path, error);
+	}
+}
+
+bool pge::GlProgramCache::is_supported()
+{
+	if (m_checked)
+	{
+		return m_supported;
+	}
+
+	m_checked = true;
+
+	GLint formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+
+	m_supported = formats > 0;
+
+	for (auto name : {GL_VENDOR, GL_RENDERER, GL_VERSION})
+	{
+		auto *value = (const char*)glGetString(name);
+
+		if (value != nullptr)
+		{
+			m_driver_hash = hash_bytes(m_driver_hash, value, strlen(value));
+		}
+	}
+
+	if (!m_supported)
+	{
+		Logger::info("the driver has no program binary formats, programs are always compiled");
+	}
+
+	return m_supported;
+}
+
+std::filesystem::path pge::GlProgramCache::path_of(uint64_t key)
+{
+	return std::filesystem::path(PROGRAM_CACHE_DIRECTORY) / fmt::format("{:016x}.bin", key);
+}
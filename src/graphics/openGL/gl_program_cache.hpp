@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+
+#include <glad/glad.h>
+
+namespace pge
+{
+	// keeps the binaries of linked programs on disk so later runs can skip compiling and linking.
+	// a binary is keyed by its sources and the driver that built it, a new driver or an edited
+	// shader simply misses and the program is compiled again
+	class GlProgramCache
+	{
+	public:
+		// the key of a program built from the sources, which already contain their defines
+		[[nodiscard]]
+		uint64_t make_key(std::span<const std::string> sources);
+
+		// has to be called before the program is linked so the driver keeps the binary around
+		static void prepare(GLuint program);
+
+		// returns false when there is no usable binary, the program then has to be built from source
+		bool load(uint64_t key, GLuint program);
+
+		// stores the binary of a linked program
+		void save(uint64_t key, GLuint program);
+
+		// programs loaded from disk and programs that had to be compiled since startup
+		[[nodiscard]]
+		uint32_t hits() const
+		{
+			return m_hits;
+		}
+
+		[[nodiscard]]
+		uint32_t misses() const
+		{
+			return m_misses;
+		}
+
+	private:
+		// drivers without any binary format cannot use the cache
+		bool m_checked = false;
+		bool m_supported = false;
+		// the vendor, renderer and version strings of the driver
+		uint64_t m_driver_hash = 0;
+		uint32_t m_hits = 0;
+		uint32_t m_misses = 0;
+
+		bool is_supported();
+
+		[[nodiscard]]
+		static std::filesystem::path path_of(uint64_t key);
+	};
+
+	inline GlProgramCache gl_program_cache;
+}
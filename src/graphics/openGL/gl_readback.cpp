@@ -0,0 +1,146 @@
+#include "gl_readback.hpp"
+
+#include <cstring>
+
+#include "gl_state.hpp"
+
+pge::GlReadback::~GlReadback()
+{
+	for (auto &slot : m_slots)
+	{
+		if (slot.fence != nullptr)
+		{
+			glDeleteSync(slot.fence);
+		}
+
+		glDeleteBuffers(1, &slot.pbo);
+	}
+}
+
+void pge::GlReadback::read(GLuint fbo, GLenum buffer, int width, int height, ImageCallback callback)
+{
+	auto &slot = m_slots[m_next];
+
+	// every slot is in flight, the oldest read has to be done before its buffer can be used again
+	if (slot.fence != nullptr)
+	{
+		complete(slot, true);
+	}
+
+	m_next = (m_next + 1) % SLOTS;
+
+	auto size = (size_t)width * height * 3;
+
+	if (slot.pbo == 0)
+	{
+		glGenBuffers(1, &slot.pbo);
+	}
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+
+	if (slot.capacity < size)
+	{
+		glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+		slot.capacity = size;
+	}
+
+	gl_state.bind_framebuffer(GL_READ_FRAMEBUFFER, fbo);
+	glReadBuffer(buffer);
+
+	// rgb rows are not a multiple of 4 bytes for most widths
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+	// with a pack buffer bound the pointer is an offset and the copy happens on the gpu timeline
+	glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	gl_state.bind_framebuffer(GL_READ_FRAMEBUFFER, 0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.width = width;
+	slot.height = height;
+	slot.callback = std::move(callback);
+}
+
+void pge::GlReadback::poll(bool wait)
+{
+	for (size_t i = 0; i < SLOTS; i++)
+	{
+		auto &slot = m_slots[(m_next + i) % SLOTS];
+
+		if (slot.fence == nullptr)
+		{
+			continue;
+		}
+
+		// later reads wait for the earlier ones so images of the same file are saved in order
+		if (!complete(slot, wait))
+		{
+			break;
+		}
+	}
+}
+
+size_t pge::GlReadback::pending() const
+{
+	size_t count = 0;
+
+	for (auto &slot : m_slots)
+	{
+		count += slot.fence != nullptr;
+	}
+
+	return count;
+}
+
+bool pge::GlReadback::complete(Slot &slot, bool wait)
+{
+	auto result = glClientWaitSync(slot.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, 0);
+
+	if (!wait && result == GL_TIMEOUT_EXPIRED)
+	{
+		return false;
+	}
+
+	while (result == GL_TIMEOUT_EXPIRED)
+	{
+		result = glClientWaitSync(slot.fence, 0, 1'000'000);
+	}
+
+	glDeleteSync(slot.fence);
+	slot.fence = nullptr;
+
+	Image image;
+
+	image.width = slot.width;
+	image.height = slot.height;
+	image.channels = 3;
+
+	auto size = (size_t)slot.width * slot.height * 3;
+
+	image.data.resize(size);
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+
+	auto *pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+
+	if (pixels != nullptr)
+	{
+		std::memcpy(image.data.data(), pixels, size);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	auto callback = std::move(slot.callback);
+
+	slot.callback = nullptr;
+
+	if (callback && pixels != nullptr)
+	{
+		callback(std::move(image));
+	}
+
+	return true;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include <glad/glad.h>
+
+#include "../image.hpp"
+
+namespace pge
+{
+	// copies framebuffers into pixel buffers without waiting for the gpu to render them.
+	// every read gets a fence and is handed to its callback by poll once the fence signaled,
+	// usually a frame or two later
+	class GlReadback
+	{
+	public:
+		// reads in flight at once, a read past this waits for the oldest one
+		static constexpr size_t SLOTS = 3;
+
+		~GlReadback();
+
+		// starts copying the rgb pixels of a color buffer of the framebuffer
+		void read(GLuint fbo, GLenum buffer, int width, int height, ImageCallback callback);
+
+		// hands finished reads to their callbacks in the order they were started.
+		// with wait set it blocks until every read finished
+		void poll(bool wait = false);
+
+		[[nodiscard]]
+		size_t pending() const;
+
+	private:
+		struct Slot
+		{
+			GLuint pbo = 0;
+			size_t capacity = 0;
+			GLsync fence = nullptr;
+			int width = 0;
+			int height = 0;
+			ImageCallback callback;
+		};
+
+		std::array<Slot, SLOTS> m_slots;
+		// the slot the next read goes into, also the oldest read in flight
+		size_t m_next = 0;
+
+		// returns false if the read is still running and wait is not set
+		bool complete(Slot &slot, bool wait);
+	};
+}
@@ -0,0 +1,141 @@
+#include "gl_ring_buffer.hpp"
+
+#include <bit>
+
+#include "opengl_error.hpp"
+#include "../../application/log.hpp"
+
+pge::GlRingBuffer::~GlRingBuffer()
+{
+	destroy();
+}
+
+uint32_t pge::GlRingBuffer::init(size_t frame_size)
+{
+	if (!create(frame_size))
+	{
+		destroy();
+		return OPENGL_ERROR_BUFFER_MAPPING;
+	}
+
+	return OPENGL_ERROR_OK;
+}
+
+void pge::GlRingBuffer::begin_frame()
+{
+	m_frame = (m_frame + 1) % FRAMES;
+	m_head = 0;
+
+	wait(m_frame);
+}
+
+void pge::GlRingBuffer::end_frame()
+{
+	if (m_fences[m_frame] != nullptr)
+	{
+		glDeleteSync(m_fences[m_frame]);
+	}
+
+	m_fences[m_frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void pge::GlRingBuffer::reserve(size_t size)
+{
+	if (m_head + size <= m_frame_size)
+	{
+		return;
+	}
+
+	// the other sections may still be read by the gpu
+	for (size_t frame = 0; frame < FRAMES; frame++)
+	{
+		wait(frame);
+	}
+
+	destroy();
+
+	// without a mapping every allocation fails, the frame is drawn without what did not fit
+	if (!create(m_head + size))
+	{
+		Logger::warn("could not map a ring buffer of {} bytes per frame", m_frame_size);
+		destroy();
+	}
+}
+
+pge::GlRingAllocation pge::GlRingBuffer::allocate(size_t size, size_t alignment)
+{
+	auto start = m_frame * m_frame_size;
+	auto offset = (start + m_head + alignment - 1) / alignment * alignment;
+
+	if (m_mapped == nullptr || offset + size > start + m_frame_size)
+	{
+		return {nullptr, 0, 0};
+	}
+
+	m_head = offset + size - start;
+
+	return {m_mapped + offset, offset, size};
+}
+
+bool pge::GlRingBuffer::create(size_t frame_size)
+{
+	m_frame_size = std::bit_ceil(frame_size);
+	m_head = 0;
+
+	auto flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+	glBufferStorage(GL_COPY_WRITE_BUFFER, m_frame_size * FRAMES, nullptr, flags);
+
+	m_mapped = (uint8_t*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, m_frame_size * FRAMES, flags);
+
+	return m_mapped != nullptr;
+}
+
+void pge::GlRingBuffer::destroy()
+{
+	for (auto &fence : m_fences)
+	{
+		if (fence != nullptr)
+		{
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+
+	if (buffer != 0)
+	{
+		if (m_mapped != nullptr)
+		{
+			glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+			glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+		}
+
+		glDeleteBuffers(1, &buffer);
+	}
+
+	buffer = 0;
+	m_mapped = nullptr;
+}
+
+void pge::GlRingBuffer::wait(size_t frame)
+{
+	auto fence = m_fences[frame];
+
+	if (fence == nullptr)
+	{
+		return;
+	}
+
+	// the first wait flushes so the fence is guaranteed to signal
+	auto result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+
+	while (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED && result != GL_WAIT_FAILED)
+	{
+		result = glClientWaitSync(fence, 0, 1'000'000);
+	}
+
+	glDeleteSync(fence);
+	m_fences[frame] = nullptr;
+}
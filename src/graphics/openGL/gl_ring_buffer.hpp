@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <span>
+
+#include <glad/glad.h>
+
+namespace pge
+{
+	// a region of the ring buffer written by the cpu this frame
+	struct GlRingAllocation
+	{
+		void *data;
+		// offset from the start of the buffer, used with glBindBufferRange or as an indirect offset
+		size_t offset;
+		size_t size;
+	};
+
+	// one persistently mapped buffer split into a section per frame in flight.
+	// every frame allocates linearly from its own section, a fence placed at the end of the frame
+	// makes sure the gpu is done with a section before the cpu writes into it again
+	class GlRingBuffer
+	{
+	public:
+		static constexpr size_t FRAMES = 3;
+
+		~GlRingBuffer();
+
+		uint32_t init(size_t frame_size);
+
+		// waits until the gpu is done with the next section and starts allocating from it
+		void begin_frame();
+
+		// fences the current section
+		void end_frame();
+
+		// makes sure at least size bytes can be allocated this frame, the buffer grows if they cannot.
+		// must be called before anything is allocated in the frame since growing replaces the buffer
+		void reserve(size_t size);
+
+		// returns a region with data set to nullptr when the section is full
+		[[nodiscard]]
+		GlRingAllocation allocate(size_t size, size_t alignment);
+
+		template<class T>
+		GlRingAllocation write(std::span<const T> values, size_t alignment)
+		{
+			auto allocation = allocate(values.size_bytes(), alignment);
+
+			if (allocation.data != nullptr)
+			{
+				std::memcpy(allocation.data, values.data(), values.size_bytes());
+			}
+
+			return allocation;
+		}
+
+		template<class T>
+		GlRingAllocation write(const T &value, size_t alignment)
+		{
+			return write(std::span<const T>(&value, 1), alignment);
+		}
+
+		[[nodiscard]]
+		size_t frame_size() const
+		{
+			return m_frame_size;
+		}
+
+		GLuint buffer = 0;
+
+	private:
+		uint8_t *m_mapped = nullptr;
+		size_t m_frame_size = 0;
+		size_t m_frame = 0;
+		// offset into the current section
+		size_t m_head = 0;
+		std::array<GLsync, FRAMES> m_fences {};
+
+		// false if the buffer could not be mapped
+		bool create(size_t frame_size);
+		void destroy();
+		void wait(size_t frame);
+	};
+}
@@ -0,0 +1,320 @@
+#include "gl_state.hpp"
+
+static int texture_target_index(GLenum target)
+{
+	switch (target)
+	{
+		case GL_TEXTURE_2D: return 0;
+		case GL_TEXTURE_2D_MULTISAMPLE: return 1;
+		case GL_TEXTURE_2D_ARRAY: return 2;
+		case GL_TEXTURE_CUBE_MAP: return 3;
+		default: return -1;
+	}
+}
+
+static int capability_index(GLenum capability)
+{
+	switch (capability)
+	{
+		case GL_BLEND: return 0;
+		case GL_CULL_FACE: return 1;
+		case GL_DEPTH_TEST: return 2;
+		case GL_STENCIL_TEST: return 3;
+		case GL_POLYGON_OFFSET_FILL: return 4;
+		case GL_SCISSOR_TEST: return 5;
+		default: return -1;
+	}
+}
+
+void pge::GlState::invalidate()
+{
+	m_program = UNKNOWN;
+	m_vao = UNKNOWN;
+	m_draw_framebuffer = UNKNOWN;
+	m_read_framebuffer = UNKNOWN;
+	m_active_unit = UNKNOWN;
+
+	for (auto &unit : m_textures)
+	{
+		unit.fill(UNKNOWN);
+	}
+
+	m_capabilities.fill(UINT8_MAX);
+	m_blend_func.fill(UNKNOWN);
+	m_depth_func = UNKNOWN;
+	m_depth_mask = UINT8_MAX;
+	m_color_mask = UINT8_MAX;
+	m_stencil_func = {UNKNOWN};
+	m_stencil_mask = UNKNOWN;
+	m_stencil_op.fill(UNKNOWN);
+	m_cull_face = UNKNOWN;
+	m_polygon_mode = UNKNOWN;
+	m_viewport.fill(-1);
+
+	// the anisotropy of a texture is only ever set through here so it stays known
+}
+
+void pge::GlState::use_program(GLuint program)
+{
+	if (update(m_program, program))
+	{
+		glUseProgram(program);
+	}
+}
+
+void pge::GlState::bind_vertex_array(GLuint vao)
+{
+	if (update(m_vao, vao))
+	{
+		glBindVertexArray(vao);
+	}
+}
+
+void pge::GlState::set_active_unit(uint32_t unit)
+{
+	if (update(m_active_unit, unit))
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+	}
+}
+
+void pge::GlState::bind_texture(uint32_t unit, GLenum target, GLuint texture)
+{
+	auto index = texture_target_index(target);
+
+	if (unit >= TEXTURE_UNITS || index < 0)
+	{
+		m_active_unit = unit;
+		m_issued += 2;
+
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(target, texture);
+		return;
+	}
+
+	auto &bound = m_textures[unit][index];
+
+	if (bound == texture)
+	{
+		m_filtered++;
+		return;
+	}
+
+	set_active_unit(unit);
+
+	bound = texture;
+	m_issued++;
+
+	glBindTexture(target, texture);
+}
+
+void pge::GlState::edit_texture(GLenum target, GLuint texture)
+{
+	bind_texture(0, target, texture);
+	set_active_unit(0);
+}
+
+void pge::GlState::bind_framebuffer(GLenum target, GLuint fbo)
+{
+	if (target == GL_FRAMEBUFFER)
+	{
+		if (m_draw_framebuffer == fbo && m_read_framebuffer == fbo)
+		{
+			m_filtered++;
+			return;
+		}
+
+		m_draw_framebuffer = fbo;
+		m_read_framebuffer = fbo;
+		m_issued++;
+
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		return;
+	}
+
+	auto &cached = target == GL_READ_FRAMEBUFFER ? m_read_framebuffer : m_draw_framebuffer;
+
+	if (update(cached, fbo))
+	{
+		glBindFramebuffer(target, fbo);
+	}
+}
+
+void pge::GlState::set_enabled(GLenum capability, bool enabled)
+{
+	auto index = capability_index(capability);
+
+	if (index >= 0 && !update(m_capabilities[index], (uint8_t)enabled))
+	{
+		return;
+	}
+
+	if (index < 0)
+	{
+		m_issued++;
+	}
+
+	if (enabled)
+	{
+		glEnable(capability);
+	}
+	else
+	{
+		glDisable(capability);
+	}
+}
+
+void pge::GlState::blend_func(GLenum source, GLenum destination)
+{
+	if (update(m_blend_func, {source, destination}))
+	{
+		glBlendFunc(source, destination);
+	}
+}
+
+void pge::GlState::blend_func(GLuint buffer, GLenum source, GLenum destination)
+{
+	m_blend_func.fill(UNKNOWN);
+	m_issued++;
+
+	glBlendFunci(buffer, source, destination);
+}
+
+void pge::GlState::depth_func(GLenum func)
+{
+	if (update(m_depth_func, func))
+	{
+		glDepthFunc(func);
+	}
+}
+
+void pge::GlState::depth_mask(bool enabled)
+{
+	if (update(m_depth_mask, (uint8_t)enabled))
+	{
+		glDepthMask(enabled);
+	}
+}
+
+void pge::GlState::color_mask(bool enabled)
+{
+	if (update(m_color_mask, (uint8_t)enabled))
+	{
+		glColorMask(enabled, enabled, enabled, enabled);
+	}
+}
+
+void pge::GlState::stencil_func(GLenum func, GLint reference, GLuint mask)
+{
+	if (update(m_stencil_func, {func, reference, mask}))
+	{
+		glStencilFunc(func, reference, mask);
+	}
+}
+
+void pge::GlState::stencil_mask(GLuint mask)
+{
+	if (update(m_stencil_mask, mask))
+	{
+		glStencilMask(mask);
+	}
+}
+
+void pge::GlState::stencil_op(GLenum stencil_fail, GLenum depth_fail, GLenum pass)
+{
+	if (update(m_stencil_op, {stencil_fail, depth_fail, pass}))
+	{
+		glStencilOp(stencil_fail, depth_fail, pass);
+	}
+}
+
+void pge::GlState::cull_face(GLenum face)
+{
+	if (update(m_cull_face, face))
+	{
+		glCullFace(face);
+	}
+}
+
+void pge::GlState::polygon_mode(GLenum mode)
+{
+	if (update(m_polygon_mode, mode))
+	{
+		glPolygonMode(GL_FRONT_AND_BACK, mode);
+	}
+}
+
+void pge::GlState::viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	if (update(m_viewport, {x, y, width, height}))
+	{
+		glViewport(x, y, width, height);
+	}
+}
+
+void pge::GlState::texture_anisotropy(GLuint texture, float level)
+{
+	if (texture == 0)
+	{
+		return;
+	}
+
+	auto [iter, inserted] = m_anisotropy.try_emplace(texture, level);
+
+	if (!inserted && !update(iter->second, level))
+	{
+		return;
+	}
+
+	if (inserted)
+	{
+		m_issued++;
+	}
+
+	glTextureParameterf(texture, GL_TEXTURE_MAX_ANISOTROPY_EXT, level);
+}
+
+void pge::GlState::forget_program(GLuint program)
+{
+	if (m_program == program)
+	{
+		m_program = UNKNOWN;
+	}
+}
+
+void pge::GlState::forget_vertex_array(GLuint vao)
+{
+	if (m_vao == vao)
+	{
+		m_vao = UNKNOWN;
+	}
+}
+
+void pge::GlState::forget_texture(GLuint texture)
+{
+	for (auto &unit : m_textures)
+	{
+		for (auto &bound : unit)
+		{
+			if (bound == texture)
+			{
+				bound = UNKNOWN;
+			}
+		}
+	}
+
+	m_anisotropy.erase(texture);
+}
+
+void pge::GlState::forget_framebuffer(GLuint fbo)
+{
+	if (m_draw_framebuffer == fbo)
+	{
+		m_draw_framebuffer = UNKNOWN;
+	}
+
+	if (m_read_framebuffer == fbo)
+	{
+		m_read_framebuffer = UNKNOWN;
+	}
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <glad/glad.h>
+
+#include "../../data/hash_table.hpp"
+
+namespace pge
+{
+	// remembers the state the renderer set on the gl context and drops calls that would not change it.
+	// everything that binds or sets tracked state has to go through here, state changed behind its back
+	// is only picked up again after invalidate
+	class GlState
+	{
+	public:
+		// texture units the bindings are tracked for, units past this are always bound
+		static constexpr uint32_t TEXTURE_UNITS = 32;
+
+		GlState()
+		{
+			invalidate();
+		}
+
+		// forgets every value so the next call of each setter reaches the driver.
+		// used once per frame since imgui and other libraries change the state on their own
+		void invalidate();
+
+		void use_program(GLuint program);
+
+		void bind_vertex_array(GLuint vao);
+
+		// binds the texture to the unit, the active unit only changes when the binding does
+		void bind_texture(uint32_t unit, GLenum target, GLuint texture);
+
+		// binds the texture to unit 0 and makes it the active unit so glTex* calls that follow change it
+		void edit_texture(GLenum target, GLuint texture);
+
+		// GL_FRAMEBUFFER binds both the draw and read framebuffer
+		void bind_framebuffer(GLenum target, GLuint fbo);
+
+		void set_enabled(GLenum capability, bool enabled);
+
+		void enable(GLenum capability)
+		{
+			set_enabled(capability, true);
+		}
+
+		void disable(GLenum capability)
+		{
+			set_enabled(capability, false);
+		}
+
+		void blend_func(GLenum source, GLenum destination);
+
+		// sets the function of one draw buffer, the function shared by all of them is unknown afterwards
+		void blend_func(GLuint buffer, GLenum source, GLenum destination);
+
+		void depth_func(GLenum func);
+
+		void depth_mask(bool enabled);
+
+		void color_mask(bool enabled);
+
+		void stencil_func(GLenum func, GLint reference, GLuint mask);
+
+		void stencil_mask(GLuint mask);
+
+		void stencil_op(GLenum stencil_fail, GLenum depth_fail, GLenum pass);
+
+		void cull_face(GLenum face);
+
+		void polygon_mode(GLenum mode);
+
+		void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+		// set with glTextureParameterf so the texture does not have to be bound, ignored for texture 0
+		void texture_anisotropy(GLuint texture, float level);
+
+		// deleted names can be handed out again by the driver so they must not stay cached
+		void forget_program(GLuint program);
+		void forget_vertex_array(GLuint vao);
+		void forget_texture(GLuint texture);
+		void forget_framebuffer(GLuint fbo);
+
+		// the calls that reached the driver and the ones dropped since the last reset
+		[[nodiscard]]
+		uint32_t issued() const
+		{
+			return m_issued;
+		}
+
+		[[nodiscard]]
+		uint32_t filtered() const
+		{
+			return m_filtered;
+		}
+
+		void reset_counts()
+		{
+			m_issued = 0;
+			m_filtered = 0;
+		}
+
+	private:
+		static constexpr GLuint UNKNOWN = UINT32_MAX;
+
+		// 2d, multisampled 2d, 2d array and cube map bindings are tracked, others are always bound
+		static constexpr size_t TEXTURE_TARGETS = 4;
+		// blend, cull face, depth test, stencil test, polygon offset fill and scissor test
+		static constexpr size_t CAPABILITIES = 6;
+
+		struct StencilFunc
+		{
+			GLenum func;
+			GLint reference;
+			GLuint mask;
+
+			bool operator==(const StencilFunc&) const = default;
+		};
+
+		GLuint m_program = UNKNOWN;
+		GLuint m_vao = UNKNOWN;
+		GLuint m_draw_framebuffer = UNKNOWN;
+		GLuint m_read_framebuffer = UNKNOWN;
+		GLuint m_active_unit = UNKNOWN;
+		std::array<std::array<GLuint, TEXTURE_TARGETS>, TEXTURE_UNITS> m_textures;
+		// 0 and 1 for disabled and enabled, anything else is unknown
+		std::array<uint8_t, CAPABILITIES> m_capabilities;
+		std::array<GLenum, 2> m_blend_func;
+		GLenum m_depth_func = UNKNOWN;
+		uint8_t m_depth_mask = UINT8_MAX;
+		uint8_t m_color_mask = UINT8_MAX;
+		StencilFunc m_stencil_func {UNKNOWN};
+		GLuint m_stencil_mask = UNKNOWN;
+		std::array<GLenum, 3> m_stencil_op;
+		GLenum m_cull_face = UNKNOWN;
+		GLenum m_polygon_mode = UNKNOWN;
+		std::array<GLint, 4> m_viewport;
+		HashMap<GLuint, float> m_anisotropy;
+
+		uint32_t m_issued = 0;
+		uint32_t m_filtered = 0;
+
+		// stores the value and counts the call, returns false if it was already set
+		template<typename T>
+		bool update(T &cached, const T &value)
+		{
+			if (cached == value)
+			{
+				m_filtered++;
+				return false;
+			}
+
+			cached = value;
+			m_issued++;
+
+			return true;
+		}
+
+		void set_active_unit(uint32_t unit);
+	};
+
+	// there is one gl context so there is one state shared by the renderer and everything it owns
+	inline GlState gl_state;
+}
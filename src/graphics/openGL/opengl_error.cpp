@@ -9,8 +9,9 @@ constexpr std::array ERROR_MESSAGES
     "Could not load the glad library",
     "Could not create shader",
     "Could not load or generate texture",
-    "could not find the specified mesh"
+    "could not find the specified mesh",
     "Could not create framebuffer",
+    "Could not map buffer",
 };
 
 std::string_view pge::opengl_error_message(OpenGlErrorCode code)
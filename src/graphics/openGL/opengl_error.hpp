@@ -13,6 +13,7 @@ namespace pge
         OPENGL_ERROR_TEXTURE_LOADING,
         OPENGL_ERROR_MESH_NOT_FOUND,
         OPENGL_ERROR_FRAMEBUFFER_CREATION,
+        OPENGL_ERROR_BUFFER_MAPPING,
     };
 
     std::string_view opengl_error_message(OpenGlErrorCode code);
@@ -12,12 +12,56 @@
 #include "../light.hpp"
 
 #include <glm/gtx/norm.hpp>
-#include <ranges>
+#include <algorithm>
+#include <bit>
+#include <limits>
 
 #include "../primitives.hpp"
 #include "../../data/string.hpp"
-
-#define MAX_LIGHTS 16
+#include "../../data/radix_sort.hpp"
+#include "../frame_capture.hpp"
+
+// the point and spot lights share one atlas, the cascades of the directional light have their own array
+#define SHADOW_ATLAS_UNIT 4
+#define CASCADE_SHADOW_UNIT 5
+// the occluders rasterized per view are the largest opaque draws in front of the camera
+#define MAX_OCCLUDERS 16
+#define MAX_OCCLUDER_TRIANGLES (1 << 14)
+// bounding sphere radius over its distance to the camera, smaller draws rarely hide anything
+#define MIN_OCCLUDER_SIZE 0.2f
+
+// the bits of the lighting shader variants, each turns on the define at the same index of LIGHTING_DEFINES
+enum LightingVariant : uint32_t
+{
+	VARIANT_DIFFUSE_MAP 	= 1 << 0,
+	VARIANT_BUMP_MAP 		= 1 << 1,
+	VARIANT_PARALLAX_MAP 	= 1 << 2,
+	VARIANT_FLIP_NORMALS 	= 1 << 3,
+	VARIANT_RECEIVE_LIGHT 	= 1 << 4,
+	VARIANT_RECEIVE_SHADOWS = 1 << 5,
+	// the bits above come from the material and are part of the sort key, the ones below from the settings
+	VARIANT_SOFT_SHADOWS 	= 1 << 6,
+	VARIANT_VISUALIZE_DEPTH = 1 << 7,
+	// set by the weighted blended transparency pass only
+	VARIANT_WEIGHTED_OIT 	= 1 << 8,
+};
+
+static constexpr std::array<std::string_view, 9> LIGHTING_DEFINES =
+{
+	"HAS_DIFFUSE_MAP",
+	"HAS_BUMP_MAP",
+	"HAS_PARALLAX_MAP",
+	"FLIP_NORMALS",
+	"RECEIVE_LIGHT",
+	"RECEIVE_SHADOWS",
+	"SOFT_SHADOWS",
+	"VISUALIZE_DEPTH",
+	"WEIGHTED_OIT",
+};
+
+constexpr uint32_t MATERIAL_VARIANTS = (1 << 6) - 1;
+// the g-buffer only stores the surface, lighting is done by the deferred pass
+constexpr uint32_t GBUFFER_VARIANTS = VARIANT_DIFFUSE_MAP | VARIANT_BUMP_MAP | VARIANT_PARALLAX_MAP | VARIANT_FLIP_NORMALS;
 
 uint32_t pge::OpenglRenderer::init()
 {
@@ -31,7 +75,7 @@ uint32_t pge::OpenglRenderer::init()
     Engine::window.on_framebuffer_resize.connect(
     [](IWindow*, int width, int height)
     {
-        glViewport(0, 0, width, height);
+        gl_state.viewport(0, 0, width, height);
     });
 
 	create_texture_from_path("assets/missing.jpeg", m_missing_texture, TextureOptions{});
@@ -43,7 +87,7 @@ uint32_t pge::OpenglRenderer::init()
    ({
        {PGE_FIND_SHADER("lighting.vert"), Vertex},
        {PGE_FIND_SHADER("lighting.frag"), Fragment}
-   }));
+   }, LIGHTING_DEFINES));
 
     VALIDATE_ERR(m_outline_shader.create
    ({
@@ -68,6 +112,58 @@ uint32_t pge::OpenglRenderer::init()
        {PGE_FIND_SHADER("shadow_map.frag.glsl"), Fragment},
    }));
 
+	VALIDATE_ERR(m_shadow_face_shader.create
+   ({
+       {PGE_FIND_SHADER("shadow_map_face.vert.glsl"), Vertex},
+       {PGE_FIND_SHADER("shadow_map.frag.glsl"), Fragment},
+   }));
+
+	VALIDATE_ERR(m_cascade_shader.create
+   ({
+       {PGE_FIND_SHADER("shadow_map_face.vert.glsl"), Vertex},
+       {PGE_FIND_SHADER("shadow_map_depth.frag.glsl"), Fragment},
+   }));
+
+	VALIDATE_ERR(m_gbuffer_shader.create
+   ({
+       {PGE_FIND_SHADER("lighting.vert"), Vertex},
+       {PGE_FIND_SHADER("gbuffer.frag"), Fragment},
+   }, LIGHTING_DEFINES));
+
+	VALIDATE_ERR(m_deferred_lighting_shader.create
+   ({
+       {PGE_FIND_SHADER("quad.vert.glsl"), Vertex},
+       {PGE_FIND_SHADER("deferred_lighting.frag"), Fragment},
+   }, LIGHTING_DEFINES));
+
+	// the samplers a variant does not use are compiled out, setting them does nothing
+	for (auto *shader : {&m_lighting_shader, &m_gbuffer_shader})
+	{
+		shader->use()
+			.set("diffuse_map", 0)
+			.set("bump_map", 1)
+			.set("depth_map", 2);
+	}
+
+	m_deferred_lighting_shader.use()
+		.set("gbuffer_albedo", 0)
+		.set("gbuffer_normal", 1)
+		.set("gbuffer_color", 2)
+		.set("gbuffer_depth", 3);
+
+	VALIDATE_ERR(m_depth_prepass_shader.create
+   ({
+       {PGE_FIND_SHADER("depth_prepass.vert"), Vertex},
+       {PGE_FIND_SHADER("depth_prepass.frag"), Fragment},
+   }));
+
+	for (auto &queries : m_fragment_queries)
+	{
+		glGenQueries(queries.size(), queries.data());
+	}
+
+	glGenQueries(m_time_queries.size(), m_time_queries.data());
+
     VALIDATE_ERR(m_skybox_shader.create
    ({
        {PGE_FIND_SHADER("skybox.vert"), Vertex},
@@ -77,20 +173,47 @@ uint32_t pge::OpenglRenderer::init()
     m_skybox_shader.use();
     m_skybox_shader.set("skybox_texture", 0);
 
+	std::array<std::string_view, 1> oit_defines = {"MULTISAMPLED"};
+
+	VALIDATE_ERR(m_oit_composite_shader.create
+   ({
+       {PGE_FIND_SHADER("quad.vert.glsl"), Vertex},
+       {PGE_FIND_SHADER("oit_composite.frag"), Fragment},
+   }, oit_defines));
+
+	for (uint32_t variant : {0, 1})
+	{
+		m_oit_composite_shader.use(variant)
+			.set("accumulation", 0)
+			.set("revealage", 1);
+	}
+
     create_screen_plane();
     create_skybox_cube();
 
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_STENCIL_TEST);
-    //glEnable(GL_CULL_FACE);
+	VALIDATE_ERR(m_mesh_pool.init(1 << 18, 1 << 20, m_settings.geometry.vertex_format));
+
+	VALIDATE_ERR(m_ring_buffer.init(1 << 20));
+
+	GLint alignment;
+
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	m_uniform_alignment = alignment;
+
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	m_storage_alignment = alignment;
+
+    gl_state.enable(GL_DEPTH_TEST);
+    gl_state.enable(GL_STENCIL_TEST);
+    //gl_state.enable(GL_CULL_FACE);
 
-    glCullFace(GL_BACK);
+    gl_state.cull_face(GL_BACK);
     glFrontFace(GL_CCW);
 
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    gl_state.enable(GL_BLEND);
+    gl_state.blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+    gl_state.stencil_op(GL_KEEP, GL_KEEP, GL_REPLACE);
 
 	m_render_buffer.samples = 4;
 	m_render_buffer.texture_count = 2;
@@ -106,16 +229,16 @@ uint32_t pge::OpenglRenderer::init()
 	set_screen_space_settings(m_settings.screen_space);
 	set_texture_settings(m_settings.texture);
 
-	VALIDATE_ERR(m_gaussian_blur.init());
+	VALIDATE_ERR(m_bloom.init());
 
 	m_lighting_shader.use();
 
-	int sampler = 99;
+	m_lighting_shader.use().set("shadow_atlas", SHADOW_ATLAS_UNIT);
+	m_deferred_lighting_shader.use().set("shadow_atlas", SHADOW_ATLAS_UNIT);
+	m_lighting_shader.use().set("cascade_shadow_map", CASCADE_SHADOW_UNIT);
+	m_deferred_lighting_shader.use().set("cascade_shadow_map", CASCADE_SHADOW_UNIT);
 
-	for (int i = 0; i < MAX_LIGHTS; i++)
-	{
-		m_lighting_shader.set(fmt::format("lights[{}].shadow_map", i), sampler++);
-	}
+	VALIDATE_ERR(set_pipeline_settings(m_settings.pipeline));
 
     return OPENGL_ERROR_OK;
 }
@@ -131,19 +254,8 @@ pge::IShader* pge::OpenglRenderer::create_shader(ShaderList shaders)
 
 void pge::OpenglRenderer::create_buffers(Mesh &mesh)
 {
-    auto buffer = GlBufferBuilder()
-        .start()
-        .stride(sizeof(Vertex))
-        .vbo(mesh.vertices)
-        .ebo(mesh.indices)
-        .attr(3, offsetof(Vertex, position))
-        .attr(3, offsetof(Vertex, normal))
-        .attr(2, offsetof(Vertex, coord))
-		.attr(3, offsetof(Vertex, tangent))
-		.attr(3, offsetof(Vertex, bitangent))
-        .finish();
-
-    mesh.id = m_buffers.create(buffer);
+	mesh.bounds = calculate_bounds(mesh.vertices);
+	mesh.id = m_mesh_pool.create(mesh.vertices, mesh.indices, mesh.lods);
 }
 
 void pge::OpenglRenderer::delete_buffers(Mesh& mesh)
@@ -153,26 +265,26 @@ void pge::OpenglRenderer::delete_buffers(Mesh& mesh)
 
 void pge::OpenglRenderer::set_visualize_depth(bool value)
 {
-    m_lighting_shader.use();
-    m_lighting_shader.set("visualize_depth", value);
+	m_settings_variant = value ? m_settings_variant | VARIANT_VISUALIZE_DEPTH
+		: m_settings_variant & ~VARIANT_VISUALIZE_DEPTH;
 }
 
 void disable_stencil()
 {
-    glStencilMask(0xFF);
-    glStencilFunc(GL_ALWAYS, 1, 0xFF);
+    pge::gl_state.stencil_mask(0xFF);
+    pge::gl_state.stencil_func(GL_ALWAYS, 1, 0xFF);
 }
 
 void enable_stencil()
 {
-    glStencilFunc(GL_NOTEQUAL, 1, 0xFF);
-    glStencilMask(0x00);
+    pge::gl_state.stencil_func(GL_NOTEQUAL, 1, 0xFF);
+    pge::gl_state.stencil_mask(0x00);
 }
 
 void default_stencil()
 {
-    glStencilFunc(GL_ALWAYS, 1, 0xFF);
-    glStencilMask(0xFF);
+    pge::gl_state.stencil_func(GL_ALWAYS, 1, 0xFF);
+    pge::gl_state.stencil_mask(0xFF);
 }
 
 void pge::OpenglRenderer::new_frame()
@@ -182,31 +294,81 @@ void pge::OpenglRenderer::new_frame()
 
 void pge::OpenglRenderer::end_frame()
 {
+	if (m_frame_recorder != nullptr)
+	{
+		m_frame_recorder->record(m_render_queue, *m_camera, m_settings);
+
+		if (m_frame_recorder->done())
+		{
+			m_frame_recorder = nullptr;
+		}
+	}
+
+	m_ring_buffer.begin_frame();
+
+	// imgui and the window draw with their own state in between frames
+	gl_state.invalidate();
+	gl_state.reset_counts();
+
     draw_passes();
+
+	// reads of earlier frames are handed out first so a new read only waits when every slot is still busy
+	m_readback.poll();
+
+	auto [width, height] = Engine::window.framebuffer_size();
+
+	for (auto &[framebuffer, callback] : m_image_requests)
+	{
+		if (framebuffer != nullptr)
+		{
+			m_readback.read(((GlFramebuffer*)framebuffer)->fbo, GL_COLOR_ATTACHMENT0, width, height, std::move(callback));
+		}
+		else
+		{
+			// offline renders never reach the window so their output buffer is the screen
+			auto fbo = m_is_offline ? m_out_buffer.fbo : 0;
+
+			m_readback.read(fbo, fbo == 0 ? GL_BACK : GL_COLOR_ATTACHMENT0, width, height, std::move(callback));
+		}
+	}
+
+	m_image_requests.clear();
+
+	m_stats.state_changes = gl_state.issued();
+	m_stats.filtered_state_changes = gl_state.filtered();
+
+	m_ring_buffer.end_frame();
+
     handle_gl_buffer_delete();
     clear_buffers();
 }
 
-void pge::OpenglRenderer::draw_mesh(const MeshView &mesh)
+void pge::OpenglRenderer::draw_mesh(const MeshView &mesh, uint32_t lod)
 {
-    glDrawElements(GL_TRIANGLES, mesh.indices.size(), GL_UNSIGNED_INT, nullptr);
+	auto &range = m_mesh_pool.get(mesh.id);
+	auto command = m_mesh_pool.draw_command(mesh.id, lod);
+
+    glDrawElementsBaseVertex(GL_TRIANGLES, command.count, GL_UNSIGNED_INT,
+		(void*)(command.first_index * sizeof(uint32_t)), command.base_vertex);
+
 	m_stats.draw_calls++;
-	m_stats.vertices += mesh.vertices.size();
+	m_stats.vertices += range.vertex_count;
+}
+
+void pge::OpenglRenderer::set_position_transform(GlShader &shader, const MeshView &mesh)
+{
+	auto &range = m_mesh_pool.get(mesh.id);
+
+	shader.set("position_offset", range.position_offset);
+	shader.set("position_scale", range.position_scale);
 }
 
 void pge::OpenglRenderer::draw(const MeshView&mesh, glm::mat4 model, DrawOptions options)
 {
     DrawData data {mesh, model, options};
 
-    if (mesh.material.flags & MAT_USE_ALPHA)
-    {
-        float distance = glm::length2(m_camera->position - glm::vec3{model[3]});
-        m_sorted_meshes.emplace(distance, std::move(data));
-    }
-    else
-    {
-        m_render_queue.emplace_back(std::move(data));
-    }
+	m_draw_keys.push_back({make_sort_key(data), (uint32_t)m_render_queue.size()});
+    m_render_queue.emplace_back(std::move(data));
 }
 
 uint32_t
@@ -238,7 +400,7 @@ pge::OpenglRenderer::create_texture(ustring_view data, int width, int height, in
 	bool gamma_correct)
 {
     glGenTextures(1, &out_texture);
-    glBindTexture(GL_TEXTURE_2D, out_texture);
+    gl_state.edit_texture(GL_TEXTURE_2D, out_texture);
 
     int wrap;
     using enum TextureWrapMode;
@@ -273,6 +435,8 @@ pge::OpenglRenderer::create_texture(ustring_view data, int width, int height, in
     {
 		pixel_format = GL_RGBA;
 		internal_format = GL_SRGB_ALPHA;
+
+		m_alpha_textures.insert(out_texture);
     }
 
 	internal_format = gamma_correct ? internal_format : pixel_format;
@@ -286,7 +450,7 @@ pge::OpenglRenderer::create_texture(ustring_view data, int width, int height, in
 uint32_t pge::OpenglRenderer::create_cubemap_from_path(std::array<std::string_view, 6> faces, uint32_t& out_texture)
 {
     glGenTextures(1, &out_texture);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, out_texture);
+    gl_state.edit_texture(GL_TEXTURE_CUBE_MAP, out_texture);
 
     int width, height, channels;
 
@@ -337,6 +501,11 @@ pge::Image pge::OpenglRenderer::get_image()
     return img;
 }
 
+void pge::OpenglRenderer::read_image_async(IFramebuffer *framebuffer, ImageCallback callback)
+{
+	m_image_requests.push_back({framebuffer, std::move(callback)});
+}
+
 void pge::OpenglRenderer::delete_texture(uint32_t id)
 {
     if (id == m_missing_texture)
@@ -344,7 +513,10 @@ void pge::OpenglRenderer::delete_texture(uint32_t id)
         return;
     }
 
+	m_alpha_textures.erase(id);
+
     glDeleteTextures(1, &id);
+	gl_state.forget_texture(id);
 }
 
 pge::RendererProperties pge::OpenglRenderer::properties()
@@ -368,117 +540,282 @@ void pge::OpenglRenderer::draw_shaded_wireframe(const Mesh& mesh, glm::mat4 mode
     m_outline_shader.set("projection", m_camera->projection);
     m_outline_shader.set("view", m_camera->view);
     m_outline_shader.set("model", model);
+	set_position_transform(m_outline_shader, mesh);
 
-    glEnable(GL_POLYGON_OFFSET_FILL);
-    glPolygonMode( GL_FRONT_AND_BACK, GL_LINE );
+    gl_state.enable(GL_POLYGON_OFFSET_FILL);
+    gl_state.polygon_mode(GL_LINE);
 
     glPolygonOffset( -1.f, 0);
 
     draw_mesh(mesh);
 
-    glDisable( GL_POLYGON_OFFSET_FILL );
-    glPolygonMode( GL_FRONT_AND_BACK, GL_FILL );
+    gl_state.disable(GL_POLYGON_OFFSET_FILL);
+    gl_state.polygon_mode(GL_FILL);
 }
 
 void pge::OpenglRenderer::handle_lighting()
 {
-	m_lighting_shader.use()
-    	.set("light_count", (int)Light::table.size());
+	m_light_data.clear();
+	m_light_spheres.clear();
+	m_directional_light_data.clear();
 
-    auto light_iter = Light::table.begin();
+	uint32_t cascade_count = 0;
 
-	char name_buffer[256];
+	allocate_shadows();
 
-    for (int i = 0; i < Light::table.size(); i++)
-    {
-        auto *light = *light_iter++;
+	auto atlas_size = float(m_shadow_atlas.size());
 
+    for (auto *light : Light::table)
+    {
         if (light == nullptr || !light->is_active)
         {
             continue;
         }
 
-		if (light->shadow_map == nullptr)
+		if (light->is_directional)
 		{
-			auto fb = new GlFramebuffer();
-
-			create_shadow_map(m_settings.shadow.width, m_settings.shadow.height, *fb);
+			auto direction = light->direction == glm::vec3{0} ? glm::vec3{0, -1, 0} : glm::normalize(light->direction);
+			auto shadow_index = -1;
 
-			light->shadow_map = fb;
-			light->texture_id = sampler_start++;
-		}
+			if (light->cast_shadows && cascade_count == 0)
+			{
+				cascade_count = update_cascades(direction);
+				shadow_index = 0;
+			}
 
-        auto start = sprintf(name_buffer, "lights[%i].", i);
+			m_directional_light_data.push_back(
+			{
+				.direction 			= direction,
+				.color 				= light->color,
+				.ambient 			= light->ambient,
+				.diffuse 			= light->diffuse,
+				.specular 			= light->specular,
+				.power 				= light->power,
+				.shadow_index 		= shadow_index,
+				.is_directional 	= 1,
+			});
 
-        static auto field = [&name_buffer, start](std::string_view name) -> const char*
-        {
-            sprintf(name_buffer + start, "%s", name.data());
-            return name_buffer;
-        };
+			continue;
+		}
 
 		assert(light->position != nullptr);
 
 		auto position = *light->position;
+		auto range = light->range();
+
+		// too weak to light anything
+		if (range <= 0)
+		{
+			continue;
+		}
+
+		// spot lights without a direction follow the camera like a flashlight
+		auto direction = light->direction == glm::vec3{0} ? m_camera->front : glm::normalize(light->direction);
+
+		auto allocation = m_shadow_allocations.find(light);
+		auto has_shadow = allocation != m_shadow_allocations.end();
+
+		glm::mat4 shadow_transform {1.0f};
+		// the cot of half the field of view, a texel covers less of the view the narrower the cone is
+		float spot_zoom = 1.0f;
+
+		if (light->is_spot)
+		{
+			// the cone fits inside the frustum, the corners past it are never sampled
+			auto fov = 2.0f * glm::acos(glm::clamp(light->outer_cutoff, 0.0f, 1.0f));
+			auto up = glm::abs(direction.y) > 0.99f ? glm::vec3{1, 0, 0} : glm::vec3{0, 1, 0};
+
+			auto projection = glm::perspective(glm::clamp(fov, glm::radians(1.0f), glm::radians(170.0f)), 1.0f,
+				1.0f, m_settings.shadow.distance);
+
+			spot_zoom = projection[1][1];
+			shadow_transform = projection * glm::lookAt(position, position + direction, up);
+		}
+
+		glm::vec4 shadow_rect {0};
+		glm::vec2 shadow_corner {0};
+		float shadow_tile_size = 0;
+
+		if (has_shadow)
+		{
+			auto &shadow = allocation->second;
+
+			shadow_rect = glm::vec4{glm::vec2{shadow.tiles[0].position}, glm::vec2{shadow.tiles[1].position}} / atlas_size;
+			shadow_corner = glm::vec2{shadow.tiles[2].position} / atlas_size;
+			shadow_tile_size = shadow.face_size / atlas_size;
+		}
+
+		m_light_data.push_back(
+		{
+			.position 			= position,
+			.range 				= range,
+			.direction 			= direction,
+			.cutoff 			= light->inner_cutoff,
+			.color 				= light->color,
+			.outer_cutoff 		= light->outer_cutoff,
+			.ambient 			= light->ambient,
+			.diffuse 			= light->diffuse,
+			.specular 			= light->specular,
+			.power 				= light->power,
+			.constant 			= light->constant,
+			.linear 			= light->linear,
+			.quadratic 			= light->quadratic,
+			.shadow_index 		= has_shadow ? 0 : -1,
+			.is_spot 			= light->is_spot,
+			.shadow_tile_size 	= shadow_tile_size,
+			.shadow_rect 		= shadow_rect,
+			.shadow_transform 	= shadow_transform,
+			.shadow_corner 		= shadow_corner,
+		});
+
+		m_light_spheres.push_back({position, range});
+
+		if (!has_shadow)
+		{
+			continue;
+		}
+
+		// every face of a cube map has a 90 degree field of view
+		auto pixel_scale = 0.5f * allocation->second.face_size;
+
+		if (light->is_spot)
+		{
+			auto cone = make_frustum(shadow_transform);
+			auto shadow_hash = gather_shadow_casters(position, pixel_scale * spot_zoom, &cone);
+
+			hash_combine(shadow_hash, shadow_transform);
+
+			if (light->shadow_dirty || light->shadow_hash != shadow_hash)
+			{
+				render_to_spot_shadow_map(allocation->second, position, shadow_transform);
+
+				light->shadow_hash = shadow_hash;
+				light->shadow_dirty = false;
+				m_stats.shadow_map_updates++;
+			}
+
+			continue;
+		}
 
-        m_lighting_shader.use()
-			.set(field("is_active"), light->is_active)
-        	.set(field("color"), light->color)
-        	.set(field("diffuse"), light->diffuse)
-        	.set(field("specular"), light->specular)
-        	.set(field("ambient"), light->ambient)
-        	.set(field("power"), light->power)
-        	.set(field("direction"), m_camera->front)
-        	.set(field("cutoff"), light->inner_cutoff)
-        	.set(field("outer_cutoff"), light->outer_cutoff)
-        	.set(field("constant"),  light->constant)
-        	.set(field("linear"),    light->linear)
-        	.set(field("quadratic"), light->quadratic)
-        	.set(field("is_spot"), light->is_spot)
-			.set(field("position"), position)
-			.set(field("shadow_map"), light->texture_id);
-
-		render_to_shadow_map(light->shadow_map, position);
-
-		glActiveTexture(GL_TEXTURE4 + i);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, light->shadow_map->get_texture());
+		auto shadow_hash = gather_shadow_casters(position, pixel_scale);
+
+		if (light->shadow_dirty || light->shadow_hash != shadow_hash)
+		{
+			render_to_shadow_map(allocation->second, position);
+
+			light->shadow_hash = shadow_hash;
+			light->shadow_dirty = false;
+			m_stats.shadow_map_updates++;
+		}
     }
+
+	if (!m_shadow_allocations.empty())
+	{
+		gl_state.bind_texture(SHADOW_ATLAS_UNIT, GL_TEXTURE_2D, m_shadow_atlas_map->get_texture());
+	}
+
+	// directional lights are not in the clusters, the shaders loop over them after the clustered lights
+	m_const_data.directional_lights =
+	{
+		m_light_data.size(),
+		m_directional_light_data.size(),
+		cascade_count,
+		0,
+	};
+
+	m_light_data.insert(m_light_data.end(), m_directional_light_data.begin(), m_directional_light_data.end());
+
+	std::copy(m_cascade_transforms.begin(), m_cascade_transforms.end(), m_const_data.cascade_transforms);
+	m_const_data.cascade_ranges = glm::make_vec4(m_cascade_ranges.data());
+
+	if (cascade_count > 0)
+	{
+		gl_state.bind_texture(CASCADE_SHADOW_UNIT, GL_TEXTURE_2D_ARRAY, m_cascade_map->get_texture());
+	}
 }
 
-uint32_t pge::OpenglRenderer::handle_draw(const DrawData &data)
+uint32_t pge::OpenglRenderer::handle_draw(const DrawData &data, uint32_t lod)
 {
     auto &[mesh, model, options] = data;
 
-    if (!m_buffers.valid_id(mesh.id))
+    if (!m_mesh_pool.valid_id(mesh.id))
     {
         return OPENGL_ERROR_MESH_NOT_FOUND;
     }
 
-//    if (!options.cull_faces)
-//    {
-//        glDisable(GL_CULL_FACE);
-//    }
-
-    auto buffers = m_buffers.get(mesh.id);
+	// every caster draws from the mesh pool so the vao stays bound in between them
+    gl_state.bind_vertex_array(m_mesh_pool.vao);
 
-    glBindVertexArray(buffers.vao);
-
-    draw_mesh(mesh);
-
-    glBindVertexArray(0);
-
-    //glEnable(GL_CULL_FACE);
+    draw_mesh(mesh, lod);
 
     return OPENGL_ERROR_OK;
 }
 
 void pge::OpenglRenderer::draw_passes()
 {
-	set_constant_uniforms();
+	radix_sort(m_draw_keys, m_sort_scratch, [](const DrawKey &key)
+	{
+		return key.key;
+	});
+
+	build_draw_batches();
+
+	update_resolution_scale();
+
+	auto [width, height] = Engine::window.framebuffer_size();
+
+	// the targets keep the window size, a lower resolution only uses the bottom left part of them
+	m_render_size =
+	{
+		std::max(1, (int)std::round(width * m_resolution_scale)),
+		std::max(1, (int)std::round(height * m_resolution_scale)),
+	};
+
+	m_stats.resolution_scale = m_resolution_scale;
+	m_stats.gpu_frame_ms = m_last_gpu_frame_ms;
+
+	m_time_query_active = m_time_query_count < TIME_QUERIES;
+
+	if (m_time_query_active)
+	{
+		glBeginQuery(GL_TIME_ELAPSED, m_time_queries[(m_time_query_first + m_time_query_count) % TIME_QUERIES]);
+	}
+
+	// shadow maps and light data do not depend on the view so they are shared by every render view
+	handle_lighting();
+
+	// the light clusters and visible draws do depend on the view so every camera finds them on its own
+	size_t view_count = 1;
+
+	for (auto &view : m_render_views)
+	{
+		view_count += view.is_active && view.framebuffer != nullptr;
+	}
+
+	m_view_data.resize(view_count);
+
+	prepare_view(*m_camera, m_view_data[0], true);
+
+	size_t view_index = 1;
+
+	for (auto &view : m_render_views)
+	{
+		if (view.is_active && view.framebuffer != nullptr)
+		{
+			prepare_view(*view.camera, m_view_data[view_index++], false);
+		}
+	}
+
+	upload_frame_data();
+
+	render_to_framebuffer(m_render_buffer, m_view_data[0]);
 
-	render_to_framebuffer(m_render_buffer);
+	m_screen_buffer.blit_all_targets(&m_render_buffer, m_render_size.x, m_render_size.y);
 
 	auto *main_camera = m_camera;
 
+	view_index = 1;
+
     for (auto &view : m_render_views)
     {
 		if (!view.is_active || view.framebuffer == nullptr)
@@ -488,342 +825,1711 @@ void pge::OpenglRenderer::draw_passes()
 
 		m_camera = view.camera;
 
-		render_to_framebuffer(*((GlFramebuffer*)view.framebuffer));
+		render_to_framebuffer(*((GlFramebuffer*)view.framebuffer), m_view_data[view_index++]);
     }
 
 	m_camera = main_camera;
 
+    gl_state.polygon_mode(GL_FILL);
+
+	apply_bloom_blur();
+
     if (m_is_offline)
     {
         m_out_buffer.bind();
     }
 
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-
-	apply_bloom_blur();
     draw_screen_plane();
 
-	if (m_wireframe)
+    m_out_buffer.unbind();
+
+	if (m_time_query_active)
 	{
-		glPolygonMode(GL_FRONT_AND_BACK, GL_LINES);
-	}
+		glEndQuery(GL_TIME_ELAPSED);
 
-    m_out_buffer.unbind();
+		m_time_query_count++;
+	}
 }
 
-void pge::OpenglRenderer::draw_everything(bool calculate_shadows)
+void pge::OpenglRenderer::update_resolution_scale()
 {
-    glEnable(GL_DEPTH_TEST);
+	auto &settings = m_settings.pipeline;
 
-	auto draw_data = [&]
-	(DrawData &data)
+	if (!settings.dynamic_resolution)
 	{
-		if (calculate_shadows)
-		{
-			if (!(data.mesh.material.flags & MAT_CAST_SHADOW))
-			{
-				return;
-			}
-			m_shadow_map_shader.use();
-			m_shadow_map_shader.set("model", data.model);
-		}
-		else
-		{
-			set_model_uniforms(data);
-		}
+		m_resolution_scale = 1;
+	}
 
-        handle_draw(data);
-	};
+	// queries are only read once they are done so the cpu never waits on the gpu.
+	// they finish in order, every finished one is read so its slot can be used again
+	auto finished = false;
 
-    for (auto &data : m_render_queue)
-    {
-		draw_data(data);
-    }
+	while (m_time_query_count > 0)
+	{
+		auto query = m_time_queries[m_time_query_first];
+		GLuint available = 0;
 
-    for (auto &[_, data] : std::ranges::reverse_view(m_sorted_meshes))
-    {
-		draw_data(data);
-    }
-}
+		glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
 
-void pge::OpenglRenderer::clear_buffers()
-{
-    m_render_queue.clear();
-    m_sorted_meshes.clear();
-    m_delete_queue.clear();
-}
+		if (!available)
+		{
+			break;
+		}
 
-void pge::OpenglRenderer::draw_outline(const DrawData& data)
-{
-    auto &[mesh, model, options] = data;
+		GLuint64 elapsed = 0;
 
-    if (options.enable_outline)
-    {
-        enable_stencil();
+		glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
 
-        if (!options.outline.depth_test)
-        {
-            glDisable(GL_DEPTH_TEST);
-        }
+		m_last_gpu_frame_ms = elapsed / 1e6f;
+		m_gpu_frame_ms = m_gpu_frame_ms > 0 ? glm::mix(m_gpu_frame_ms, m_last_gpu_frame_ms, 0.1f) : m_last_gpu_frame_ms;
+		finished = true;
 
-        m_outline_shader.use()
-        	.set("projection", m_camera->projection)
-        	.set("view", m_camera->view)
-        	.set("model", model)
-        	.set("color", options.outline.color)
-        	.set("extrude_mul", options.outline.line_thickness);
+		m_time_query_first = (m_time_query_first + 1) % TIME_QUERIES;
+		m_time_query_count--;
+	}
 
-        draw_mesh(mesh);
+	if (!finished || !settings.dynamic_resolution || m_gpu_frame_ms <= 0)
+	{
+		return;
+	}
 
-        disable_stencil();
+	// the shaded pixels grow with the square of the scale so the square root of the time ratio is the scale
+	// that would hit the target. aiming a little under it leaves room for frames that take longer
+	auto target = m_resolution_scale * std::sqrt(settings.target_frame_ms * 0.95f / m_gpu_frame_ms);
 
-        glEnable(GL_DEPTH_TEST);
+	// the scale drops quickly when the frame is over budget and only creeps back up so it does not oscillate
+	auto step = target < m_resolution_scale ? 0.05f : 0.01f;
 
-        glClear(GL_STENCIL_BUFFER_BIT);
-    }
+	m_resolution_scale = std::clamp(target, m_resolution_scale - step, m_resolution_scale + step);
+	m_resolution_scale = std::clamp(m_resolution_scale, std::min(settings.min_resolution_scale, 1.0f), 1.0f);
 }
 
-void pge::OpenglRenderer::handle_gl_buffer_delete()
+// parallax mapped meshes discard fragments based on the view so their depth can only be known while shading
+static bool in_depth_prepass(const pge::Material &material)
 {
-    for (auto id : m_delete_queue)
-    {
-        auto buffers = m_buffers.get(id);
+	return !(material.flags & pge::MAT_USE_ALPHA) && !material.depth.enabled;
+}
 
-        buffers.free();
+void pge::OpenglRenderer::multi_draw(GlShader &shader, const DrawBatch &batch)
+{
+	shader.set("draw_offset", (int)batch.first);
 
-        m_buffers.remove(id);
-    }
+	glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+		(void*)(m_draw_command_allocation.offset + batch.first * sizeof(GlDrawCommand)), batch.count, 0);
+
+	m_stats.draw_calls++;
+	m_stats.vertices += batch.vertices;
 }
 
-void pge::OpenglRenderer::set_model_uniforms(const DrawData &data)
+bool pge::OpenglRenderer::bind_draw_buffers()
 {
-    auto &[mesh, model, _] = data;
-
-    auto material = mesh.material;
+	if (m_draw_batches.empty())
+	{
+		return false;
+	}
 
-	auto mvp = m_const_data.vp_mat * data.model;
+	gl_state.bind_vertex_array(m_mesh_pool.vao);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_ring_buffer.buffer);
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, m_ring_buffer.buffer, m_draw_info_allocation.offset,
+		m_draw_info_allocation.size);
 
-    m_lighting_shader.use()
-    	.set("material.color", material.color)
-    	.set("material.shininess", material.shininess)
-    	.set("texture_scale", material.diffuse.scale)
-    	.set("material.diffuse.enabled", material.diffuse.enabled)
-    	.set("material.bump.enabled", material.bump.enabled)
-		.set("material.bump_strength", material.bump_strength)
-		.set("material.depth.enabled", material.depth.enabled)
-		.set("material.depth_strength", material.depth_strength)
-    	.set("material.transparency", material.alpha)
-    	.set("receive_lighting", bool(material.flags & MAT_RECEIVE_LIGHT))
-		.set("contribute_bloom", bool(material.flags & MAT_CONTRIBUTE_BLOOM))
-		.set("material.cast_shadow", bool(material.flags & MAT_CAST_SHADOW))
-		.set("flip_normals", bool(material.flags & MAT_FLIP_NORMALS))
-    	.set("material.diffuse.sampler", 0)
-		.set("material.bump.sampler", 1)
-		.set("material.depth.sampler", 2)
-    	.set("material.specular", material.specular)
-		.set("material.emission", material.emission)
-    	.set("mvp", mvp)
-		.set("model", data.model);
+	return true;
+}
 
-	auto anisotropy_level = m_settings.texture.anisotropic_level;
+void pge::OpenglRenderer::draw_everything(bool measure_fragments)
+{
+    gl_state.enable(GL_DEPTH_TEST);
 
-	float distance = glm::length2(m_camera->position - glm::vec3{model[3]});
+	m_lighting_shader.use();
 
-	if (distance >= m_settings.texture.anisotropic_distance)
+	if (!bind_draw_buffers())
 	{
-		anisotropy_level = 0;
+		return;
 	}
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, material.diffuse.id);
+	// opaque batches are sorted before transparent ones
+	auto opaque = std::span(m_draw_batches).first(m_first_transparent_batch);
 
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisotropy_level);
+	auto &queries = m_fragment_queries[m_query_frame];
 
-	glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, material.bump.id);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisotropy_level);
+	if (measure_fragments && m_queries_issued)
+	{
+		auto &previous = m_fragment_queries[m_query_frame ^ 1];
 
-	glActiveTexture(GL_TEXTURE2);
-	glBindTexture(GL_TEXTURE_2D, material.depth.id);
-}
+		// results that are late keep the last counts instead of showing nothing
+		for (int i = 0; i < 2; i++)
+		{
+			GLuint available = 0;
 
-void pge::OpenglRenderer::create_screen_plane()
-{
-    m_screen_plane = GlBufferBuilder()
-        .start()
-        .vbo(QUAD_MESH)
-        .stride(4 * sizeof(float))
+			glGetQueryObjectuiv(previous[i], GL_QUERY_RESULT_AVAILABLE, &available);
+
+			if (available)
+			{
+				glGetQueryObjectui64v(previous[i], GL_QUERY_RESULT, &m_fragment_counts[i]);
+			}
+		}
+	}
+
+	if (measure_fragments)
+	{
+		m_stats.prepass_fragments = m_fragment_counts[0];
+		m_stats.shaded_fragments = m_fragment_counts[1];
+	}
+
+	auto prepass = m_settings.pipeline.depth_prepass;
+
+	if (measure_fragments)
+	{
+		glBeginQuery(GL_SAMPLES_PASSED, queries[0]);
+	}
+
+	if (prepass)
+	{
+		gl_state.color_mask(false);
+
+		m_depth_prepass_shader.use()
+			.set("diffuse_sampler", 0);
+
+		for (auto &batch : opaque)
+		{
+			auto &material = batch.data->mesh.material;
+
+			if (!in_depth_prepass(material))
+			{
+				continue;
+			}
+
+			m_depth_prepass_shader.set("diffuse_enabled", material.diffuse.enabled);
+
+			gl_state.bind_texture(0, GL_TEXTURE_2D, material.diffuse.id);
+
+			multi_draw(m_depth_prepass_shader, batch);
+		}
+
+		gl_state.color_mask(true);
+	}
+
+	if (measure_fragments)
+	{
+		glEndQuery(GL_SAMPLES_PASSED);
+		glBeginQuery(GL_SAMPLES_PASSED, queries[1]);
+	}
+
+    for (auto &batch : opaque)
+    {
+		m_lighting_shader.use(batch.variant | m_settings_variant);
+
+		// everything in the pre-pass already has its final depth so only the visible fragments get shaded
+		if (prepass && in_depth_prepass(batch.data->mesh.material))
+		{
+			gl_state.depth_func(GL_EQUAL);
+			gl_state.depth_mask(false);
+		}
+		else
+		{
+			gl_state.depth_func(GL_LESS);
+			gl_state.depth_mask(true);
+		}
+
+		set_material_textures(batch);
+
+		multi_draw(m_lighting_shader, batch);
+    }
+
+	gl_state.depth_func(GL_LESS);
+	gl_state.depth_mask(true);
+
+	if (measure_fragments)
+	{
+		glEndQuery(GL_SAMPLES_PASSED);
+
+		m_query_frame ^= 1;
+		m_queries_issued = true;
+	}
+
+	draw_transparent();
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void pge::OpenglRenderer::draw_transparent()
+{
+	if (m_settings.pipeline.transparency == TransparencyMode::WeightedBlended)
+	{
+		return;
+	}
+
+	for (auto &batch : std::span(m_draw_batches).subspan(m_first_transparent_batch))
+	{
+		m_lighting_shader.use(batch.variant | m_settings_variant);
+
+		set_material_textures(batch);
+
+		multi_draw(m_lighting_shader, batch);
+	}
+}
+
+void pge::OpenglRenderer::draw_deferred(GlFramebuffer &fb, glm::ivec2 size)
+{
+	gl_state.enable(GL_DEPTH_TEST);
+
+	m_gbuffer.bind();
+
+	gl_state.viewport(0, 0, size.x, size.y);
+
+	// the depth attachment is cleared to the far plane so the lighting pass can skip empty pixels
+	const float empty[] = {0, 0, 0, 0};
+	const float far_plane[] = {1, 0, 0, 0};
+
+	for (int i = 0; i < 3; i++)
+	{
+		glClearBufferfv(GL_COLOR, i, empty);
+	}
+
+	glClearBufferfv(GL_COLOR, 3, far_plane);
+	glClear(GL_DEPTH_BUFFER_BIT);
+
+	// the g-buffer holds data, blending it would mix unrelated values
+	gl_state.disable(GL_BLEND);
+
+	if (bind_draw_buffers())
+	{
+		for (auto &batch : std::span(m_draw_batches).first(m_first_transparent_batch))
+		{
+			m_gbuffer_shader.use(batch.variant & GBUFFER_VARIANTS);
+
+			set_material_textures(batch);
+
+			multi_draw(m_gbuffer_shader, batch);
+		}
+	}
+
+	fb.bind();
+
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+	// one full screen pass lights every pixel with the lights of its cluster
+	gl_state.depth_func(GL_ALWAYS);
+
+	m_deferred_lighting_shader.use(m_settings_variant)
+		.set("inverse_view_projection", glm::inverse(m_const_data.vp_mat));
+
+	for (int i = 0; i < 4; i++)
+	{
+		gl_state.bind_texture(i, GL_TEXTURE_2D, m_gbuffer.textures[i]);
+	}
+
+	draw_quad(m_screen_plane);
+
+	gl_state.depth_func(GL_LESS);
+	gl_state.enable(GL_BLEND);
+
+	// blending needs everything behind the mesh to be known so transparent meshes stay forward
+	if (bind_draw_buffers())
+	{
+		draw_transparent();
+	}
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+// the material bits of the lighting shader variant that draws the material
+static uint32_t material_variant(const pge::Material &material)
+{
+	uint32_t variant = 0;
+
+	if (material.diffuse.enabled)
+	{
+		variant |= VARIANT_DIFFUSE_MAP;
+	}
+
+	if (material.bump.enabled)
+	{
+		variant |= VARIANT_BUMP_MAP;
+
+		if (material.flags & pge::MAT_FLIP_NORMALS)
+		{
+			variant |= VARIANT_FLIP_NORMALS;
+		}
+	}
+
+	if (material.depth.enabled)
+	{
+		variant |= VARIANT_PARALLAX_MAP;
+	}
+
+	if (material.flags & pge::MAT_RECEIVE_LIGHT)
+	{
+		variant |= VARIANT_RECEIVE_LIGHT;
+
+		if (material.flags & pge::MAT_CAST_SHADOW)
+		{
+			variant |= VARIANT_RECEIVE_SHADOWS;
+		}
+	}
+
+	return variant;
+}
+
+// draws can only share a multi draw when they use the same textures
+static bool same_textures(const pge::Material &a, const pge::Material &b)
+{
+	auto same = [](const pge::Texture &a, const pge::Texture &b)
+	{
+		return a.id == b.id && a.enabled == b.enabled;
+	};
+
+	return same(a.diffuse, b.diffuse) && same(a.bump, b.bump) && same(a.depth, b.depth);
+}
+
+void pge::OpenglRenderer::build_draw_batches()
+{
+	m_draw_infos.clear();
+	m_draw_commands.clear();
+	m_draw_sources.clear();
+	m_draw_batches.clear();
+
+	for (auto [_, index] : m_draw_keys)
+	{
+		auto &data = m_render_queue[index];
+		auto &mesh = data.mesh;
+		auto &material = mesh.material;
+
+		if (!m_mesh_pool.valid_id(mesh.id))
+		{
+			continue;
+		}
+
+		auto draw_index = (uint32_t)m_draw_infos.size();
+		auto &range = m_mesh_pool.get(mesh.id);
+
+		m_draw_infos.push_back(
+		{
+			.model 			= data.model,
+			.position_offset = glm::vec4{range.position_offset, 0.0f},
+			.position_scale = glm::vec4{range.position_scale, 0.0f},
+			.color 			= glm::vec4{material.color, 1.0f},
+			.shininess 		= material.shininess,
+			.specular 		= material.specular,
+			.emission 		= material.emission,
+			.transparency 	= material.alpha,
+			.depth_strength = material.depth_strength,
+			.bump_strength 	= material.bump_strength,
+			.texture_scale 	= material.diffuse.scale,
+			.flags 			= material.flags,
+		});
+
+		m_draw_commands.push_back(m_mesh_pool.draw_command(mesh.id));
+		m_draw_sources.push_back(&data);
+
+		auto vertices = range.vertex_count;
+
+		auto &previous = m_draw_batches.empty() ? material : m_draw_batches.back().data->mesh.material;
+
+		auto variant = material_variant(material);
+
+		// the anisotropy of the textures is set per batch, so draws on both sides of the distance are split
+		auto anisotropic = is_anisotropic(data.model);
+
+		// opaque and transparent draws never share a batch so the passes can be drawn separately
+		if (m_draw_batches.empty() || !same_textures(previous, material) || m_draw_batches.back().variant != variant
+			|| (previous.flags & MAT_USE_ALPHA) != (material.flags & MAT_USE_ALPHA)
+			|| m_draw_batches.back().anisotropic != anisotropic)
+		{
+			m_draw_batches.push_back({draw_index, 0, 0, variant, &data, anisotropic});
+		}
+
+		auto &batch = m_draw_batches.back();
+
+		batch.count++;
+		batch.vertices += vertices;
+	}
+
+	m_first_transparent_batch = m_draw_batches.size();
+
+	for (size_t i = 0; i < m_draw_batches.size(); i++)
+	{
+		if (m_draw_batches[i].data->mesh.material.flags & MAT_USE_ALPHA)
+		{
+			m_first_transparent_batch = i;
+			break;
+		}
+	}
+}
+
+void pge::OpenglRenderer::prepare_view(const Camera &camera, ViewData &view, bool is_main)
+{
+	view.clusters.build(m_light_spheres, camera.view, camera.projection, camera.near, camera.far);
+	view.commands = m_draw_commands;
+
+	select_lods(camera, view, is_main);
+
+	if (m_settings.pipeline.occlusion_culling)
+	{
+		cull_draws(camera, view, is_main);
+	}
+
+	if (is_main)
+	{
+		m_stats.triangles = 0;
+
+		for (auto &command : view.commands)
+		{
+			m_stats.triangles += command.instance_count * command.count / 3;
+		}
+	}
+}
+
+// the coarsest lod whose error covers at most threshold pixels, pixel_scale turns a size one unit away into pixels.
+// a draw only gets coarser than its previous lod once the error is below the threshold by the hysteresis fraction
+// so draws right at the threshold do not flicker in between two lods
+static uint32_t select_lod(const pge::MeshView &mesh, const glm::mat4 &model, glm::vec3 eye, float pixel_scale,
+	bool perspective, const pge::GeometrySettings &settings, uint32_t previous)
+{
+	if (mesh.lods.empty() || !settings.use_lods || mesh.bounds.radius() <= 0)
+	{
+		return 0;
+	}
+
+	auto sphere = pge::transform_sphere(mesh.bounds, model);
+	auto scale = sphere.radius / mesh.bounds.radius();
+	// the nearest point of the mesh decides how large its error can get on screen
+	auto distance = perspective ? std::max(glm::length(sphere.center - eye) - sphere.radius, 1e-3f) : 1.0f;
+
+	auto pixels = [&](uint32_t lod)
+	{
+		return mesh.lods[lod - 1].error * scale / distance * pixel_scale;
+	};
+
+	auto lod = std::min(previous, (uint32_t)mesh.lods.size());
+
+	while (lod > 0 && pixels(lod) > settings.lod_threshold)
+	{
+		lod--;
+	}
+
+	while (lod < mesh.lods.size() && pixels(lod + 1) < settings.lod_threshold * (1.0f - settings.lod_hysteresis))
+	{
+		lod++;
+	}
+
+	return lod;
+}
+
+void pge::OpenglRenderer::select_lods(const Camera &camera, ViewData &view, bool is_main)
+{
+	// the main view is rendered at the scaled resolution so its lods can get coarser with it
+	auto height = is_main ? m_render_size.y : Engine::window.framebuffer_size().second;
+	auto pixel_scale = camera.projection[1][1] * 0.5f * height;
+	auto perspective = camera.type == Camera::Perspective;
+
+	if (is_main)
+	{
+		std::swap(m_lod_history, m_previous_lod_history);
+		m_lod_history.clear();
+	}
+
+	for (uint32_t i = 0; i < m_draw_sources.size(); i++)
+	{
+		auto &[mesh, model, _] = *m_draw_sources[i];
+
+		if (mesh.lods.empty())
+		{
+			continue;
+		}
+
+		// draws are queued again every frame so they are recognized by their mesh and transform
+		uint64_t key = 0;
+		uint32_t previous = 0;
+
+		if (is_main)
+		{
+			hash_combine(key, mesh.id);
+			hash_combine(key, model);
+
+			auto iter = m_previous_lod_history.find(key);
+
+			if (iter != m_previous_lod_history.end())
+			{
+				previous = iter->second;
+			}
+		}
+
+		auto lod = select_lod(mesh, model, camera.position, pixel_scale, perspective, m_settings.geometry, previous);
+
+		if (is_main)
+		{
+			m_lod_history[key] = lod;
+		}
+
+		if (lod > 0)
+		{
+			view.commands[i] = m_mesh_pool.draw_command(mesh.id, lod);
+		}
+	}
+}
+
+void pge::OpenglRenderer::cull_draws(const Camera &camera, ViewData &view, bool record_stats)
+{
+	auto vp = camera.projection * camera.view;
+	auto frustum = make_frustum(vp);
+
+	m_occlusion_buffer.clear();
+	m_occluders.clear();
+
+	uint32_t occluder_triangles = 0;
+
+	// wireframes show everything behind the occluders
+	if (!m_wireframe)
+	{
+		occluder_triangles = rasterize_occluders(camera, vp, frustum);
+	}
+
+	auto is_occluder = [this](uint32_t index)
+	{
+		return std::ranges::any_of(m_occluders, [index](const Occluder &occluder)
+		{
+			return occluder.index == index;
+		});
+	};
+
+	uint32_t frustum_culled = 0;
+	uint32_t occluded = 0;
+
+	for (uint32_t i = 0; i < m_draw_sources.size(); i++)
+	{
+		auto &[mesh, model, _] = *m_draw_sources[i];
+
+		if (!intersects(frustum, transform_sphere(mesh.bounds, model)))
+		{
+			view.commands[i].instance_count = 0;
+			frustum_culled++;
+		}
+		// an occluder is always in front of its own depth so testing it would only cost time
+		else if (!m_occluders.empty() && !is_occluder(i) && m_occlusion_buffer.is_occluded(mesh.bounds, vp * model))
+		{
+			view.commands[i].instance_count = 0;
+			occluded++;
+		}
+	}
+
+	if (record_stats)
+	{
+		m_stats.frustum_culled_draws = frustum_culled;
+		m_stats.occluded_draws = occluded;
+		m_stats.occluder_triangles = occluder_triangles;
+	}
+}
+
+uint32_t pge::OpenglRenderer::rasterize_occluders(const Camera &camera, const glm::mat4 &vp, const Frustum &frustum)
+{
+	for (uint32_t i = 0; i < m_draw_sources.size(); i++)
+	{
+		auto &[mesh, model, _] = *m_draw_sources[i];
+		auto &material = mesh.material;
+
+		// anything that can discard fragments may have holes the occluder would not have
+		if (mesh.vertices.empty() || material.flags & MAT_USE_ALPHA || material.depth.enabled)
+		{
+			continue;
+		}
+
+		bool forced = material.flags & MAT_OCCLUDER;
+
+		if (!forced && material.diffuse.enabled && m_alpha_textures.contains(material.diffuse.id))
+		{
+			continue;
+		}
+
+		auto sphere = transform_sphere(mesh.bounds, model);
+
+		if (!intersects(frustum, sphere))
+		{
+			continue;
+		}
+
+		auto distance = glm::length(sphere.center - camera.position);
+		auto size = forced ? std::numeric_limits<float>::max() : sphere.radius / std::max(distance, camera.near);
+
+		if (size >= MIN_OCCLUDER_SIZE)
+		{
+			m_occluders.push_back({i, size});
+		}
+	}
+
+	std::ranges::sort(m_occluders, std::greater{}, &Occluder::size);
+
+	uint32_t triangles = 0;
+	size_t count = 0;
+
+	for (auto &occluder : m_occluders)
+	{
+		auto &[mesh, model, _] = *m_draw_sources[occluder.index];
+		auto mesh_triangles = (uint32_t)mesh.indices.size() / 3;
+
+		if (count == MAX_OCCLUDERS || triangles + mesh_triangles > MAX_OCCLUDER_TRIANGLES)
+		{
+			continue;
+		}
+
+		triangles += mesh_triangles;
+		m_occlusion_buffer.rasterize(mesh.vertices, mesh.indices, vp * model);
+
+		m_occluders[count++] = occluder;
+	}
+
+	m_occluders.resize(count);
+
+	return triangles;
+}
+
+void pge::OpenglRenderer::upload_frame_data()
+{
+	// everything written to the ring buffer this frame, with room for aligning every allocation
+	auto alignment = std::max(m_uniform_alignment, m_storage_alignment);
+	auto frame_size = m_draw_infos.size() * sizeof(GlDrawInfo)
+		+ m_light_data.size() * sizeof(GlLightData)
+		+ 2 * alignment;
+
+	for (auto &view : m_view_data)
+	{
+		frame_size += view.clusters.clusters.size() * sizeof(glm::uvec2)
+			+ view.clusters.indices.size() * sizeof(uint32_t)
+			+ view.commands.size() * sizeof(GlDrawCommand)
+			+ sizeof(ConstantData)
+			+ 4 * alignment;
+	}
+
+	m_ring_buffer.reserve(frame_size);
+
+	m_draw_info_allocation = m_ring_buffer.write(std::span<const GlDrawInfo>(m_draw_infos), m_storage_alignment);
+	m_light_allocation = m_ring_buffer.write(std::span<const GlLightData>(m_light_data), m_storage_alignment);
+
+	for (auto &view : m_view_data)
+	{
+		view.cluster_allocation = m_ring_buffer.write(std::span<const glm::uvec2>(view.clusters.clusters),
+			m_storage_alignment);
+		view.index_allocation = m_ring_buffer.write(std::span<const uint32_t>(view.clusters.indices),
+			m_storage_alignment);
+		view.command_allocation = m_ring_buffer.write(std::span<const GlDrawCommand>(view.commands),
+			sizeof(GlDrawCommand));
+	}
+}
+
+bool pge::OpenglRenderer::is_anisotropic(const glm::mat4 &model) const
+{
+	return glm::length2(m_camera->position - glm::vec3{model[3]}) < m_settings.texture.anisotropic_distance;
+}
+
+uint64_t pge::OpenglRenderer::make_sort_key(const DrawData &data)
+{
+	constexpr uint64_t DEPTH_MAX = (1 << 24) - 1;
+	constexpr uint64_t PASS_OPAQUE = 0;
+	constexpr uint64_t PASS_TRANSPARENT = 1;
+
+	auto &[mesh, model, _] = data;
+	auto &material = mesh.material;
+
+	// draws of the same variant end up next to each other so the program rarely changes
+	uint64_t shader = material_variant(material) & MATERIAL_VARIANTS;
+
+	uint64_t textures = 0;
+
+	hash_combine(textures, material.diffuse.id);
+	hash_combine(textures, material.bump.id);
+	hash_combine(textures, material.depth.id);
+
+	textures &= 0xFFFF;
+
+	// the anisotropy is set per batch, keeping the near and far draws of the same textures apart splits them once
+	uint64_t anisotropic = is_anisotropic(model) ? 0 : 1;
+	uint64_t vao = mesh.id & 0x7FFF;
+
+	auto center = glm::vec3(model * glm::vec4(mesh.bounds.center(), 1.0f));
+	auto distance = glm::clamp(glm::length(m_camera->position - center) / m_camera->far, 0.0f, 1.0f);
+	auto depth = uint64_t(distance * DEPTH_MAX);
+
+	// weighted blended transparency does not depend on the order so the draws batch like opaque ones
+	if (material.flags & MAT_USE_ALPHA && m_settings.pipeline.transparency == TransparencyMode::WeightedBlended)
+	{
+		return PASS_TRANSPARENT << 62 | shader << 56 | textures << 40 | anisotropic << 39 | vao << 24 | depth;
+	}
+
+	// transparent meshes have to be drawn back to front so depth takes priority over state changes
+	if (material.flags & MAT_USE_ALPHA)
+	{
+		return PASS_TRANSPARENT << 62 | (DEPTH_MAX - depth) << 38 | shader << 32 | textures << 16 | vao;
+	}
+
+	return PASS_OPAQUE << 62 | shader << 56 | textures << 40 | anisotropic << 39 | vao << 24 | depth;
+}
+
+void pge::OpenglRenderer::clear_buffers()
+{
+    m_render_queue.clear();
+	m_draw_keys.clear();
+    m_delete_queue.clear();
+	m_shadow_casters.clear();
+}
+
+void pge::OpenglRenderer::draw_outline(const DrawData& data)
+{
+    auto &[mesh, model, options] = data;
+
+    if (options.enable_outline)
+    {
+        enable_stencil();
+
+        if (!options.outline.depth_test)
+        {
+            gl_state.disable(GL_DEPTH_TEST);
+        }
+
+        m_outline_shader.use()
+        	.set("projection", m_camera->projection)
+        	.set("view", m_camera->view)
+        	.set("model", model)
+        	.set("color", options.outline.color)
+        	.set("extrude_mul", options.outline.line_thickness);
+
+		set_position_transform(m_outline_shader, mesh);
+
+        draw_mesh(mesh);
+
+        disable_stencil();
+
+        gl_state.enable(GL_DEPTH_TEST);
+
+        glClear(GL_STENCIL_BUFFER_BIT);
+    }
+}
+
+void pge::OpenglRenderer::handle_gl_buffer_delete()
+{
+    for (auto id : m_delete_queue)
+    {
+        m_mesh_pool.remove(id);
+    }
+}
+
+void pge::OpenglRenderer::set_material_textures(const DrawBatch &batch)
+{
+    auto &material = batch.data->mesh.material;
+
+	auto anisotropy_level = batch.anisotropic ? m_settings.texture.anisotropic_level : 0;
+
+	// the variant of a disabled texture has no sampler for it so it does not need to be bound
+	if (material.diffuse.enabled)
+	{
+		gl_state.bind_texture(0, GL_TEXTURE_2D, material.diffuse.id);
+		// the level is remembered per texture so it is only set again when the batch moves across the distance
+		gl_state.texture_anisotropy(material.diffuse.id, anisotropy_level);
+	}
+
+	if (material.bump.enabled)
+	{
+		gl_state.bind_texture(1, GL_TEXTURE_2D, material.bump.id);
+		gl_state.texture_anisotropy(material.bump.id, anisotropy_level);
+	}
+
+	if (material.depth.enabled)
+	{
+		gl_state.bind_texture(2, GL_TEXTURE_2D, material.depth.id);
+	}
+}
+
+void pge::OpenglRenderer::create_screen_plane()
+{
+    m_screen_plane = GlBufferBuilder()
+        .start()
+        .vbo(QUAD_MESH)
+        .stride(4 * sizeof(float))
         .attr(2, 0)
         .attr(2, 2 * sizeof(float))
         .finish();
 }
 
-void pge::OpenglRenderer::create_skybox_cube()
+void pge::OpenglRenderer::create_skybox_cube()
+{
+    m_skybox_cube = GlBufferBuilder()
+        .start()
+        .vbo(CUBE_VERTS)
+        .stride(3 * sizeof(float))
+        .attr(3, 0)
+        .finish();
+}
+
+void pge::OpenglRenderer::draw_quad(GlBuffers &buffers)
+{
+	gl_state.bind_vertex_array(buffers.vao);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+}
+
+void pge::OpenglRenderer::draw_screen_plane()
+{
+    glClear(GL_COLOR_BUFFER_BIT);
+    gl_state.disable(GL_DEPTH_TEST);
+
+    auto [width, height] = Engine::window.framebuffer_size();
+
+	// the scene only fills the bottom left part of the screen buffer when the resolution is scaled
+	auto scale = glm::vec2{m_render_size} / glm::vec2{width, height};
+
+    m_screen_shader.use()
+    	.set("resolution", glm::vec2{width, height})
+		.set("screen_scale", scale)
+		.set("screen_max", scale - 0.5f / glm::vec2{width, height});
+
+    gl_state.bind_texture(0, GL_TEXTURE_2D, m_screen_buffer.textures[0]);
+    gl_state.bind_texture(1, GL_TEXTURE_2D, m_bloom.texture);
+
+	draw_quad(m_screen_plane);
+}
+
+void pge::OpenglRenderer::draw_skybox()
+{
+    if (m_skybox_texture == UINT32_MAX)
+    {
+        return;
+    }
+
+    m_skybox_shader.use();
+
+    auto view = glm::mat4(glm::mat3(m_camera->view));
+    m_skybox_shader.set("projection", m_camera->projection);
+    m_skybox_shader.set("view", view);
+
+    gl_state.depth_func(GL_LEQUAL);
+
+    gl_state.bind_vertex_array(m_skybox_cube.vao);
+    gl_state.bind_texture(0, GL_TEXTURE_CUBE_MAP, m_skybox_texture);
+    glDrawArrays(GL_TRIANGLES, 0, 36);
+    gl_state.depth_func(GL_LESS);
+}
+
+void pge::OpenglRenderer::render_to_framebuffer(pge::GlFramebuffer &fb, const ViewData &view)
+{
+	auto [width, height] = Engine::window.framebuffer_size();
+	auto size = &fb == &m_render_buffer ? m_render_size : glm::ivec2{width, height};
+
+	set_constant_uniforms(view.clusters, size);
+
+	gl_state.polygon_mode(m_wireframe ? GL_LINE : GL_FILL);
+
+	// every multi draw of the view reads the commands culled for its camera
+	m_draw_command_allocation = view.command_allocation;
+
+	// empty ranges cannot be bound, the shader never reads them in that case
+	if (m_light_allocation.size > 0)
+	{
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 1, m_ring_buffer.buffer, m_light_allocation.offset,
+			m_light_allocation.size);
+	}
+
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 2, m_ring_buffer.buffer, view.cluster_allocation.offset,
+		view.cluster_allocation.size);
+
+	if (view.index_allocation.size > 0)
+	{
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 3, m_ring_buffer.buffer, view.index_allocation.offset,
+			view.index_allocation.size);
+	}
+
+	if (m_settings.pipeline.path == RenderPath::Deferred)
+	{
+		draw_deferred(fb, size);
+	}
+	else
+	{
+		fb.bind();
+
+		gl_state.viewport(0, 0, size.x, size.y);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+		draw_everything(&fb == &m_render_buffer);
+	}
+
+    draw_skybox();
+
+	if (m_settings.pipeline.transparency == TransparencyMode::WeightedBlended)
+	{
+		draw_weighted_transparent(fb, size);
+	}
+
+    fb.unbind();
+
+	gl_state.viewport(0, 0, width, height);
+}
+
+pge::GlFramebuffer *pge::OpenglRenderer::oit_buffer(GLsizei samples)
+{
+	auto &buffer = m_oit_buffers[samples];
+
+	if (buffer)
+	{
+		return buffer.get();
+	}
+
+	buffer = std::make_unique<GlFramebuffer>();
+
+	buffer->samples = samples;
+	buffer->texture_count = 2;
+	// the accumulation needs the range of half floats, a weighted sum easily passes 1
+	buffer->texture_formats[0] = GL_RGBA16F;
+	buffer->texture_formats[1] = GL_R16F;
+
+	if (create_color_buffer(*buffer) != OPENGL_ERROR_OK)
+	{
+		m_oit_buffers.erase(samples);
+		return nullptr;
+	}
+
+	return buffer.get();
+}
+
+void pge::OpenglRenderer::draw_weighted_transparent(GlFramebuffer &fb, glm::ivec2 size)
+{
+	if (m_first_transparent_batch == m_draw_batches.size() || !bind_draw_buffers())
+	{
+		return;
+	}
+
+	auto *oit = oit_buffer(fb.samples);
+
+	if (oit == nullptr)
+	{
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		return;
+	}
+
+	oit->bind();
+
+	// transparent meshes are tested against the opaque depth of the target without writing it
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, fb.rbo);
+
+	gl_state.viewport(0, 0, size.x, size.y);
+
+	const float no_color[] = {0, 0, 0, 0};
+	const float revealed[] = {1, 0, 0, 0};
+
+	glClearBufferfv(GL_COLOR, 0, no_color);
+	glClearBufferfv(GL_COLOR, 1, revealed);
+
+	gl_state.depth_func(GL_LESS);
+	gl_state.depth_mask(false);
+	gl_state.enable(GL_BLEND);
+
+	// the weighted colors are summed, the revealage is multiplied by the transparency of every layer
+	gl_state.blend_func(0, GL_ONE, GL_ONE);
+	gl_state.blend_func(1, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
+
+	for (auto &batch : std::span(m_draw_batches).subspan(m_first_transparent_batch))
+	{
+		m_lighting_shader.use(batch.variant | m_settings_variant | VARIANT_WEIGHTED_OIT);
+
+		set_material_textures(batch);
+
+		multi_draw(m_lighting_shader, batch);
+	}
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+	gl_state.blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	fb.bind();
+
+	// the average color of the layers is blended over the scene by how much of it they cover
+	gl_state.depth_func(GL_ALWAYS);
+	gl_state.disable(GL_STENCIL_TEST);
+
+	m_oit_composite_shader.use(fb.samples > 0 ? 1 : 0);
+
+	gl_state.bind_texture(0, oit->tex_target, oit->textures[0]);
+	gl_state.bind_texture(1, oit->tex_target, oit->textures[1]);
+
+	draw_quad(m_screen_plane);
+
+	gl_state.enable(GL_STENCIL_TEST);
+	gl_state.depth_func(GL_LESS);
+	gl_state.depth_mask(true);
+}
+
+pge::RenderView *pge::OpenglRenderer::add_view(pge::Camera *camera)
+{
+	auto *fb = new GlFramebuffer();
+
+	auto result = create_color_buffer(*fb);
+
+	if (result != 0)
+	{
+		delete fb;
+		return nullptr;
+	}
+
+	auto &view = m_render_views.emplace_back(camera, fb, true);
+
+	view.camera = camera;
+	view.iter = --m_render_views.end();
+
+	return &m_render_views.back();
+}
+
+void pge::OpenglRenderer::remove_view(RenderView *view)
+{
+	if (view == nullptr)
+	{
+		return;
+	}
+
+	delete view->framebuffer;
+
+	view->framebuffer = nullptr;
+
+	m_render_views.erase(view->iter);
+}
+
+void pge::OpenglRenderer::update_shadow_atlas(const ShadowSettings &settings)
+{
+	auto min_tile = (int)std::bit_floor((uint32_t)std::clamp(settings.min_resolution, 16, 4096));
+
+	GLint max_texture_size = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
+
+	// the cascades come off the budget first whether a directional light uses them or not,
+	// so turning one on does not push the other shadows out. both store 16 bits per texel
+	auto cascade_bytes = uint64_t(settings.cascade_size) * settings.cascade_size * MAX_SHADOW_CASCADES * 2;
+	auto budget = uint64_t(std::max(settings.memory_budget_mb, 0)) << 20;
+	auto atlas_bytes = budget > cascade_bytes ? budget - cascade_bytes : 0;
+
+	// the largest square that fits what is left, but always room for one point light at the smallest size,
+	// its tile of four faces and the two single faces take three quadrants of a square four faces wide.
+	// tiles store their corner in 16 bits so the atlas stays below 64k
+	auto size = std::bit_floor((uint32_t)std::sqrt(atlas_bytes / 2.0));
+	auto max_size = std::min(std::bit_floor((uint32_t)std::max(max_texture_size, 1)), 1u << 15);
+
+	size = std::clamp(size, std::min<uint32_t>(min_tile * 4, max_size), max_size);
+
+	if (m_shadow_atlas_map != nullptr && m_shadow_atlas.size() == size && m_shadow_atlas_min_tile == min_tile)
+	{
+		return;
+	}
+
+	m_shadow_atlas_map = std::make_unique<GlFramebuffer>();
+	m_shadow_atlas_min_tile = min_tile;
+	m_shadow_atlas.reset(size, min_tile);
+
+	create_shadow_atlas((int)size, *m_shadow_atlas_map);
+
+	// the tiles went away with the old texture
+	m_shadow_allocations.clear();
+}
+
+void pge::OpenglRenderer::allocate_shadows()
+{
+	auto min_size = (uint32_t)m_shadow_atlas_min_tile;
+	auto max_size = std::max(std::bit_floor((uint32_t)std::max(m_settings.shadow.max_resolution, 1)), min_size);
+
+	// the faces of a point light take two tiles of twice their size
+	max_size = std::min(max_size, m_shadow_atlas.size() / 2);
+
+	auto height = (float)Engine::window.framebuffer_size().second;
+	auto pixel_scale = m_camera->projection[1][1] * 0.5f * height;
+
+	m_shadow_candidates.clear();
+
+	for (auto *light : Light::table)
+	{
+		if (light == nullptr || !light->is_active || !light->cast_shadows || light->is_directional)
+		{
+			continue;
+		}
+
+		assert(light->position != nullptr);
+
+		auto range = light->range();
+
+		if (range <= 0)
+		{
+			continue;
+		}
+
+		// roughly the radius in pixels the range of the light covers on screen, a light around the camera
+		// can shadow anything in view so it is the most important
+		auto distance = glm::distance(m_camera->position, *light->position);
+		auto importance = distance <= range ? std::numeric_limits<float>::max()
+			: range / std::sqrt(distance * distance - range * range) * pixel_scale;
+
+		m_shadow_candidates.push_back({importance, light});
+	}
+
+	std::ranges::sort(m_shadow_candidates, std::ranges::greater{}, &std::pair<float, Light*>::first);
+
+	// lights that were removed or stopped casting shadows give their tiles back, the pointers of removed
+	// lights are only compared and never read
+	for (auto iter = m_shadow_allocations.begin(); iter != m_shadow_allocations.end();)
+	{
+		auto wanted = std::ranges::any_of(m_shadow_candidates, [&](const auto &candidate)
+		{
+			return candidate.second == iter->first;
+		});
+
+		if (wanted)
+		{
+			++iter;
+			continue;
+		}
+
+		free_shadow_tiles(iter->second);
+		iter = m_shadow_allocations.erase(iter);
+	}
+
+	for (size_t i = 0; i < m_shadow_candidates.size(); i++)
+	{
+		auto [importance, light] = m_shadow_candidates[i];
+		auto face_size = std::clamp(std::bit_ceil((uint32_t)std::min(importance, (float)max_size)), min_size, max_size);
+
+		auto iter = m_shadow_allocations.find(light);
+
+		if (iter != m_shadow_allocations.end())
+		{
+			auto &current = iter->second;
+
+			// the tiles only change once the light wants twice or a quarter of the size it has,
+			// a light moving around the threshold would render its shadow again every frame otherwise
+			if (current.is_spot == light->is_spot && face_size <= current.face_size && face_size * 4 > current.face_size)
+			{
+				continue;
+			}
+
+			if (current.is_spot == light->is_spot && face_size > current.face_size)
+			{
+				// growing only takes free space, if there is none the light keeps the tiles it has
+				for (auto size = face_size; size > current.face_size; size /= 2)
+				{
+					if (auto allocation = allocate_shadow_tiles(light->is_spot, size))
+					{
+						free_shadow_tiles(current);
+						current = *allocation;
+						light->shadow_dirty = true;
+						break;
+					}
+				}
+
+				continue;
+			}
+
+			free_shadow_tiles(current);
+			m_shadow_allocations.erase(iter);
+		}
+
+		std::optional<ShadowAllocation> allocation;
+		auto evict = m_shadow_candidates.size();
+
+		while (true)
+		{
+			for (auto size = face_size; size >= min_size && !allocation; size /= 2)
+			{
+				allocation = allocate_shadow_tiles(light->is_spot, size);
+			}
+
+			if (allocation)
+			{
+				break;
+			}
+
+			// the least important light that still has tiles gives them up for this one
+			while (evict > i + 1 && !m_shadow_allocations.contains(m_shadow_candidates[evict - 1].second))
+			{
+				evict--;
+			}
+
+			if (evict <= i + 1)
+			{
+				break;
+			}
+
+			auto victim = m_shadow_allocations.find(m_shadow_candidates[--evict].second);
+
+			free_shadow_tiles(victim->second);
+			m_shadow_allocations.erase(victim);
+		}
+
+		if (allocation)
+		{
+			m_shadow_allocations[light] = *allocation;
+			light->shadow_dirty = true;
+		}
+	}
+
+	m_stats.shadowed_lights = m_shadow_allocations.size();
+	m_stats.shadow_memory = uint64_t(m_shadow_atlas.size()) * m_shadow_atlas.size() * 2;
+
+	if (m_cascade_map != nullptr)
+	{
+		m_stats.shadow_memory += uint64_t(m_cascade_map_size) * m_cascade_map_size * MAX_SHADOW_CASCADES * 2;
+	}
+}
+
+std::optional<pge::OpenglRenderer::ShadowAllocation> pge::OpenglRenderer::allocate_shadow_tiles(bool is_spot,
+	uint32_t face_size)
 {
-    m_skybox_cube = GlBufferBuilder()
-        .start()
-        .vbo(CUBE_VERTS)
-        .stride(3 * sizeof(float))
-        .attr(3, 0)
-        .finish();
+	auto first = m_shadow_atlas.allocate(is_spot ? face_size : face_size * 2);
+
+	if (!first)
+	{
+		return std::nullopt;
+	}
+
+	ShadowAllocation allocation {{*first, *first, *first}, face_size, is_spot};
+
+	if (is_spot)
+	{
+		return allocation;
+	}
+
+	// six faces in two tiles of four would leave a quarter of the space of every point light unused
+	auto second = m_shadow_atlas.allocate(face_size);
+	auto third = second ? m_shadow_atlas.allocate(face_size) : std::nullopt;
+
+	if (!third)
+	{
+		if (second)
+		{
+			m_shadow_atlas.free(*second);
+		}
+
+		m_shadow_atlas.free(*first);
+		return std::nullopt;
+	}
+
+	allocation.tiles[1] = *second;
+	allocation.tiles[2] = *third;
+
+	return allocation;
 }
 
-void pge::OpenglRenderer::draw_quad(GlBuffers &buffers)
+void pge::OpenglRenderer::free_shadow_tiles(const ShadowAllocation &allocation)
 {
- 	glBindVertexArray(buffers.vao);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    glBindVertexArray(0);
+	m_shadow_atlas.free(allocation.tiles[0]);
+
+	if (!allocation.is_spot)
+	{
+		m_shadow_atlas.free(allocation.tiles[1]);
+		m_shadow_atlas.free(allocation.tiles[2]);
+	}
 }
 
-void pge::OpenglRenderer::draw_screen_plane()
+// the corner of a cube face in the atlas, the first four faces are the quadrants of the first tile
+// and the last two have the other tiles
+static glm::ivec2 shadow_face_corner(const pge::ShadowAtlas::Tile *tiles, int face_size, uint32_t face)
 {
-    glClear(GL_COLOR_BUFFER_BIT);
-    glDisable(GL_DEPTH_TEST);
+	if (face >= 4)
+	{
+		return tiles[face - 3].position;
+	}
 
-    auto [width, height] = Engine::window.framebuffer_size();
+	return glm::ivec2{tiles[0].position} + glm::ivec2{face & 1, (face >> 1) & 1} * face_size;
+}
 
-    m_screen_shader.use()
-    	.set("resolution", glm::vec2{width, height});
+void pge::OpenglRenderer::render_to_shadow_map(const ShadowAllocation &allocation, glm::vec3 position)
+{
+	auto size = (int)allocation.face_size;
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, m_screen_buffer.textures[0]);
-	glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, m_gaussian_blur.textures[!m_gaussian_blur.horizontal]);
+	m_shadow_atlas_map->bind();
 
-	draw_quad(m_screen_plane);
-}
+	gl_state.polygon_mode(GL_FILL);
+	gl_state.enable(GL_CULL_FACE);
+	gl_state.cull_face(GL_FRONT);
+	// the clears and draws must stay inside the tiles of the light
+	gl_state.enable(GL_SCISSOR_TEST);
 
-void pge::OpenglRenderer::draw_skybox()
-{
-    if (m_skybox_texture == UINT32_MAX)
-    {
-        return;
-    }
+	auto projection = glm::perspective(glm::radians(90.0f), 1.0f, 1.0f, m_settings.shadow.distance);
 
-    m_skybox_shader.use();
+	std::array shadow_transforms =
+	{
+		 projection * glm::lookAt(position, position + glm::vec3{ 1.0, 0.0, 0.0}, glm::vec3{0.0,-1.0, 0.0}),
+		 projection * glm::lookAt(position, position + glm::vec3{-1.0, 0.0, 0.0}, glm::vec3{0.0,-1.0, 0.0}),
+		 projection * glm::lookAt(position, position + glm::vec3{0.0, 1.0, 0.0}, glm::vec3{0.0, 0.0, 1.0}),
+		 projection * glm::lookAt(position, position + glm::vec3{0.0,-1.0, 0.0}, glm::vec3{0.0, 0.0,-1.0}),
+		 projection * glm::lookAt(position, position + glm::vec3{0.0, 0.0, 1.0}, glm::vec3{0.0,-1.0, 0.0}),
+		 projection * glm::lookAt(position, position + glm::vec3{0.0, 0.0,-1.0}, glm::vec3{0.0,-1.0, 0.0}),
+	};
 
-    auto view = glm::mat4(glm::mat3(m_camera->view));
-    m_skybox_shader.set("projection", m_camera->projection);
-    m_skybox_shader.set("view", view);
+	std::array<glm::ivec2, 6> corners;
 
-    glDepthFunc(GL_LEQUAL);
+	for (uint32_t face = 0; face < corners.size(); ++face)
+	{
+		corners[face] = shadow_face_corner(allocation.tiles, size, face);
 
-    glBindVertexArray(m_skybox_cube.vao);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, m_skybox_texture);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
-    glDepthFunc(GL_LESS);
-}
+		glScissor(corners[face].x, corners[face].y, size, size);
+		glClear(GL_DEPTH_BUFFER_BIT);
+	}
 
-void pge::OpenglRenderer::render_to_framebuffer(pge::GlFramebuffer &fb)
-{
-    handle_lighting();
+	if (m_settings.shadow.use_geometry_shader)
+	{
+		// the geometry shader sends every face to its own viewport. glViewport and glScissor set all of them
+		// so the first face goes through those and the state cache, the others are set after it
+		gl_state.viewport(corners[0].x, corners[0].y, size, size);
+		glScissor(corners[0].x, corners[0].y, size, size);
 
-	fb.bind();
+		for (uint32_t face = 1; face < corners.size(); ++face)
+		{
+			glViewportIndexedf(face, corners[face].x, corners[face].y, size, size);
+			glScissorIndexed(face, corners[face].x, corners[face].y, size, size);
+		}
 
-	auto [width, height] = Engine::window.framebuffer_size();
+		m_shadow_map_shader.use()
+			.set("far_plane", m_settings.shadow.distance)
+			.set("light_pos", position);
+
+		for (uint32_t i = 0; i < shadow_transforms.size(); ++i)
+		{
+			m_shadow_map_shader.set(fmt::format("shadow_transforms[{}]", i), shadow_transforms[i]);
+		}
 
-	glViewport(0, 0, width, height);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+		for (auto &caster : m_shadow_casters)
+		{
+			m_shadow_map_shader.set("model", caster.data->model);
+			set_position_transform(m_shadow_map_shader, caster.data->mesh);
+			handle_draw(*caster.data, caster.lod);
+		}
+	}
+	else
+	{
+		m_shadow_face_shader.use()
+			.set("far_plane", m_settings.shadow.distance)
+			.set("light_pos", position);
 
-	draw_everything(false);
-    draw_skybox();
+		for (uint32_t face = 0; face < shadow_transforms.size(); ++face)
+		{
+			gl_state.viewport(corners[face].x, corners[face].y, size, size);
+			glScissor(corners[face].x, corners[face].y, size, size);
 
-	m_screen_buffer.blit_all_targets(&fb, width, height);
+			auto frustum = make_frustum(shadow_transforms[face]);
 
-    fb.unbind();
+			m_shadow_face_shader.set("shadow_transform", shadow_transforms[face]);
+
+			for (auto &caster : m_shadow_casters)
+			{
+				if (!intersects(frustum, caster.bounds))
+				{
+					continue;
+				}
+
+				m_shadow_face_shader.set("model", caster.data->model);
+				set_position_transform(m_shadow_face_shader, caster.data->mesh);
+				handle_draw(*caster.data, caster.lod);
+			}
+		}
+	}
+
+	gl_state.disable(GL_SCISSOR_TEST);
+	gl_state.cull_face(GL_BACK);
+	gl_state.disable(GL_CULL_FACE);
+
+	m_shadow_atlas_map->unbind();
 }
 
-pge::RenderView *pge::OpenglRenderer::add_view(pge::Camera *camera)
+void pge::OpenglRenderer::render_to_spot_shadow_map(const ShadowAllocation &allocation, glm::vec3 position,
+	const glm::mat4 &transform)
 {
-	auto *fb = new GlFramebuffer();
+	auto size = (int)allocation.face_size;
+	auto corner = allocation.tiles[0].position;
 
-	auto result = create_color_buffer(*fb);
+	gl_state.viewport(corner.x, corner.y, size, size);
 
-	if (result != 0)
+	m_shadow_atlas_map->bind();
+
+	gl_state.polygon_mode(GL_FILL);
+	gl_state.enable(GL_CULL_FACE);
+	gl_state.cull_face(GL_FRONT);
+	gl_state.enable(GL_SCISSOR_TEST);
+
+	glScissor(corner.x, corner.y, size, size);
+	glClear(GL_DEPTH_BUFFER_BIT);
+
+	// stores the distance to the light like the cube maps so both are compared the same way
+	m_shadow_face_shader.use()
+		.set("far_plane", m_settings.shadow.distance)
+		.set("light_pos", position)
+		.set("shadow_transform", transform);
+
+	for (auto &caster : m_shadow_casters)
 	{
-		delete fb;
-		return nullptr;
+		m_shadow_face_shader.set("model", caster.data->model);
+		set_position_transform(m_shadow_face_shader, caster.data->mesh);
+		handle_draw(*caster.data, caster.lod);
 	}
 
-	auto &view = m_render_views.emplace_back(camera, fb, true);
-
-	view.camera = camera;
-	view.iter = --m_render_views.end();
+	gl_state.disable(GL_SCISSOR_TEST);
+	gl_state.cull_face(GL_BACK);
+	gl_state.disable(GL_CULL_FACE);
 
-	return &m_render_views.back();
+	m_shadow_atlas_map->unbind();
 }
 
-void pge::OpenglRenderer::remove_view(RenderView *view)
+uint32_t pge::OpenglRenderer::update_cascades(glm::vec3 direction)
 {
-	if (view == nullptr)
+	auto &settings = m_settings.shadow;
+	auto count = (uint32_t)glm::clamp(settings.cascade_count, 1, MAX_SHADOW_CASCADES);
+	auto size = std::max(settings.cascade_size, 1);
+
+	if (m_cascade_map == nullptr || m_cascade_map_size != size)
 	{
-		return;
+		m_cascade_map = std::make_unique<GlFramebuffer>();
+		m_cascade_map_size = size;
+		m_cascade_hashes.fill(0);
+
+		create_cascade_shadow_map(size, MAX_SHADOW_CASCADES, *m_cascade_map);
 	}
 
-	delete view->framebuffer;
+	// turning the light moves every cascade at once, staggering would leave them disagreeing
+	auto stagger = settings.stagger_cascades && count > 2 && m_cascade_direction == direction;
 
-	view->framebuffer = nullptr;
+	m_cascade_direction = direction;
+	m_cascade_frame++;
 
-	m_render_views.erase(view->iter);
+	auto near = m_camera->near;
+	auto far = std::max(std::min(m_camera->far, settings.cascade_distance), near + 1e-3f);
+	auto lambda = glm::clamp(settings.cascade_split_lambda, 0.0f, 1.0f);
+
+	auto split = [&](uint32_t i)
+	{
+		auto t = float(i) / count;
+
+		return glm::mix(near + (far - near) * t, near * glm::pow(far / near, t), lambda);
+	};
+
+	auto inverse_view = glm::inverse(m_camera->view);
+	auto tan_x = 1.0f / m_camera->projection[0][0];
+	auto tan_y = 1.0f / m_camera->projection[1][1];
+
+	auto up = glm::abs(direction.y) > 0.99f ? glm::vec3{1, 0, 0} : glm::vec3{0, 1, 0};
+	// only rotates into the space of the light, used to snap the cascades to whole texels
+	auto light_rotation = glm::lookAt(glm::vec3{0}, direction, up);
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		// the first cascade is rendered every frame, the others take turns
+		if (stagger && i > 0 && m_cascade_hashes[i] != 0 && (m_cascade_frame % (count - 1)) != i - 1)
+		{
+			continue;
+		}
+
+		glm::vec3 corners[8];
+		glm::vec3 center {0};
+
+		for (int j = 0; j < 8; j++)
+		{
+			auto depth = j & 4 ? split(i + 1) : split(i);
+			auto x = (j & 1 ? 1.0f : -1.0f) * depth * tan_x;
+			auto y = (j & 2 ? 1.0f : -1.0f) * depth * tan_y;
+
+			corners[j] = glm::vec3(inverse_view * glm::vec4{x, y, -depth, 1.0f});
+			center += corners[j] / 8.0f;
+		}
+
+		// a sphere does not change size when the camera turns, so the texels of a cascade keep their size
+		float radius = 0;
+
+		for (auto &corner : corners)
+		{
+			radius = std::max(radius, glm::length(corner - center));
+		}
+
+		radius = std::ceil(radius * 16.0f) / 16.0f;
+
+		// moving the cascade by whole texels keeps the shadow edges from crawling when the camera moves
+		auto texel = 2.0f * radius / size;
+		auto light_center = glm::vec3(light_rotation * glm::vec4(center, 1.0f));
+
+		light_center.x = std::floor(light_center.x / texel) * texel;
+		light_center.y = std::floor(light_center.y / texel) * texel;
+		center = glm::vec3(glm::inverse(light_rotation) * glm::vec4(light_center, 1.0f));
+
+		// casters up to the shadow distance in front of the cascade still throw their shadow into it
+		auto back = settings.distance;
+		auto eye = center - direction * (radius + back);
+		auto range = back + 2.0f * radius;
+
+		auto transform = glm::ortho(-radius, radius, -radius, radius, 0.0f, range) * glm::lookAt(eye, center, up);
+		auto frustum = make_frustum(transform);
+
+		auto hash = gather_shadow_casters(eye, size / (2.0f * radius), &frustum, false);
+
+		hash_combine(hash, transform);
+
+		if (hash == m_cascade_hashes[i])
+		{
+			continue;
+		}
+
+		render_to_cascade(i, transform);
+
+		m_cascade_transforms[i] = transform;
+		m_cascade_ranges[i] = range;
+		m_cascade_hashes[i] = hash;
+		m_stats.cascade_updates++;
+	}
+
+	return count;
 }
 
-void pge::OpenglRenderer::render_to_shadow_map(IFramebuffer *fb, glm::vec3 position)
+void pge::OpenglRenderer::render_to_cascade(uint32_t cascade, const glm::mat4 &transform)
 {
-	glViewport(0, 0, m_settings.shadow.width, m_settings.shadow.height);
+	gl_state.viewport(0, 0, m_cascade_map_size, m_cascade_map_size);
+
+	m_cascade_map->bind();
 
-	fb->bind();
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_cascade_map->get_texture(), 0, cascade);
+
+	gl_state.polygon_mode(GL_FILL);
+	gl_state.enable(GL_CULL_FACE);
+	gl_state.cull_face(GL_FRONT);
 
 	glClear(GL_DEPTH_BUFFER_BIT);
 
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_FRONT);
+	m_cascade_shader.use()
+		.set("shadow_transform", transform);
 
-	auto projection = glm::perspective(glm::radians(90.0f), float(m_settings.shadow.width / m_settings.shadow.height),
-		1.0f, m_settings.shadow.distance);
+	for (auto &caster : m_shadow_casters)
+	{
+		m_cascade_shader.set("model", caster.data->model);
+		set_position_transform(m_cascade_shader, caster.data->mesh);
+		handle_draw(*caster.data, caster.lod);
+	}
 
-	std::array shadow_transforms =
+	gl_state.cull_face(GL_BACK);
+	gl_state.disable(GL_CULL_FACE);
+
+	m_cascade_map->unbind();
+}
+
+uint64_t pge::OpenglRenderer::gather_shadow_casters(glm::vec3 light_position, float pixel_scale, const Frustum *frustum,
+	bool perspective)
+{
+	uint64_t casters = 0;
+
+	Sphere light_range {light_position, m_settings.shadow.distance};
+
+	m_shadow_casters.clear();
+
+	auto gather = [&](const DrawData &data)
 	{
-		 projection * glm::lookAt(position, position + glm::vec3{ 1.0, 0.0, 0.0}, glm::vec3{0.0,-1.0, 0.0}),
-		 projection * glm::lookAt(position, position + glm::vec3{-1.0, 0.0, 0.0}, glm::vec3{0.0,-1.0, 0.0}),
-		 projection * glm::lookAt(position, position + glm::vec3{0.0, 1.0, 0.0}, glm::vec3{0.0, 0.0, 1.0}),
-		 projection * glm::lookAt(position, position + glm::vec3{0.0,-1.0, 0.0}, glm::vec3{0.0, 0.0,-1.0}),
-		 projection * glm::lookAt(position, position + glm::vec3{0.0, 0.0, 1.0}, glm::vec3{0.0,-1.0, 0.0}),
-		 projection * glm::lookAt(position, position + glm::vec3{0.0, 0.0,-1.0}, glm::vec3{0.0,-1.0, 0.0}),
-	};
+		auto &mesh = data.mesh;
 
-	m_shadow_map_shader.use()
-		.set("far_plane", m_settings.shadow.distance)
-		.set("light_pos", position);
+		if (!(mesh.material.flags & MAT_CAST_SHADOW))
+		{
+			return;
+		}
+
+		auto bounds = transform_sphere(mesh.bounds, data.model);
+
+		if ((perspective && !intersects(light_range, bounds)) || (frustum != nullptr && !intersects(*frustum, bounds)))
+		{
+			return;
+		}
+
+		// shadows are blurred by filtering anyway so they can use coarser lods than the view
+		auto lod = select_lod(mesh, data.model, light_position, pixel_scale, perspective, m_settings.geometry, 0);
+
+		lod = std::min<uint32_t>(lod + m_settings.geometry.shadow_lod_bias, mesh.lods.size());
+
+		m_shadow_casters.push_back({&data, bounds, lod});
 
-	for (int i = 0; i < shadow_transforms.size(); ++i)
+		uint64_t hash = 0;
+
+		hash_combine(hash, mesh.id);
+		hash_combine(hash, mesh.indices.size());
+		hash_combine(hash, data.model);
+		hash_combine(hash, lod);
+
+		// summed so the result does not depend on the order meshes were queued in
+		casters += hash;
+	};
+
+	for (auto &data : m_render_queue)
 	{
-		m_shadow_map_shader.set(fmt::format("shadow_transforms[{}]", i), shadow_transforms[i]);
+		gather(data);
 	}
 
-	draw_everything(true);
+	hash_combine(casters, light_position);
 
-	glCullFace(GL_BACK);
-	glDisable(GL_CULL_FACE);
-
-	fb->unbind();
+	return casters;
 }
 
 void pge::OpenglRenderer::set_shadow_settings(pge::ShadowSettings settings)
 {
-	m_lighting_shader.use()
-		.set("enable_soft_shadows", settings.enable_soft)
-		.set("shadow_bias", settings.bias)
-		.set("pcf_samples", settings.pcf_samples);
+	for (auto *light : Light::table)
+	{
+		light->shadow_dirty = true;
+	}
+
+	m_cascade_hashes.fill(0);
+
+	update_shadow_atlas(settings);
+
+	// a quality outside the enum, like one read from a newer capture, gets the medium kernel
+	int samples = 12;
+
+	switch (settings.quality)
+	{
+		case ShadowQuality::Low: samples = 4; break;
+		case ShadowQuality::Medium: samples = 12; break;
+		case ShadowQuality::High: samples = 24; break;
+		case ShadowQuality::Ultra: samples = 32; break;
+	}
+
+	m_settings_variant = settings.enable_soft ? m_settings_variant | VARIANT_SOFT_SHADOWS
+		: m_settings_variant & ~VARIANT_SOFT_SHADOWS;
+
+	for (auto *shader : {&m_lighting_shader, &m_deferred_lighting_shader})
+	{
+		shader->use()
+			.set("shadow_bias", settings.bias)
+			.set("pcf_samples", samples)
+			.set("filter_radius", settings.filter_radius);
+	}
 
 	m_settings.shadow = settings;
 }
 
+void pge::OpenglRenderer::set_geometry_settings(pge::GeometrySettings settings)
+{
+	// every mesh already lives in the vertex format chosen at init.
+	// cached shadow maps notice lod changes through the caster hash
+	settings.vertex_format = m_settings.geometry.vertex_format;
+
+	m_settings.geometry = settings;
+}
+
+uint32_t pge::OpenglRenderer::set_pipeline_settings(pge::PipelineSettings settings)
+{
+	if (settings.path == RenderPath::Deferred && m_gbuffer.fbo == 0)
+	{
+		m_gbuffer.texture_count = 4;
+		m_gbuffer.texture_formats[0] = GL_RGBA16F;
+		m_gbuffer.texture_formats[1] = GL_RGBA16F;
+		m_gbuffer.texture_formats[2] = GL_RGBA16F;
+		// window space depth needs full precision to rebuild the position
+		m_gbuffer.texture_formats[3] = GL_RG32F;
+
+		VALIDATE_ERR(create_color_buffer(m_gbuffer));
+	}
+
+	m_settings.pipeline = settings;
+
+	return OPENGL_ERROR_OK;
+}
+
 void pge::OpenglRenderer::set_screen_space_settings(pge::ScreenSpaceSettings settings)
 {
 	m_lighting_shader.use()
 		.set("bright_threshold", settings.bright_threshold);
 
+	m_deferred_lighting_shader.use()
+		.set("bright_threshold", settings.bright_threshold);
+
 	m_screen_shader.use()
 		.set("gamma", settings.gamma)
 		.set("exposure", settings.exposure)
@@ -839,41 +2545,109 @@ void pge::OpenglRenderer::apply_bloom_blur()
 		return;
 	}
 
-	m_gaussian_blur.shader.use();
+	auto &settings = m_settings.screen_space;
+
+	// a quality outside the enum gets the medium chain
+	int mips = 6;
+
+	switch (settings.bloom_quality)
+	{
+		case BloomQuality::Low: mips = 4; break;
+		case BloomQuality::Medium: mips = 6; break;
+		case BloomQuality::High: mips = 8; break;
+	}
+
+	mips = std::min(mips, m_bloom.mip_count);
+
+	gl_state.bind_framebuffer(GL_FRAMEBUFFER, m_bloom.fbo);
+
+	// only the level being read is visible to the shader so it never overlaps the level being written
+	auto read_level = [this](int level)
+	{
+		gl_state.bind_texture(0, GL_TEXTURE_2D, m_bloom.texture);
+		glTextureParameteri(m_bloom.texture, GL_TEXTURE_BASE_LEVEL, level);
+		glTextureParameteri(m_bloom.texture, GL_TEXTURE_MAX_LEVEL, level);
+	};
 
-	m_gaussian_blur.horizontal = true;
+	auto write_level = [this](int level)
+	{
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_bloom.texture, level);
+		gl_state.viewport(0, 0, m_bloom.mip_sizes[level].x, m_bloom.mip_sizes[level].y);
+	};
 
-	auto tex_target = m_screen_buffer.tex_target;
+	m_bloom.downsample_shader.use();
 
-	glActiveTexture(GL_TEXTURE0);
+	// the first mip reads only the part of the bright target the scene was rendered into
+	auto [width, height] = Engine::window.framebuffer_size();
+	auto screen_size = glm::vec2{width, height};
+	auto scale = glm::vec2{m_render_size} / screen_size;
 
-	for (int i = 0; i < m_settings.screen_space.bloom_blur_passes; i++)
+	// the bright pixels are halved down the chain, the first mip reads the full size bright target
+	for (int i = 0; i < mips; i++)
 	{
-		glBindFramebuffer(GL_FRAMEBUFFER, m_gaussian_blur.fbos[m_gaussian_blur.horizontal]);
+		write_level(i);
 
-		m_gaussian_blur.shader.set("horizontal", m_gaussian_blur.horizontal);
+		if (i == 0)
+		{
+			gl_state.bind_texture(0, m_screen_buffer.tex_target, m_screen_buffer.textures[1]);
+		}
+		else
+		{
+			read_level(i - 1);
+		}
 
-		glBindTexture(tex_target,
-			i == 0 ? m_screen_buffer.textures[1] : m_gaussian_blur.textures[!m_gaussian_blur.horizontal]);
+		m_bloom.downsample_shader.set("karis_average", i == 0 && settings.bloom_quality == BloomQuality::High)
+			.set("uv_scale", i == 0 ? scale : glm::vec2{1.0f})
+			.set("uv_max", i == 0 ? scale - 0.5f / screen_size : glm::vec2{1.0f});
 
 		draw_quad(m_screen_plane);
+	}
+
+	// then every mip is blended onto the one above it so the first mip ends up with every blur size
+	m_bloom.upsample_shader.use()
+		.set("radius", settings.bloom_radius);
+
+	gl_state.blend_func(GL_ONE, GL_ONE);
+
+	for (int i = mips - 1; i > 0; i--)
+	{
+		write_level(i - 1);
+		read_level(i);
 
-		m_gaussian_blur.horizontal = !m_gaussian_blur.horizontal;
-		tex_target = GL_TEXTURE_2D;
+		draw_quad(m_screen_plane);
 	}
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	gl_state.blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	read_level(0);
+
+	// each mip adds about as much light as the bright pixels had so the sum is averaged
+	m_screen_shader.use()
+		.set("bloom_strength", settings.bloom_intensity / mips);
+
+	gl_state.viewport(0, 0, width, height);
+	gl_state.bind_framebuffer(GL_FRAMEBUFFER, 0);
 }
 
-void pge::OpenglRenderer::set_constant_uniforms()
+void pge::OpenglRenderer::set_constant_uniforms(const LightClusters &clusters, glm::ivec2 size)
 {
-	m_lighting_shader.use()
-		.set("view_pos", m_camera->position)
-    	.set("camera_near", m_camera->near)
-    	.set("camera_far", m_camera->far)
-		.set("shadow_far", m_settings.shadow.distance);
-
  	m_const_data.vp_mat = m_camera->projection * m_camera->view;
+	m_const_data.view_pos = glm::vec4{m_camera->position, 1.0f};
+	m_const_data.camera_near = m_camera->near;
+	m_const_data.camera_far = m_camera->far;
+	m_const_data.shadow_far = m_settings.shadow.distance;
+	m_const_data.cluster_scale =
+	{
+		float(LightClusters::TILES_X) / size.x,
+		float(LightClusters::TILES_Y) / size.y,
+		clusters.slice_scale,
+		clusters.slice_bias,
+	};
+
+	// every view gets its own copy so views rendered earlier in the frame keep their data
+	auto allocation = m_ring_buffer.write(m_const_data, m_uniform_alignment);
+
+	glBindBufferRange(GL_UNIFORM_BUFFER, 0, m_ring_buffer.buffer, allocation.offset, allocation.size);
 }
 
 void pge::OpenglRenderer::set_texture_settings(pge::TextureSettings settings)
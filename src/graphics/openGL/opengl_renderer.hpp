@@ -1,7 +1,8 @@
 #pragma once
 
+#include <array>
 #include <list>
-#include <map>
+#include <memory>
 #include <set>
 
 #include "gl_framebuffer.hpp"
@@ -9,14 +10,25 @@
 #include "../renderer_interface.hpp"
 #include "../renderer_structs.hpp"
 #include "../../data/id_table.hpp"
+#include "../../data/hash_table.hpp"
 #include "../../data/string.hpp"
 #include "gl_buffers.hpp"
+#include "gl_mesh_pool.hpp"
+#include "gl_ring_buffer.hpp"
 #include "../render_view.hpp"
+#include "../culling.hpp"
+#include "../light_clusters.hpp"
+#include "../occlusion.hpp"
+#include "../shadow_atlas.hpp"
 #include "shadow_map.hpp"
-#include "gaussian_blur.hpp"
+#include "bloom.hpp"
+#include "gl_readback.hpp"
+#include "gl_state.hpp"
 
 namespace pge
 {
+	struct Light;
+
     class OpenglRenderer : public IRenderer
     {
     public:
@@ -47,11 +59,13 @@ namespace pge
 
         Image get_image() override;
 
+		void read_image_async(IFramebuffer *framebuffer, ImageCallback callback) override;
+
         void delete_texture(uint32_t id) override;
 
+        // applied to the scene of every view while it renders, the screen and imgui always fill
         void set_wireframe_mode(bool value) override
         {
-            glPolygonMode(GL_FRONT_AND_BACK, value ? GL_LINE : GL_FILL);
             m_wireframe = value;
         }
 
@@ -77,6 +91,7 @@ namespace pge
         void wait() override
         {
             glFinish();
+			m_readback.poll(true);
         }
 
         IFramebuffer* get_framebuffer() override
@@ -127,34 +142,276 @@ namespace pge
 		void set_texture_settings(TextureSettings settings) override;
 		TextureSettings get_texture_settings() override;
 
+		uint32_t set_pipeline_settings(PipelineSettings settings) override;
+
+		void set_geometry_settings(GeometrySettings settings) override;
+
+		GeometrySettings get_geometry_settings() override
+		{
+			return m_settings.geometry;
+		}
+
+		PipelineSettings get_pipeline_settings() override
+		{
+			return m_settings.pipeline;
+		}
+
     private:
 
+		// per view values, must match the FrameData uniform block in the lighting shaders
 		struct ConstantData
 		{
 			// the view projection matrix to be multiplied by the model
 			glm::mat4 vp_mat;
+			glm::vec4 view_pos;
+			float camera_near;
+			float camera_far;
+			float shadow_far;
+			float padding;
+			// tiles per pixel in x and y, then the scale and bias that turn the log of the view depth into a slice
+			glm::vec4 cluster_scale;
+			// the first directional light in the light buffer, how many there are and the shadow cascades in use.
+			// only the lighting shaders declare the members from here on
+			glm::uvec4 directional_lights;
+			// the depth every cascade covers in world units
+			glm::vec4 cascade_ranges;
+			glm::mat4 cascade_transforms[MAX_SHADOW_CASCADES];
+		};
+
+		static_assert(sizeof(ConstantData) == 400, "ConstantData must match the std140 layout in the shaders");
+
+		// per light values, must match Light in lighting.frag
+		struct GlLightData
+		{
+			glm::vec3 position;
+			float range;
+			glm::vec3 direction;
+			float cutoff;
+			glm::vec3 color;
+			float outer_cutoff;
+			float ambient;
+			float diffuse;
+			float specular;
+			float power;
+			float constant;
+			float linear;
+			float quadratic;
+			// -1 if the light has no shadow, the shadows of point and spot lights are in the shadow atlas
+			int32_t shadow_index;
+			uint32_t is_spot;
+			uint32_t is_directional;
+			// the size of a face in the atlas, in uv
+			float shadow_tile_size;
+			uint32_t padding;
+			// the corners of the first two tiles of a point light in uv, spot lights only use the first
+			glm::vec4 shadow_rect;
+			// projects world positions into the shadow map of a spot light
+			glm::mat4 shadow_transform;
+			// the corner of the last face of a point light in uv
+			glm::vec2 shadow_corner;
+			glm::vec2 padding2;
+		};
+
+		static_assert(sizeof(GlLightData) == 192, "GlLightData must match the std430 layout in the shaders");
+
+		// per draw values read by the lighting shader through gl_DrawID, must match DrawInfo in lighting.vert
+		struct GlDrawInfo
+		{
+			glm::mat4 model;
+			// maps packed vertex positions back to mesh space, w is unused
+			glm::vec4 position_offset;
+			glm::vec4 position_scale;
+			glm::vec4 color;
+			float shininess;
+			float specular;
+			float emission;
+			float transparency;
+			float depth_strength;
+			float bump_strength;
+			float texture_scale;
+			uint32_t flags;
+		};
+
+		static_assert(sizeof(GlDrawInfo) == 144, "GlDrawInfo must match the std430 layout in the shaders");
+
+		// consecutive sorted draws that share textures and get submitted with one multi draw
+		struct DrawBatch
+		{
+			// index of the first draw in the draw info and command buffers
+			uint32_t first;
+			uint32_t count;
+			uint32_t vertices;
+			// the material bits of the lighting shader variant every draw of the batch uses
+			uint32_t variant;
+			// the first draw of the batch, used for the shared textures
+			const DrawData *data;
+			// every draw of the batch is within the anisotropic distance of the main camera, or none is
+			bool anisotropic;
+		};
+
+		struct DrawKey
+		{
+			uint64_t key;
+			// index of the draw in the render queue
+			uint32_t index;
+		};
+
+		struct ShadowCaster
+		{
+			const DrawData *data;
+			// world space bounds used to cull the caster against each cube face or the spot cone
+			Sphere bounds;
+			uint32_t lod;
 		};
         // the default missing texture to use when unable to create a texture
         uint32_t m_missing_texture;
         // the texture id for the skybox
         uint32_t m_skybox_texture = UINT32_MAX;
-        // the opengl buffers every mesh needs to be drawn.
-        IdTable<GlBuffers> m_buffers;
+        // the shared vertex and index buffers every mesh is drawn from
+        GlMeshPool m_mesh_pool;
         // the base shader
         GlShader m_lighting_shader;
         // a shader used for outlining
         GlShader m_outline_shader;
         GlShader m_screen_shader;
         GlShader m_skybox_shader;
+		// renders all six faces of a cube shadow map in one draw using a geometry shader
 		GlShader m_shadow_map_shader;
+		// renders a single face of a cube shadow map
+		GlShader m_shadow_face_shader;
+		// renders a cascade of a directional light, only the depth is written
+		GlShader m_cascade_shader;
+		// writes only the depth of opaque meshes before they are shaded
+		GlShader m_depth_prepass_shader;
+		// writes the surface of opaque meshes into the g-buffer for the deferred path
+		GlShader m_gbuffer_shader;
+		// lights every pixel of the g-buffer in one full screen pass
+		GlShader m_deferred_lighting_shader;
+		// the bits of the lighting variants that come from the settings and apply to every draw
+		uint32_t m_settings_variant = 0;
+		// albedo and specular, normal and shininess, color and emission, depth and material flags.
+		// only created once the deferred path is used
+		GlFramebuffer m_gbuffer;
+		// resolves the weighted blended transparency targets over the opaque scene
+		GlShader m_oit_composite_shader;
+		// accumulation and revealage targets of the weighted blended transparency, one per sample count
+		// of the framebuffers drawn into. only created once the mode is used
+		HashMap<GLsizei, std::unique_ptr<GlFramebuffer>> m_oit_buffers;
+		// samples passed queries for the pre-pass and the lighting pass of the main view.
+		// there is a set per frame so the results of the previous frame can be read without stalling
+		std::array<std::array<GLuint, 2>, 2> m_fragment_queries;
+		uint32_t m_query_frame = 0;
+		bool m_queries_issued = false;
+		// the last counts read from the queries
+		std::array<GLuint64, 2> m_fragment_counts {};
+		// time elapsed queries around the whole frame used as a ring. the cpu can be a few frames ahead so there
+		// is one more than the frames in flight, a query is only started again once its result was read
+		static constexpr uint32_t TIME_QUERIES = GlRingBuffer::FRAMES + 1;
+		std::array<GLuint, TIME_QUERIES> m_time_queries;
+		// the oldest query that was not read yet and how many are waiting for their result
+		uint32_t m_time_query_first = 0;
+		uint32_t m_time_query_count = 0;
+		// false when every query was still pending at the start of the frame so it is not timed
+		bool m_time_query_active = false;
+		// the gpu time of the last finished frame and the smoothed time the resolution scale follows
+		float m_last_gpu_frame_ms = 0;
+		float m_gpu_frame_ms = 0;
+		float m_resolution_scale = 1;
+		// the part of the main view targets the scene is rendered into this frame
+		glm::ivec2 m_render_size {0};
         // the screen plane where framebuffer textures are drawn to
         GlBuffers m_screen_plane;
         // the cube that will be used to draw the skybox
         GlBuffers m_skybox_cube;
-        // possibly transparent meshes that are sorted by their distance from the camera
-        std::multimap<float, DrawData> m_sorted_meshes;
         // meshes that are queued for drawing in all render passes
         std::vector<DrawData> m_render_queue;
+		// sort keys pointing into the render queue, sorted every frame to decide the draw order
+		std::vector<DrawKey> m_draw_keys;
+		// second buffer used while radix sorting the draw keys
+		std::vector<DrawKey> m_sort_scratch;
+		// per draw values and indirect commands for every valid draw in sorted order
+		std::vector<GlDrawInfo> m_draw_infos;
+		std::vector<GlDrawCommand> m_draw_commands;
+		// the queued draw behind every draw info, used to cull the draws of each view
+		std::vector<const DrawData*> m_draw_sources;
+		std::vector<DrawBatch> m_draw_batches;
+		// batches before this index are opaque
+		size_t m_first_transparent_batch = 0;
+		// every active light uploaded this frame, the ones with a sphere get binned into clusters
+		// and the directional lights that light everything follow them
+		std::vector<GlLightData> m_light_data;
+		std::vector<Sphere> m_light_spheres;
+		std::vector<GlLightData> m_directional_light_data;
+
+		// the tiles a light has in the shadow atlas. a point light keeps four cube faces in the quadrants
+		// of a tile twice the face size and the last two in a tile of their own each, a spot light has a single face
+		struct ShadowAllocation
+		{
+			ShadowAtlas::Tile tiles[3];
+			uint32_t face_size;
+			bool is_spot;
+		};
+
+		// every point and spot light shadow is rendered into this one depth texture
+		std::unique_ptr<GlFramebuffer> m_shadow_atlas_map;
+		ShadowAtlas m_shadow_atlas;
+		int m_shadow_atlas_min_tile = 0;
+		// lights keep their tiles over frames so their shadow is only rendered again when something changes
+		HashMap<const Light*, ShadowAllocation> m_shadow_allocations;
+		// the lights that want a shadow this frame, most important first
+		std::vector<std::pair<float, Light*>> m_shadow_candidates;
+
+		// the cascades of the first directional light that casts shadows, one layer each
+		std::unique_ptr<GlFramebuffer> m_cascade_map;
+		int m_cascade_map_size = 0;
+		// the transform and depth range each cascade was last rendered with, staggered cascades keep theirs
+		// for a few frames so they are sampled the way they were rendered
+		std::array<glm::mat4, MAX_SHADOW_CASCADES> m_cascade_transforms {};
+		std::array<float, MAX_SHADOW_CASCADES> m_cascade_ranges {};
+		// hash of the casters and transform of every cascade, 0 until it is rendered
+		std::array<uint64_t, MAX_SHADOW_CASCADES> m_cascade_hashes {};
+		glm::vec3 m_cascade_direction {};
+		uint64_t m_cascade_frame = 0;
+
+		struct ViewData
+		{
+			LightClusters clusters;
+			// the draw commands of the frame with the instance count of culled draws set to 0
+			std::vector<GlDrawCommand> commands;
+			GlRingAllocation cluster_allocation;
+			GlRingAllocation index_allocation;
+			GlRingAllocation command_allocation;
+		};
+
+		// the main camera followed by every active render view
+		std::vector<ViewData> m_view_data;
+		// large meshes close to the camera are rasterized into this on the cpu to cull the draws behind them
+		OcclusionBuffer m_occlusion_buffer;
+
+		struct Occluder
+		{
+			// index of the draw in the draw infos
+			uint32_t index;
+			// how much of the view the draw covers
+			float size;
+		};
+
+		std::vector<Occluder> m_occluders;
+		// textures with an alpha channel, meshes using them may have holes so they are never picked as occluders
+		std::set<uint32_t> m_alpha_textures;
+		// the lod every draw of the main view used, keyed by a hash of its mesh and transform.
+		// kept for one frame so the lod selection can tell which way a draw is switching
+		HashMap<uint64_t, uint32_t> m_lod_history;
+		HashMap<uint64_t, uint32_t> m_previous_lod_history;
+		GlRingAllocation m_light_allocation;
+		// all per frame data the gpu reads is written straight into this buffer
+		GlRingBuffer m_ring_buffer;
+		GlRingAllocation m_draw_info_allocation;
+		GlRingAllocation m_draw_command_allocation;
+		size_t m_uniform_alignment = 256;
+		size_t m_storage_alignment = 256;
+		// the shadow casters in range of the light whose shadow map is being rendered
+		std::vector<ShadowCaster> m_shadow_casters;
         // the shaders that will be used for different render passes such as post processing stuff
         std::list<GlShader> m_shaders;
         // the queue for the buffers that are supposed to be deleted
@@ -169,10 +426,18 @@ namespace pge
         GlFramebuffer m_out_buffer;
         bool m_is_offline = false;
         bool m_wireframe = false;
-		IdTable<GlFramebuffer> m_shadow_maps;
-		//int shadow_map_texture = GL_TEXTURE4;
-		int sampler_start = 4;
-		GaussianBlur m_gaussian_blur;
+		Bloom m_bloom;
+		// pixel buffers the screen and framebuffers are read into without stalling
+		GlReadback m_readback;
+
+		struct ImageRequest
+		{
+			IFramebuffer *framebuffer;
+			ImageCallback callback;
+		};
+
+		// reads asked for during the frame, started once the frame is rendered
+		std::vector<ImageRequest> m_image_requests;
 
 		AllRenderSettings m_settings;
 		RenderStats m_stats;
@@ -181,15 +446,50 @@ namespace pge
 
         void draw_shaded_wireframe(const Mesh &mesh, glm::mat4 model);
 
+		// renders shadow maps and collects the light data, done once per frame for all render views
         void handle_lighting();
 
-		void draw_mesh(const MeshView &mesh);
+		// writes the draws, lights and light clusters of the frame to the ring buffer
+		void upload_frame_data();
+
+		void draw_mesh(const MeshView &mesh, uint32_t lod = 0);
+		// sets the uniforms that decode the stored vertex positions of the mesh
+		void set_position_transform(GlShader &shader, const MeshView &mesh);
 
-        uint32_t handle_draw(const DrawData&data);
+        uint32_t handle_draw(const DrawData&data, uint32_t lod = 0);
 
         void draw_passes();
 
-        void draw_everything(bool calculate_shadows);
+		// moves the resolution scale towards the frame time budget using the gpu time of the last finished frame
+		void update_resolution_scale();
+
+		// binds the buffers shared by every multi draw, returns false if there is nothing to draw
+		bool bind_draw_buffers();
+
+		// measure_fragments counts the shaded samples for the stats, only done for the main view
+        void draw_everything(bool measure_fragments);
+
+		// does nothing in the weighted blended mode, those are drawn after the skybox by draw_weighted_transparent
+		void draw_transparent();
+
+		// sums the transparent meshes into the weighted blended targets using the depth of fb, then composites them into fb
+		void draw_weighted_transparent(GlFramebuffer &fb, glm::ivec2 size);
+
+		// the weighted blended targets for framebuffers with the sample count, nullptr if they could not be created
+		GlFramebuffer *oit_buffer(GLsizei samples);
+
+		// fills the g-buffer with the opaque meshes, lights it into fb and draws the transparent meshes forward
+		void draw_deferred(GlFramebuffer &fb, glm::ivec2 size);
+
+		void multi_draw(GlShader &shader, const DrawBatch &batch);
+
+		// whether a draw is close enough to the main camera for anisotropic filtering
+		bool is_anisotropic(const glm::mat4 &model) const;
+
+		// packs the render pass, shader variant, textures, anisotropy, vao and camera distance of a draw into a key.
+		// opaque draws sort by state then front to back, transparent draws sort back to front
+		// unless the weighted blended mode makes their order irrelevant
+		uint64_t make_sort_key(const DrawData &data);
 
         void clear_buffers();
 
@@ -197,7 +497,25 @@ namespace pge
 
         void handle_gl_buffer_delete();
 
-        void set_model_uniforms(const DrawData &data);
+        // binds the textures shared by a batch of draws
+        void set_material_textures(const DrawBatch &batch);
+
+		// fills the draw info and command lists and groups the sorted draws into batches
+		void build_draw_batches();
+
+		// bins the lights, picks the lods and culls the draws of a camera. the stats come from the main view
+		void prepare_view(const Camera &camera, ViewData &view, bool is_main);
+
+		// switches the commands of draws that are small on screen to simplified lods.
+		// only the main view remembers the lods for the hysteresis
+		void select_lods(const Camera &camera, ViewData &view, bool is_main);
+
+		// culls the draws outside the frustum of the camera or behind its occluders
+		void cull_draws(const Camera &camera, ViewData &view, bool record_stats);
+
+		// rasterizes the largest opaque draws in front of the camera into the occlusion buffer,
+		// returns the number of triangles rasterized
+		uint32_t rasterize_occluders(const Camera &camera, const glm::mat4 &vp, const Frustum &frustum);
 
         void create_screen_plane();
 
@@ -211,11 +529,40 @@ namespace pge
 
         void draw_skybox();
 
-		void render_to_framebuffer(pge::GlFramebuffer &fb);
+		// renders the queued meshes from the point of view of the current camera.
+		// the render buffer only gets the scaled part of its size, other framebuffers are always filled
+		void render_to_framebuffer(pge::GlFramebuffer &fb, const ViewData &view);
+
+		// recreates the atlas when the budget or resolutions changed, every light has to get its tiles again
+		void update_shadow_atlas(const ShadowSettings &settings);
+
+		// hands out atlas tiles to the lights that cast shadows, sized by how much of the screen they cover.
+		// when the atlas is full the least important lights get smaller tiles or lose theirs
+		void allocate_shadows();
+
+		std::optional<ShadowAllocation> allocate_shadow_tiles(bool is_spot, uint32_t face_size);
+
+		void free_shadow_tiles(const ShadowAllocation &allocation);
+
+		// renders the six faces of a point light into its tiles of the atlas
+		void render_to_shadow_map(const ShadowAllocation &allocation, glm::vec3 position);
+
+		// renders the single face of a spot light, the casters were already culled against its cone
+		void render_to_spot_shadow_map(const ShadowAllocation &allocation, glm::vec3 position, const glm::mat4 &transform);
+
+		// fits the cascades to the main camera and renders the ones whose casters or transform changed,
+		// returns the number of cascades in use
+		uint32_t update_cascades(glm::vec3 direction);
+
+		void render_to_cascade(uint32_t cascade, const glm::mat4 &transform);
 
-		void render_to_shadow_map(IFramebuffer *fb, glm::vec3 position);
+		// collects the shadow casters in the lights range, and inside the frustum if there is one,
+		// and hashes them with the light position. pixel_scale picks the lods like the view does.
+		// orthographic maps have no range so only the frustum is used
+		uint64_t gather_shadow_casters(glm::vec3 light_position, float pixel_scale, const Frustum *frustum = nullptr,
+			bool perspective = true);
 
-		// sets uniforms that do not change in between draw calls
-		void set_constant_uniforms();
+		// sets uniforms that do not change in between draw calls of the current camera
+		void set_constant_uniforms(const LightClusters &clusters, glm::ivec2 size);
 	};
 }
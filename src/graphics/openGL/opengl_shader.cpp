@@ -3,6 +3,7 @@
 #include <vector>
 #include <application/platform/fs_events.hpp>
 
+#include "gl_program_cache.hpp"
 #include "common_util/io.hpp"
 #include "application/log.hpp"
 #include "application/engine.hpp"
@@ -22,16 +23,70 @@ inline uint32_t opengl_shader_type(pge::ShaderType type)
     }
 }
 
-pge::Result<unsigned, pge::OpenGlErrorCode> load_file(const std::filesystem::path &path, pge::ShaderType type)
+// pastes the file of every #include "name" line, looked up next to the shader. the pasted code is source
+// string 1 so errors in it point at the right line. included files are not watched, saving the including
+// shader reloads them. empty if an included file could not be read
+static std::string paste_includes(const std::string &source, const std::filesystem::path &directory)
 {
-    auto contents = util::read_file(path);
+	constexpr std::string_view DIRECTIVE = "#include \"";
 
-    if (contents.empty())
-    {
-        return pge::OPENGL_ERROR_SHADER_CREATION;
-    }
+	std::string output;
+	size_t start = 0;
+	size_t line = 1;
+
+	while (start < source.size())
+	{
+		auto end = std::min(source.find('\n', start), source.size());
+		auto text = std::string_view(source).substr(start, end - start);
+
+		if (text.starts_with(DIRECTIVE))
+		{
+			auto name = text.substr(DIRECTIVE.size(), text.find('"', DIRECTIVE.size()) - DIRECTIVE.size());
+			auto included = util::read_file(directory / name);
 
-    auto data = contents.c_str();
+			if (included.empty())
+			{
+				Logger::info("could not read the shader include {}", name);
+				return {};
+			}
+
+			output += fmt::format("#line 1 1\n{}\n#line {} 0\n", included, line + 1);
+		}
+		else
+		{
+			output += text;
+			output += '\n';
+		}
+
+		start = end + 1;
+		line++;
+	}
+
+	return output;
+}
+
+// the source of a shader with the includes pasted and the defines inserted, empty if a file could not be read
+static std::string load_source(const std::filesystem::path &path, std::string_view defines)
+{
+    auto contents = paste_includes(util::read_file(path), path.parent_path());
+
+	// the version has to stay the first line, #line keeps the line numbers of errors matching the file
+	if (!contents.empty() && !defines.empty())
+	{
+		auto line_end = contents.find('\n');
+
+		if (line_end != std::string::npos)
+		{
+			contents.insert(line_end + 1, fmt::format("{}#line 2\n", defines));
+		}
+	}
+
+	return contents;
+}
+
+pge::Result<unsigned, pge::OpenGlErrorCode> compile_shader(const std::string &source, pge::ShaderType type)
+{
+    auto data = source.c_str();
 
     auto shader_type = opengl_shader_type(type);
     auto id = glCreateShader(shader_type);
@@ -49,15 +104,30 @@ pge::Result<unsigned, pge::OpenGlErrorCode> load_file(const std::filesystem::pat
 
         Logger::info("Error compiling opengl shader. {}", g_info_log);
 
+		glDeleteShader(id);
+
         return pge::OPENGL_ERROR_SHADER_CREATION;
     }
 
     return id;
 }
 
-uint32_t make_program(pge::ShaderList shaders, uint32_t &out_program)
+uint32_t make_program(pge::ShaderList shaders, std::string_view defines, uint32_t &out_program)
 {
-	std::array<uint32_t, pge::MAX_SHADERS_TYPES> cleanup {};
+	std::array<std::string, pge::MAX_SHADERS_TYPES> sources;
+	uint32_t shader_count = 0;
+
+	for (const auto &[path, _] : shaders)
+	{
+		sources[shader_count] = load_source(path, defines);
+
+		if (sources[shader_count].empty())
+		{
+			return pge::OPENGL_ERROR_SHADER_CREATION;
+		}
+
+		shader_count++;
+	}
 
     auto program = glCreateProgram();
 
@@ -66,14 +136,32 @@ uint32_t make_program(pge::ShaderList shaders, uint32_t &out_program)
         return pge::OPENGL_ERROR_SHADER_CREATION;
     }
 
+	auto key = pge::gl_program_cache.make_key(std::span(sources).first(shader_count));
+
+	if (pge::gl_program_cache.load(key, program))
+	{
+		out_program = program;
+
+		return pge::OPENGL_ERROR_OK;
+	}
+
+	std::array<uint32_t, pge::MAX_SHADERS_TYPES> cleanup {};
+
 	uint32_t shaders_created = 0;
 
-    for (const auto &[path, type] : shaders)
+    for (const auto &[_, type] : shaders)
     {
-        auto result = load_file(path, type);
+        auto result = compile_shader(sources[shaders_created], type);
 
         if (!result.ok())
         {
+			for (uint32_t i = 0; i < shaders_created; i++)
+			{
+				glDeleteShader(cleanup[i]);
+			}
+
+			glDeleteProgram(program);
+
             return result.error();
         }
 
@@ -83,21 +171,60 @@ uint32_t make_program(pge::ShaderList shaders, uint32_t &out_program)
 		shaders_created++;
     }
 
+	pge::GlProgramCache::prepare(program);
+
     glLinkProgram(program);
 
-	for (int i = 0; i < shaders_created; i++)
+	for (uint32_t i = 0; i < shaders_created; i++)
     {
         glDeleteShader(cleanup[i]);
     }
 
+	int linked;
+
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+
+	if (!linked)
+	{
+		glGetProgramInfoLog(program, LOG_SIZE, nullptr, g_info_log);
+
+		Logger::info("Error linking opengl program. {}", g_info_log);
+
+		glDeleteProgram(program);
+
+		return pge::OPENGL_ERROR_SHADER_CREATION;
+	}
+
+	pge::gl_program_cache.save(key, program);
+
 	out_program = program;
 
 	return pge::OPENGL_ERROR_OK;
 }
 
+// the defines of every bit set in the variant
+static std::string make_defines(const std::vector<std::string> &names, uint32_t variant)
+{
+	std::string output;
+
+	for (uint32_t i = 0; i < names.size(); i++)
+	{
+		if (variant & (1u << i))
+		{
+			output += fmt::format("#define {}\n", names[i]);
+		}
+	}
+
+	return output;
+}
+
 pge::GlShader::~GlShader()
 {
-    glDeleteProgram(m_program);
+	for (auto &[_, variant] : m_variants)
+	{
+    	glDeleteProgram(variant.program);
+		gl_state.forget_program(variant.program);
+	}
 
 	for (int i = 0; i < m_count; i++)
 	{
@@ -107,22 +234,21 @@ pge::GlShader::~GlShader()
 
 uint32_t pge::GlShader::create(pge::ShaderList shaders)
 {
+	return create(shaders, {});
+}
+
+uint32_t pge::GlShader::create(pge::ShaderList shaders, std::span<const std::string_view> defines)
+{
+	assert(defines.size() <= 32 && "a variant has a bit per define");
+
 	if (m_monitors[0] == -1)
 	{
 		for (auto i = 0; auto &[path, _] : shaders)
 		{
 			m_monitors[i] = Engine::fs_monitor.add_watch(path.c_str(), FSE_MODIFY,
-			[&program = m_program, &cache = m_cache, shaders](int mask, std::string_view _)
+			[this](int, std::string_view)
 			{
-				glDeleteProgram(program);
-				make_program(shaders, program);
-
-				glUseProgram(program);
-
-				for (auto &[name, value] : cache)
-				{
-					set_uniform(program, name, value);
-				}
+				reload();
 			});
 
 			i++;
@@ -130,8 +256,84 @@ uint32_t pge::GlShader::create(pge::ShaderList shaders)
 	}
 
 	m_count = shaders.count();
+	m_shaders = shaders;
+	m_defines.assign(defines.begin(), defines.end());
+	m_variant = 0;
+
+	auto result = make_program(shaders, "", m_program);
+
+	m_variants[0] = {m_program, m_version};
+
+    return result;
+}
+
+pge::GlShader& pge::GlShader::use(uint32_t variant)
+{
+	if (variant == m_variant)
+	{
+		gl_state.use_program(m_program);
+		return *this;
+	}
+
+	// every set since the last switch went to the variant that was in use
+	m_variants[m_variant].version = m_version;
+
+	auto [iter, inserted] = m_variants.try_emplace(variant, Variant{0, 0});
+
+	if (inserted && m_shaders)
+	{
+		if (make_program(*m_shaders, make_defines(m_defines, variant), iter->second.program) != OPENGL_ERROR_OK)
+		{
+			// the program stays 0 so a broken variant is not compiled again every frame
+			Logger::info("could not compile variant {:#x} of a shader", variant);
+		}
+	}
+
+	m_variant = variant;
+	m_program = iter->second.program;
+
+	gl_state.use_program(m_program);
+
+	if (iter->second.version == m_version)
+	{
+		return *this;
+	}
+
+	for (auto &[name, uniform] : m_cache)
+	{
+		if (uniform.version > iter->second.version)
+		{
+			set_uniform(m_program, name, uniform.value);
+		}
+	}
 
-    return make_program(shaders, m_program);
+	return *this;
+}
+
+void pge::GlShader::reload()
+{
+	for (auto &[_, variant] : m_variants)
+	{
+		glDeleteProgram(variant.program);
+		gl_state.forget_program(variant.program);
+	}
+
+	m_variants.clear();
+
+	// only the variant in use is compiled right away, the others once they are used again
+	if (make_program(*m_shaders, make_defines(m_defines, m_variant), m_program) != OPENGL_ERROR_OK)
+	{
+		m_program = 0;
+	}
+
+	m_variants[m_variant] = {m_program, m_version};
+
+	gl_state.use_program(m_program);
+
+	for (auto &[name, uniform] : m_cache)
+	{
+		set_uniform(m_program, name, uniform.value);
+	}
 }
 
 void pge::set_uniform(uint32_t program, std::string_view name, const pge::UniformValue &value)
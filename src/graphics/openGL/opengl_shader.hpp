@@ -1,9 +1,13 @@
 #pragma once
 
 #include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
 #include <glm/gtc/type_ptr.hpp>
 
 #include "opengl_error.hpp"
+#include "gl_state.hpp"
 #include "../shader_interface.hpp"
 #include "../../application/log.hpp"
 #include "../../application/error.hpp"
@@ -24,17 +28,24 @@ namespace pge
 
         uint32_t create(ShaderList shaders) override;
 
+		// every bit of a variant turns on the define with the same index, a variant is compiled the first time
+		// it is used. the variant without any defines is compiled right away to catch errors early
+		uint32_t create(ShaderList shaders, std::span<const std::string_view> defines);
+
         IShader& use() override
         {
-            glUseProgram(m_program);
-			return *this;
+            return use(m_variant);
         }
 
+		// switches to the program of the variant. uniforms set while other variants were used
+		// are set on it again before it is used
+		GlShader& use(uint32_t variant);
+
         IShader& set(std::string_view name, int value) override
         {
             auto location = glGetUniformLocation(m_program, name.data());
             glUniform1i(location, value);
-			m_cache[name] = value;
+			store(name, value);
 			return *this;
         }
 
@@ -42,7 +53,7 @@ namespace pge
         {
             auto location = glGetUniformLocation(m_program, name.data());
             glUniform1f(location, value);
-			m_cache[name] = value;
+			store(name, value);
 			return *this;
         }
 
@@ -50,7 +61,7 @@ namespace pge
         {
             auto location = glGetUniformLocation(m_program, name.data());
             glUniform2f(location, EXPAND_VEC2(value));
-			m_cache[name] = value;
+			store(name, value);
 			return *this;
         }
 
@@ -58,7 +69,7 @@ namespace pge
         {
             auto location = glGetUniformLocation(m_program, name.data());
             glUniform3f(location, EXPAND_VEC3(value));
-			m_cache[name] = value;
+			store(name, value);
 			return *this;
         }
 
@@ -66,7 +77,7 @@ namespace pge
         {
             auto location = glGetUniformLocation(m_program, name.data());
             glUniform4f(location, EXPAND_VEC4(value));
-			m_cache[name] = value;
+			store(name, value);
 			return *this;
         }
 
@@ -74,7 +85,7 @@ namespace pge
         {
             auto location = glGetUniformLocation(m_program, name.data());
             glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
-			m_cache[name] = value;
+			store(name, value);
 			return *this;
         }
 
@@ -85,18 +96,62 @@ namespace pge
 //			return *this;
 //        }
 
+		// the program of the variant in use
 		[[nodiscard]]
 		uint32_t get_program() const
 		{
 			return m_program;
 		}
 
+		// the number of variants compiled so far
+		[[nodiscard]]
+		size_t variant_count() const
+		{
+			return m_variants.size();
+		}
+
     private:
+		struct CachedUniform
+		{
+			UniformValue value;
+			// the value of m_version when the uniform was set
+			uint32_t version;
+		};
+
+		struct Variant
+		{
+			uint32_t program;
+			// the uniforms set after this version still have to be set on the program
+			uint32_t version;
+		};
+
         uint32_t m_program = 0;
+		uint32_t m_variant = 0;
 		uint32_t m_count = 0;
 		std::array<int, MAX_SHADERS_TYPES> m_monitors = {-1};
-		// a cache for uniforms used to set uniforms to their previous state when shaders reload
-		HashMap<std::string, UniformValue, ENABLE_TRANSPARENT_HASH> m_cache;
+		std::optional<ShaderList> m_shaders;
+		std::vector<std::string> m_defines;
+		HashMap<uint32_t, Variant> m_variants;
+		// the last value of every uniform, used to set uniforms on new variants and when shaders reload
+		HashMap<std::string, CachedUniform, ENABLE_TRANSPARENT_HASH> m_cache;
+		// counts every set so a variant only gets the uniforms that changed since it was last used
+		uint32_t m_version = 0;
+
+		void store(std::string_view name, const UniformValue &value)
+		{
+			auto iter = m_cache.find(name);
+
+			if (iter == m_cache.end())
+			{
+				m_cache.emplace(std::string(name), CachedUniform{value, ++m_version});
+			}
+			else
+			{
+				iter->second = {value, ++m_version};
+			}
+		}
+
+		// compiles every variant again the next time it is used, the one in use right away
+		void reload();
     };
 }
-
@@ -2,43 +2,79 @@
 
 #include "shadow_map.hpp"
 #include "opengl_error.hpp"
+#include "gl_state.hpp"
 #include <glad/glad.h>
 
-uint32_t pge::create_shadow_map(int width, int height, GlFramebuffer &fb)
+uint32_t pge::create_shadow_atlas(int size, GlFramebuffer &fb)
 {
-	fb.tex_target = GL_TEXTURE_CUBE_MAP;
+	fb.tex_target = GL_TEXTURE_2D;
 
 	glGenTextures(1, &fb.textures[0]);
-	glBindTexture(fb.tex_target, fb.textures[0]);
+	gl_state.edit_texture(fb.tex_target, fb.textures[0]);
 
-	for (int i = 0; i < 6; ++i)
-	{
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT,
-			width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
-	}
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT16, size, size, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_SHORT, nullptr);
 
-	glTexParameteri(fb.tex_target, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(fb.tex_target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	// sampled with depth comparison, linear filtering compares against 2x2 texels and blends the results
+	glTexParameteri(fb.tex_target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(fb.tex_target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(fb.tex_target, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTexParameteri(fb.tex_target, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
 
- 	glTexParameteri(fb.tex_target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(fb.tex_target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(fb.tex_target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glTexParameteri(fb.tex_target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(fb.tex_target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
 	glGenFramebuffers(1, &fb.fbo);
-	glBindFramebuffer(GL_FRAMEBUFFER, fb.fbo);
+	gl_state.bind_framebuffer(GL_FRAMEBUFFER, fb.fbo);
 	glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, fb.textures[0], 0);
 
 	glDrawBuffer(GL_NONE);
 	glReadBuffer(GL_NONE);
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	glBindTexture(fb.tex_target, 0);
+	auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+
+	gl_state.bind_framebuffer(GL_FRAMEBUFFER, 0);
 
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-    {
-        return OPENGL_ERROR_FRAMEBUFFER_CREATION;
-    }
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		return OPENGL_ERROR_FRAMEBUFFER_CREATION;
+	}
 
 	return OPENGL_ERROR_OK;
 }
 
+uint32_t pge::create_cascade_shadow_map(int size, int layers, GlFramebuffer &fb)
+{
+	fb.tex_target = GL_TEXTURE_2D_ARRAY;
+
+	glGenTextures(1, &fb.textures[0]);
+	gl_state.edit_texture(fb.tex_target, fb.textures[0]);
+
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT16, size, size, layers, 0, GL_DEPTH_COMPONENT,
+		GL_UNSIGNED_SHORT, nullptr);
+
+	glTexParameteri(fb.tex_target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(fb.tex_target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(fb.tex_target, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTexParameteri(fb.tex_target, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+	glTexParameteri(fb.tex_target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(fb.tex_target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glGenFramebuffers(1, &fb.fbo);
+	gl_state.bind_framebuffer(GL_FRAMEBUFFER, fb.fbo);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, fb.textures[0], 0, 0);
+
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+
+	auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+
+	gl_state.bind_framebuffer(GL_FRAMEBUFFER, 0);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		return OPENGL_ERROR_FRAMEBUFFER_CREATION;
+	}
+
+	return OPENGL_ERROR_OK;
+}
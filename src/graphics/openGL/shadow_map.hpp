@@ -4,5 +4,11 @@
 
 namespace pge
 {
-	uint32_t create_shadow_map(int width, int height, GlFramebuffer &fb);
+	// a 16 bit depth texture shared by the shadows of every point and spot light, each renders into its own tiles.
+	// 16 bits are enough since the shaders store the linear distance to the light divided by the shadow distance.
+	// both maps are sampled with depth comparison
+	uint32_t create_shadow_atlas(int size, GlFramebuffer &fb);
+
+	// a depth array with a layer per cascade of a directional light, a layer is attached before rendering to it
+	uint32_t create_cascade_shadow_map(int size, int layers, GlFramebuffer &fb);
 }
\ No newline at end of file
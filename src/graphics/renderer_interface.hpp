@@ -18,6 +18,8 @@
 
 namespace pge
 {
+    class FrameRecorder;
+
     struct RendererProperties
     {
         std::string device_name;
@@ -87,6 +89,10 @@ namespace pge
 
         virtual Image get_image() = 0;
 
+		// reads the screen, or the framebuffer if one is given, once the current frame is rendered.
+		// the callback runs on the main thread a frame or two later so the frame never waits for the gpu
+		virtual void read_image_async(IFramebuffer *framebuffer, ImageCallback callback) = 0;
+
         virtual void delete_texture(uint32_t id) = 0;
 
         virtual void set_skybox(uint32_t id) = 0;
@@ -96,6 +102,12 @@ namespace pge
             m_camera = camera;
         }
 
+		// every frame ended while a recorder is set gets handed to it, the recorder is dropped once it is done
+		void set_frame_recorder(FrameRecorder *recorder)
+		{
+			m_frame_recorder = recorder;
+		}
+
 		virtual RenderView* add_view(Camera *camera) = 0;
 
 		virtual void remove_view(RenderView *view) = 0;
@@ -113,10 +125,18 @@ namespace pge
 		virtual void set_texture_settings(TextureSettings settings) = 0;
 		virtual TextureSettings get_texture_settings() = 0;
 
+		virtual uint32_t set_pipeline_settings(PipelineSettings settings) = 0;
+		virtual PipelineSettings get_pipeline_settings() = 0;
+
+		// the vertex format can only be chosen before the renderer is initialized
+		virtual void set_geometry_settings(GeometrySettings settings) = 0;
+		virtual GeometrySettings get_geometry_settings() = 0;
+
 		virtual RenderStats get_stats() = 0;
 
     protected:
         // the main camera that will be used for renders.
         Camera *m_camera;
+		FrameRecorder *m_frame_recorder = nullptr;
     };
 }
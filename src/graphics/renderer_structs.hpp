@@ -4,6 +4,9 @@
 
 namespace pge
 {
+	// the most cascades the shadow of a directional light can be split into
+	constexpr int MAX_SHADOW_CASCADES = 4;
+
     enum class OutlineMethod : uint8_t
     {
         // uses the stencil buffer to create outlines
@@ -59,6 +62,28 @@ namespace pge
 	{
 		uint32_t vertices = 0;
 		uint32_t draw_calls = 0;
+		uint32_t shadow_map_updates = 0;
+		// cascades of the directional light rendered this frame
+		uint32_t cascade_updates = 0;
+		// point and spot lights that got a tile of the shadow atlas, and the bytes of the atlas and cascades
+		uint32_t shadowed_lights = 0;
+		uint64_t shadow_memory = 0;
+		// samples shaded by the opaque lighting pass of the main view, read a frame late
+		uint64_t shaded_fragments = 0;
+		// samples that passed the depth pre-pass, what the lighting pass would shade without it
+		uint64_t prepass_fragments = 0;
+		// draws of the main view skipped for being outside the frustum or hidden behind occluders
+		uint32_t frustum_culled_draws = 0;
+		uint32_t occluded_draws = 0;
+		uint32_t occluder_triangles = 0;
+		// triangles of the draws the main view submits after culling and lod selection
+		uint32_t triangles = 0;
+		// gpu time of the last finished frame and the resolution scale the main view was rendered at
+		float gpu_frame_ms = 0;
+		float resolution_scale = 1;
+		// gl state calls that reached the driver this frame and the redundant ones the state cache dropped
+		uint32_t state_changes = 0;
+		uint32_t filtered_state_changes = 0;
 	};
 
 	struct TextureSettings
@@ -67,23 +92,123 @@ namespace pge
 		float anisotropic_distance = 100;
 	};
 
+	enum class ShadowQuality : uint8_t
+	{
+		// only the 4 probe taps
+		Low,
+		// 12 taps in the penumbra
+		Medium,
+		// 24 taps in the penumbra
+		High,
+		// 32 taps in the penumbra
+		Ultra,
+	};
+
     struct ShadowSettings
     {
-		int pcf_samples = 20;
+		// soft shadows take a few taps first and only filter with the full kernel where they disagree.
+		// every tap compares against 2x2 texels in hardware
+		ShadowQuality quality = ShadowQuality::Medium;
+		// the radius of the filter in texels of the shadow map
+		float filter_radius = 2.0f;
 		float bias = 0.05;
 		bool enable_soft = true;
-		int width = 2048;
-		int height = 2048;
+		// the largest and smallest face a point or spot light gets in the shadow atlas,
+		// lights covering more of the screen get larger faces
+		int max_resolution = 1024;
+		int min_resolution = 128;
+		// the shadow atlas and the cascades together stay below this, the atlas gets what the cascades leave
+		int memory_budget_mb = 64;
 		float distance = 100.0f;
+		// render all cube faces in one pass with a geometry shader instead of culling casters per face
+		bool use_geometry_shader = false;
+		// the shadow of a directional light is split into cascades along the view, each with its own map
+		int cascade_count = 4;
+		int cascade_size = 2048;
+		// the view distance the cascades cover, past it directional lights cast no shadow
+		float cascade_distance = 150.0f;
+		// 0 splits the distance evenly, 1 logarithmically which gives the near cascades more of the texels
+		float cascade_split_lambda = 0.75f;
+		// renders the first cascade every frame and only one of the others, the far ones barely move on screen
+		bool stagger_cascades = false;
     };
 
+	enum class BloomQuality : uint8_t
+	{
+		// 4 mips
+		Low,
+		// 6 mips
+		Medium,
+		// 8 mips and a brightness weighted first downsample that keeps small highlights from flickering
+		High,
+	};
+
 	struct ScreenSpaceSettings
 	{
 		float gamma = 1.4;
 		float exposure = 2.7;
 		float bright_threshold = 1.4;
 		bool enable_bloom = true;
-		int bloom_blur_passes = 10;
+		// every extra mip spreads the bloom wider and costs a quarter of the mip before it
+		BloomQuality bloom_quality = BloomQuality::Medium;
+		// spread of the upsample filter in texels
+		float bloom_radius = 1.0f;
+		float bloom_intensity = 1.0f;
+	};
+
+	enum class VertexFormat : uint8_t
+	{
+		// every attribute as full floats, 56 bytes per vertex
+		Full,
+		// quantized positions, 10:10:10:2 normal and tangent frame and half float texture coordinates, 20 bytes per vertex
+		Packed,
+	};
+
+	struct GeometrySettings
+	{
+		// only read when the renderer is initialized since every mesh shares one vertex buffer
+		VertexFormat vertex_format = VertexFormat::Full;
+		// draws the simplified lods of meshes. lods are only generated for models loaded while this is on
+		bool use_lods = false;
+		// a lod is used while its error covers at most this many pixels on screen
+		float lod_threshold = 1.0f;
+		// fraction below the threshold the error of a coarser lod has to be before a draw switches to it
+		float lod_hysteresis = 0.25f;
+		// shadow maps use lods this many levels coarser than their resolution would pick
+		uint32_t shadow_lod_bias = 1;
+	};
+
+	enum class RenderPath : uint8_t
+	{
+		// every mesh is lit while it is drawn
+		Forward,
+		// opaque meshes are written to a g-buffer and lit in one screen pass, transparent meshes stay forward
+		Deferred,
+	};
+
+	enum class TransparencyMode : uint8_t
+	{
+		// transparent meshes are sorted back to front by their center and blended over each other
+		Sorted,
+		// weighted blended order independent transparency. every layer is summed into two targets
+		// weighted by depth and coverage, then composited once, so the draws batch like opaque ones.
+		// transparent meshes do not add to the bloom in this mode
+		WeightedBlended,
+	};
+
+	struct PipelineSettings
+	{
+		RenderPath path = RenderPath::Forward;
+		TransparencyMode transparency = TransparencyMode::Sorted;
+		// renders opaque meshes depth only first so the lighting pass only shades visible fragments, forward only
+		bool depth_prepass = false;
+		// skips draws outside the view and draws hidden behind large meshes rasterized on the cpu
+		bool occlusion_culling = false;
+		// renders the main view into part of its targets and scales it up to the screen,
+		// the scale follows the gpu frame time so it stays within the budget
+		bool dynamic_resolution = false;
+		float target_frame_ms = 16.0f;
+		float min_resolution_scale = 0.5f;
 	};
 
 	struct AllRenderSettings
@@ -91,5 +216,7 @@ namespace pge
 		TextureSettings texture;
 		ShadowSettings shadow;
 		ScreenSpaceSettings screen_space;
+		GeometrySettings geometry;
+		PipelineSettings pipeline;
 	};
 }
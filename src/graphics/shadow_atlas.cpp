@@ -0,0 +1,101 @@
+#include "shadow_atlas.hpp"
+
+#include <algorithm>
+#include <bit>
+
+void pge::ShadowAtlas::reset(uint32_t size, uint32_t min_tile_size)
+{
+	m_size = std::bit_floor(size);
+
+	auto levels = std::countr_zero(m_size) - std::countr_zero(std::bit_floor(std::max(min_tile_size, 1u))) + 1;
+
+	m_free.assign(std::max(levels, 1), {});
+	m_free[0].push_back({0, 0});
+}
+
+std::optional<pge::ShadowAtlas::Tile> pge::ShadowAtlas::allocate(uint32_t size)
+{
+	if (m_free.empty())
+	{
+		return std::nullopt;
+	}
+
+	size = std::clamp(std::bit_ceil(size), m_size >> (m_free.size() - 1), m_size);
+
+	auto level = std::countr_zero(m_size) - std::countr_zero(size);
+	auto position = allocate_level(level);
+
+	if (!position)
+	{
+		return std::nullopt;
+	}
+
+	return Tile{*position, (uint16_t)size};
+}
+
+void pge::ShadowAtlas::free(Tile tile)
+{
+	free_level(tile.position, std::countr_zero(m_size) - std::countr_zero((uint32_t)tile.size));
+}
+
+std::optional<glm::u16vec2> pge::ShadowAtlas::allocate_level(uint32_t level)
+{
+	auto &free = m_free[level];
+
+	if (!free.empty())
+	{
+		auto position = free.back();
+		free.pop_back();
+
+		return position;
+	}
+
+	if (level == 0)
+	{
+		return std::nullopt;
+	}
+
+	auto parent = allocate_level(level - 1);
+
+	if (!parent)
+	{
+		return std::nullopt;
+	}
+
+	// the first quarter is handed out and the other three wait for the next tile of this size
+	auto half = uint16_t(m_size >> level);
+
+	free.push_back({parent->x + half, parent->y});
+	free.push_back({parent->x, parent->y + half});
+	free.push_back({parent->x + half, parent->y + half});
+
+	return parent;
+}
+
+void pge::ShadowAtlas::free_level(glm::u16vec2 position, uint32_t level)
+{
+	auto &free = m_free[level];
+
+	if (level > 0)
+	{
+		auto size = uint16_t(m_size >> level);
+		// the corner of the tile this one was split from
+		glm::u16vec2 parent = position / uint16_t(size * 2) * uint16_t(size * 2);
+
+		auto is_sibling = [&](glm::u16vec2 other)
+		{
+			return other / uint16_t(size * 2) * uint16_t(size * 2) == parent;
+		};
+
+		// the other three quarters are free so the parent tile is whole again
+		if (std::count_if(free.begin(), free.end(), is_sibling) == 3)
+		{
+			std::erase_if(free, is_sibling);
+			free_level(parent, level - 1);
+
+			return;
+		}
+	}
+
+	free.push_back(position);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace pge
+{
+	// hands out square power of two tiles of one large shadow texture. a tile is split into four
+	// when a smaller one is needed and merged back once all four are free, so the atlas does not fragment
+	class ShadowAtlas
+	{
+	public:
+		struct Tile
+		{
+			// the corner and size of the tile in texels
+			glm::u16vec2 position;
+			uint16_t size;
+		};
+
+		// forgets every tile, the atlas starts out as one free tile of the given size
+		void reset(uint32_t size, uint32_t min_tile_size);
+
+		// size is rounded up to a power of two and clamped to the atlas, nothing is returned when it is full
+		std::optional<Tile> allocate(uint32_t size);
+
+		void free(Tile tile);
+
+		[[nodiscard]]
+		uint32_t size() const
+		{
+			return m_size;
+		}
+
+	private:
+		uint32_t m_size = 0;
+		// the free tiles of every level, level 0 is the whole atlas and each level halves the size
+		std::vector<std::vector<glm::u16vec2>> m_free;
+
+		std::optional<glm::u16vec2> allocate_level(uint32_t level);
+
+		void free_level(glm::u16vec2 position, uint32_t level);
+	};
+}
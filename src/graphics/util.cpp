@@ -1,18 +1,72 @@
 #include "util.hpp"
 #include "../application/engine.hpp"
 
-void pge::screen_shot(std::string_view path, IFramebuffer* framebuffer)
+// frames waiting for the writer past this are dropped instead of piling up in memory
+#define MAX_PENDING_CAPTURES 16
+
+namespace
+{
+	struct Capture
+	{
+		bool active = false;
+		std::string path;
+		pge::IFramebuffer *framebuffer = nullptr;
+		pge::ImgFmt format = pge::ImgFmt::Bmp;
+		uint32_t frame = 0;
+		uint32_t dropped = 0;
+	};
+
+	Capture capture;
+}
+
+void pge::screen_shot(std::string_view path, IFramebuffer* framebuffer, ImgFmt format)
+{
+	Engine::renderer->read_image_async(framebuffer, [path = std::string(path), format](Image image)
+	{
+		image.format = format;
+
+		Engine::image_writer.save(std::move(image), path);
+	});
+}
+
+void pge::start_capture(std::string_view path, IFramebuffer *framebuffer, ImgFmt format)
+{
+	capture = {true, std::string(path), framebuffer, format};
+}
+
+void pge::stop_capture()
+{
+	if (!capture.active)
+	{
+		return;
+	}
+
+	if (capture.dropped > 0)
+	{
+		Logger::warn("capture {} dropped {} of {} frames, the images could not be written fast enough",
+			capture.path, capture.dropped, capture.frame + capture.dropped);
+	}
+
+	capture.active = false;
+}
+
+bool pge::is_capturing()
 {
-    Image img;
-
-    if (framebuffer != nullptr)
-    {
-       img = framebuffer->get_image();
-    }
-    else
-    {
-        img = Engine::renderer->get_image();
-    }
-
-    img.save(path);
+	return capture.active;
+}
+
+void pge::capture_frame()
+{
+	if (!capture.active)
+	{
+		return;
+	}
+
+	if (Engine::image_writer.pending() >= MAX_PENDING_CAPTURES)
+	{
+		capture.dropped++;
+		return;
+	}
+
+	screen_shot(fmt::format("{}_{:06}", capture.path, capture.frame++), capture.framebuffer, capture.format);
 }
@@ -7,5 +7,19 @@
 
 namespace pge
 {
-    void screen_shot(std::string_view path, IFramebuffer *framebuffer = nullptr);
+	// saves the next rendered frame. the pixels are read back and encoded in the background
+	// so the file shows up a few frames later
+    void screen_shot(std::string_view path, IFramebuffer *framebuffer = nullptr, ImgFmt format = ImgFmt::Png);
+
+	// saves every frame until stop_capture as path_000000, path_000001 and so on.
+	// bmp is the default since it barely needs encoding and the writer can keep up with the frame rate
+	void start_capture(std::string_view path, IFramebuffer *framebuffer = nullptr, ImgFmt format = ImgFmt::Bmp);
+
+	void stop_capture();
+
+	[[nodiscard]]
+	bool is_capturing();
+
+	// queues the current frame of a running capture, called by the engine every frame
+	void capture_frame();
 }
@@ -0,0 +1,68 @@
+#version 460 core
+
+out vec4 frag_color;
+in vec2 tex_coords;
+
+uniform sampler2D image;
+// weights the taps by their brightness so single very bright pixels cannot flicker through the whole bloom
+uniform bool karis_average;
+// the part of the image to read, smaller than 1 when the scene was rendered at a lower resolution.
+// taps are clamped to the last texel center inside it so nothing outside can bleed in
+uniform vec2 uv_scale;
+uniform vec2 uv_max;
+
+float karis_weight(vec3 color)
+{
+    float luma = dot(color, vec3(0.2126, 0.7152, 0.0722));
+
+    return 1.0 / (1.0 + luma);
+}
+
+// averages four taps, weighted by their brightness when the karis average is enabled
+vec3 average(vec3 a, vec3 b, vec3 c, vec3 d)
+{
+    if (!karis_average)
+    {
+        return (a + b + c + d) * 0.25;
+    }
+
+    vec4 sum = vec4(a, 1) * karis_weight(a) + vec4(b, 1) * karis_weight(b)
+        + vec4(c, 1) * karis_weight(c) + vec4(d, 1) * karis_weight(d);
+
+    return sum.rgb / sum.a;
+}
+
+vec3 tap(vec2 coords, vec2 offset)
+{
+    return texture(image, min(coords + offset, uv_max)).rgb;
+}
+
+// the 13 tap filter from next generation post processing in call of duty advanced warfare.
+// five overlapping boxes of 4 bilinear taps each, the center box counts for half
+void main()
+{
+    vec2 texel = 1.0 / textureSize(image, 0);
+    vec2 coords = tex_coords * uv_scale;
+
+    vec3 a = tap(coords, texel * vec2(-2,  2));
+    vec3 b = tap(coords, texel * vec2( 0,  2));
+    vec3 c = tap(coords, texel * vec2( 2,  2));
+    vec3 d = tap(coords, texel * vec2(-2,  0));
+    vec3 e = tap(coords, vec2(0));
+    vec3 f = tap(coords, texel * vec2( 2,  0));
+    vec3 g = tap(coords, texel * vec2(-2, -2));
+    vec3 h = tap(coords, texel * vec2( 0, -2));
+    vec3 i = tap(coords, texel * vec2( 2, -2));
+    vec3 j = tap(coords, texel * vec2(-1,  1));
+    vec3 k = tap(coords, texel * vec2( 1,  1));
+    vec3 l = tap(coords, texel * vec2(-1, -1));
+    vec3 m = tap(coords, texel * vec2( 1, -1));
+
+    vec3 result = average(j, k, l, m) * 0.5
+        + average(a, b, d, e) * 0.125
+        + average(b, c, e, f) * 0.125
+        + average(d, e, g, h) * 0.125
+        + average(e, f, h, i) * 0.125;
+
+    frag_color = vec4(max(result, 0.0), 1.0);
+}
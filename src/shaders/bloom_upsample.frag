@@ -0,0 +1,28 @@
+#version 460 core
+
+out vec4 frag_color;
+in vec2 tex_coords;
+
+uniform sampler2D image;
+// spread of the tent filter in texels of the smaller mip
+uniform float radius;
+
+// 3x3 tent filter, the result gets added onto the larger mip by blending
+void main()
+{
+    vec2 texel = radius / textureSize(image, 0);
+
+    vec3 result = texture(image, tex_coords).rgb * 4.0;
+
+    result += texture(image, tex_coords + texel * vec2( 0,  1)).rgb * 2.0;
+    result += texture(image, tex_coords + texel * vec2(-1,  0)).rgb * 2.0;
+    result += texture(image, tex_coords + texel * vec2( 1,  0)).rgb * 2.0;
+    result += texture(image, tex_coords + texel * vec2( 0, -1)).rgb * 2.0;
+
+    result += texture(image, tex_coords + texel * vec2(-1,  1)).rgb;
+    result += texture(image, tex_coords + texel * vec2( 1,  1)).rgb;
+    result += texture(image, tex_coords + texel * vec2(-1, -1)).rgb;
+    result += texture(image, tex_coords + texel * vec2( 1, -1)).rgb;
+
+    frag_color = vec4(result / 16.0, 1.0);
+}
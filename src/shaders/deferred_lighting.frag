@@ -0,0 +1,166 @@
+#version 460 core
+
+// compiled in variants of SOFT_SHADOWS and VISUALIZE_DEPTH, the material flags come from the g-buffer
+
+layout (location = 0) out vec4 frag_color;
+layout (location = 1) out vec4 bright_color;
+
+in vec2 tex_coords;
+
+uniform float bright_threshold;
+
+#include "lighting_common.glsl"
+
+// written by gbuffer.frag
+uniform sampler2D gbuffer_albedo;
+uniform sampler2D gbuffer_normal;
+uniform sampler2D gbuffer_color;
+uniform sampler2D gbuffer_depth;
+
+uniform mat4 inverse_view_projection;
+
+// values taken from model.hpp
+#define MAT_RECEIVE_LIGHT 4u
+#define MAT_CAST_SHADOW 8u
+#define MAT_CONTRIBUTE_BLOOM 16u
+
+// the surface being lit, everything is in world space
+struct Surface
+{
+    vec3 position;
+    vec3 normal;
+    vec3 diffuse;
+    float specular;
+    float shininess;
+    float emission;
+    uint flags;
+};
+
+Surface surface;
+
+bool has_flag(uint flag)
+{
+    return (surface.flags & flag) != 0u;
+}
+
+vec3 calculate_lighting(Light light, vec3 view_dir)
+{
+    // directional lights have no position, only the direction they shine in
+    vec3 light_dir = light.is_directional ? normalize(-light.direction) : normalize(light.position - surface.position);
+    vec3 halfway_dir = normalize(light_dir + view_dir);
+
+    float diff = max(dot(surface.normal, light_dir), 0.0);
+
+    vec3 diffuse = light.color * light.diffuse * diff * surface.diffuse * light.power;
+    vec3 ambient =  light.color * surface.diffuse * light.ambient * light.power;
+
+    float spec = pow(max(dot(surface.normal, halfway_dir), 0.0), surface.shininess);
+    vec3 specular = light.color * surface.specular * spec * light.specular * light.power;
+
+    if (light.is_spot)
+    {
+        float epsilon = light.cutoff - light.outer_cutoff;
+        float theta   = dot(light_dir, normalize(-light.direction));
+        float intensity = clamp((theta - light.outer_cutoff) / epsilon, 0.0, 1.0);
+
+        diffuse  *= intensity;
+        specular *= intensity;
+    }
+
+    // directional lights are as strong everywhere
+    float attenuation = light.is_directional ? 1.0 : get_attenuation(light, surface.position);
+
+    ambient  *= attenuation;
+    diffuse  *= attenuation;
+    specular *= attenuation;
+
+    float shadow = has_flag(MAT_CAST_SHADOW) ? calculate_shadows(light, surface.position) : 0;
+
+    return ambient + (1 - shadow) * (diffuse + specular);
+}
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec2 depth_flags = texelFetch(gbuffer_depth, pixel, 0).rg;
+    float depth = depth_flags.r;
+
+    // nothing was drawn here so the clear color and the skybox stay visible
+    if (depth >= 1.0)
+    {
+        discard;
+    }
+
+    // written to the target so the skybox and the forward transparent meshes get depth tested against the scene
+    gl_FragDepth = depth;
+
+#ifdef VISUALIZE_DEPTH
+    frag_color = vec4(vec3(linear_depth(depth) / camera_far), 1.0);
+    bright_color = vec4(0, 0, 0, 1);
+    return;
+#endif
+
+    vec4 albedo = texelFetch(gbuffer_albedo, pixel, 0);
+    vec4 normal = texelFetch(gbuffer_normal, pixel, 0);
+    vec4 color = texelFetch(gbuffer_color, pixel, 0);
+
+    vec4 world = inverse_view_projection * vec4(tex_coords * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+
+    surface.position = world.xyz / world.w;
+    surface.normal = normalize(normal.xyz);
+    surface.diffuse = albedo.rgb;
+    surface.specular = albedo.a;
+    surface.shininess = normal.a;
+    surface.emission = color.a;
+    surface.flags = uint(depth_flags.g);
+
+    vec3 result = vec3(0);
+    bool unlit = false;
+
+    if (has_flag(MAT_RECEIVE_LIGHT))
+    {
+        vec3 view_dir = normalize(view_pos.xyz - surface.position);
+        uvec2 cluster = clusters[cluster_index(depth)];
+
+        for (uint i = 0u; i < cluster.y; i++)
+        {
+            result += calculate_lighting(lights[light_indices[cluster.x + i]], view_dir);
+        }
+
+        // directional lights reach every pixel so they are not binned into the clusters
+        for (uint i = 0u; i < directional_lights.y; i++)
+        {
+            result += calculate_lighting(lights[directional_lights.x + i], view_dir);
+        }
+
+        // emission does not depend on the lights so it is added once
+        result += surface.emission;
+        unlit = !scene_has_lights();
+    }
+    else
+    {
+        result += surface.diffuse;
+    }
+
+    if (any(greaterThan(color.rgb, vec3(0.0))))
+    {
+        if (unlit)
+        {
+            result = vec3(1);
+        }
+        result *= color.rgb;
+    }
+
+    float brightness = dot(result, vec3(0.2126, 0.7152, 0.0722));
+
+    if (brightness > bright_threshold && has_flag(MAT_CONTRIBUTE_BLOOM))
+    {
+        bright_color = vec4(result, 1);
+    }
+    else
+    {
+        bright_color = vec4(0, 0, 0, 1);
+    }
+
+    frag_color = vec4(result, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,16 @@
+#version 460 core
+
+in vec2 tex_coords;
+flat in float texture_scale;
+
+uniform sampler2D diffuse_sampler;
+uniform bool diffuse_enabled;
+
+void main()
+{
+    // the same cutout test as lighting.frag, otherwise the holes would keep the depth of the cutout
+    if (diffuse_enabled && texture(diffuse_sampler, tex_coords * texture_scale).a < 0.1)
+    {
+        discard;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#version 460  core
+
+layout(location = 0) in vec3 in_pos;
+layout(location = 2) in vec2 in_tex_cord;
+
+// must match DrawInfo in lighting.vert
+struct DrawInfo
+{
+    mat4 model;
+    vec4 position_offset;
+    vec4 position_scale;
+    vec4 color;
+    float shininess;
+    float specular;
+    float emission;
+    float transparency;
+    float depth_strength;
+    float bump_strength;
+    float texture_scale;
+    uint flags;
+};
+
+layout(std430, binding = 0) readonly buffer DrawBuffer
+{
+    DrawInfo draws[];
+};
+
+layout(std140, binding = 0) uniform FrameData
+{
+    mat4 view_projection;
+    vec4 view_pos;
+    float camera_near;
+    float camera_far;
+    float shadow_far;
+    vec4 cluster_scale;
+};
+
+uniform int draw_offset;
+
+out vec2 tex_coords;
+flat out float texture_scale;
+
+// must be computed exactly like lighting.vert for the GL_EQUAL depth test in the shading pass
+invariant gl_Position;
+
+void main()
+{
+    DrawInfo draw = draws[draw_offset + gl_DrawID];
+    vec3 position = draw.position_offset.xyz + in_pos * draw.position_scale.xyz;
+
+    vec3 frag_pos = vec3(draw.model * vec4(position, 1.0));
+
+    gl_Position = view_projection * vec4(frag_pos, 1.0);
+    tex_coords = in_tex_cord;
+    texture_scale = draw.texture_scale;
+}
\ No newline at end of file
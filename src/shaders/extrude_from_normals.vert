@@ -5,6 +5,9 @@ layout(location = 1) in vec3 in_normals;
 layout(location = 2) in vec2 in_tex_cord;
 
 uniform mat4 model;
+// maps the stored vertex positions back to mesh space
+uniform vec3 position_offset;
+uniform vec3 position_scale;
 uniform mat4 view;
 uniform mat4 projection;
 
@@ -12,5 +15,5 @@ uniform float extrude_mul;
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(in_pos + in_normals * extrude_mul, 1.0);
+    gl_Position = projection * view * model * vec4(position_offset + in_pos * position_scale + in_normals * extrude_mul, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,154 @@
+#version 460 core
+
+// compiled in variants of HAS_DIFFUSE_MAP, HAS_BUMP_MAP, HAS_PARALLAX_MAP and FLIP_NORMALS like lighting.frag
+
+// must match the attachments of the g-buffer in the renderer
+layout (location = 0) out vec4 out_albedo;
+layout (location = 1) out vec4 out_normal;
+layout (location = 2) out vec4 out_color;
+layout (location = 3) out vec2 out_depth;
+
+in vec3 frag_pos;
+in vec3 normals;
+in vec2 tex_coords;
+flat in int draw_index;
+
+in mat3 TBN;
+
+// must match DrawInfo in lighting.vert and GlDrawInfo in the renderer
+struct DrawInfo
+{
+    mat4 model;
+    vec4 position_offset;
+    vec4 position_scale;
+    vec4 color;
+    float shininess;
+    float specular;
+    float emission;
+    float transparency;
+    float depth_strength;
+    float bump_strength;
+    float texture_scale;
+    uint flags;
+};
+
+layout(std430, binding = 0) readonly buffer DrawBuffer
+{
+    DrawInfo draws[];
+};
+
+layout(std140, binding = 0) uniform FrameData
+{
+    mat4 view_projection;
+    vec4 view_pos;
+    float camera_near;
+    float camera_far;
+    float shadow_far;
+    vec4 cluster_scale;
+};
+
+DrawInfo draw;
+
+#ifdef HAS_DIFFUSE_MAP
+uniform sampler2D diffuse_map;
+#endif
+
+#ifdef HAS_BUMP_MAP
+uniform sampler2D bump_map;
+#endif
+
+#ifdef HAS_PARALLAX_MAP
+uniform sampler2D depth_map;
+#endif
+
+vec4 sample_diffuse(vec2 coords)
+{
+#ifdef HAS_DIFFUSE_MAP
+    return texture(diffuse_map, coords * draw.texture_scale);
+#else
+    return vec4(draw.color.rgb, 1);
+#endif
+}
+
+#ifdef HAS_PARALLAX_MAP
+// same as lighting.frag
+vec2 parallax_coords(vec3 view_dir)
+{
+    const float min_layers = 8.0;
+    const float max_layers = 32.0;
+    const float layers = mix(max_layers, min_layers, max(dot(vec3(0.0, 0.0, 1.0), view_dir), 0.0));
+    const float layer_depth = 1 / layers;
+    const vec2 delta_coords = view_dir.xy * draw.depth_strength / layers;
+
+    float current_layer_depth = 0;
+
+    vec2  current_coords = tex_coords;
+    float current_depth_value = texture(depth_map, current_coords).r;
+
+    while (current_layer_depth < current_depth_value)
+    {
+        current_coords -= delta_coords;
+        current_depth_value = texture(depth_map, current_coords).r;
+        current_layer_depth += layer_depth;
+    }
+
+    vec2 previous_coords = current_coords + delta_coords;
+
+    float after_depth  = current_depth_value - current_layer_depth;
+    float before_depth = texture(depth_map, previous_coords).r - current_layer_depth + layer_depth;
+
+    float weight = after_depth / (after_depth - before_depth);
+    vec2 final_coords = previous_coords * weight + current_coords * (1.0 - weight);
+
+    return final_coords;
+}
+#endif
+
+void main()
+{
+    draw = draws[draw_index];
+
+    vec2 coords = tex_coords;
+
+#ifdef HAS_PARALLAX_MAP
+    vec3 view_dir = normalize(view_pos.xyz * TBN - frag_pos * TBN);
+
+    coords = parallax_coords(view_dir);
+
+    if(coords.x > 1.0 || coords.y > 1.0 || coords.x < 0.0 || coords.y < 0.0)
+    {
+        discard;
+    }
+#endif
+
+    vec3 normal;
+
+#ifdef HAS_BUMP_MAP
+    vec3 bump_normal = texture(bump_map, coords).rgb;
+
+#ifdef FLIP_NORMALS
+    bump_normal.y = -bump_normal.y;
+#endif
+
+    bump_normal = bump_normal * 2 - 1.0;
+    bump_normal.xy *= draw.bump_strength;
+
+    // the lighting pass works in world space instead of tangent space
+    normal = normalize(TBN * bump_normal);
+#else
+    normal = normalize(normals);
+#endif
+
+    vec4 diffuse = sample_diffuse(coords);
+
+    if (diffuse.a < 0.1)
+    {
+        discard;
+    }
+
+    out_albedo = vec4(diffuse.rgb, draw.specular);
+    out_normal = vec4(normal, draw.shininess);
+    out_color = vec4(draw.color.rgb, draw.emission);
+    // the flags are small enough to be stored exactly as a float
+    out_depth = vec2(gl_FragCoord.z, float(draw.flags));
+}
\ No newline at end of file
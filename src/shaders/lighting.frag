@@ -1,81 +1,69 @@
 #version 460 core
 
+// compiled in variants, the renderer defines these from the material and settings of a batch:
+// HAS_DIFFUSE_MAP, HAS_BUMP_MAP, HAS_PARALLAX_MAP, FLIP_NORMALS, RECEIVE_LIGHT, RECEIVE_SHADOWS,
+// SOFT_SHADOWS, VISUALIZE_DEPTH and WEIGHTED_OIT
+
 layout (location = 0) out vec4 frag_color;
 layout (location = 1) out vec4 bright_color;
 
 uniform float bright_threshold;
-uniform float texture_scale;
-uniform bool receive_lighting;
-uniform bool visualize_depth;
-uniform bool flip_normals;
-uniform bool contribute_bloom;
-
-uniform float camera_near;
-uniform float camera_far;
-uniform vec3 view_pos;
 
-uniform float shadow_far;
-uniform int pcf_samples;
-uniform float shadow_bias;
-uniform bool enable_soft_shadows;
+#include "lighting_common.glsl"
 
 in vec3 frag_pos;
 in vec3 normals;
 in vec2 tex_coords;
+flat in int draw_index;
 
 in mat3 TBN;
 
-struct Texture
-{
-    sampler2D sampler;
-    bool enabled;
-};
+// values taken from model.hpp, the other flags are turned into variants
+#define MAT_CONTRIBUTE_BLOOM 16u
 
-struct Material
+// must match DrawInfo in lighting.vert and GlDrawInfo in the renderer
+struct DrawInfo
 {
-    Texture diffuse;
-    Texture bump;
-    Texture depth;
-    float depth_strength;
-    float bump_strength;
-    float specular;
+    mat4 model;
+    // maps the stored vertex positions back to mesh space, xyz used
+    vec4 position_offset;
+    vec4 position_scale;
+    vec4 color;
     float shininess;
+    float specular;
     float emission;
     float transparency;
-    vec3 color;
-    bool cast_shadow;
+    float depth_strength;
+    float bump_strength;
+    float texture_scale;
+    uint flags;
 };
 
-struct Light
+layout(std430, binding = 0) readonly buffer DrawBuffer
 {
-    bool is_active;
-    bool is_spot;
-    vec3 position;
-    vec3 direction;
-    float cutoff;
-    float outer_cutoff;
-
-    vec3 color;
-    float ambient;
-    float diffuse;
-    float specular;
+    DrawInfo draws[];
+};
 
-    float power;
+// the per draw values of the mesh being shaded
+DrawInfo draw;
 
-    float constant;
-    float linear;
-    float quadratic;
+// the textures are shared by every draw in a multi draw, everything else is in the draw buffer
+#ifdef HAS_DIFFUSE_MAP
+uniform sampler2D diffuse_map;
+#endif
 
-    samplerCube shadow_map;
-};
+#ifdef HAS_BUMP_MAP
+uniform sampler2D bump_map;
+#endif
 
-uniform Material material;
+#ifdef HAS_PARALLAX_MAP
+uniform sampler2D depth_map;
+#endif
 
-#define MAX_LIGHTS 16
-uniform Light lights[MAX_LIGHTS];
-uniform int light_count;
-
-uniform samplerCube shadow_maps[2];
+bool has_flag(uint flag)
+{
+    return (draw.flags & flag) != 0u;
+}
 
 bool all_is(vec3 vec, float value)
 {
@@ -87,22 +75,13 @@ bool all_is(vec3 vec, float value)
     return false;
 }
 
-float get_attenuation(Light light)
-{
-    float distance = length(light.position - frag_pos);
-
-    return 1.0 / (light.constant + light.linear * distance +
-    		    light.quadratic * (distance * distance));
-}
-
-vec4 create_texture(Texture text, vec2 coords)
+vec4 sample_diffuse(vec2 coords)
 {
-    if (!text.enabled)
-    {
-        return vec4(material.color, 1);
-    }
-
-    return texture(text.sampler, coords * texture_scale);
+#ifdef HAS_DIFFUSE_MAP
+    return texture(diffuse_map, coords * draw.texture_scale);
+#else
+    return vec4(draw.color.rgb, 1);
+#endif
 }
 
 struct LightingData
@@ -118,81 +97,25 @@ struct LightingData
 
 LightingData data;
 
-float calculate_penumbra_width(float current_depth, Light light)
-{
-    float light_distance = length(frag_pos - light.position);
-    float penumbra_width = (light_distance - current_depth) / 5;
-
-    return penumbra_width;
-}
-
-float calculate_filter_radius(float penumbra_width, float current_depth, float closest_depth)
-{
-    float filter_radius = penumbra_width * abs(current_depth - closest_depth);
-
-    return filter_radius;
-}
-
-vec3 sampling_disk[20] = vec3[]
-(
-   vec3(1, 1,  1), vec3( 1, -1,  1), vec3(-1, -1,  1), vec3(-1, 1,  1),
-   vec3(1, 1, -1), vec3( 1, -1, -1), vec3(-1, -1, -1), vec3(-1, 1, -1),
-   vec3(1, 1,  0), vec3( 1, -1,  0), vec3(-1, -1,  0), vec3(-1, 1,  0),
-   vec3(1, 0,  1), vec3(-1,  0,  1), vec3( 1,  0, -1), vec3(-1, 0, -1),
-   vec3(0, 1,  1), vec3( 0, -1,  1), vec3( 0, -1, -1), vec3( 0, 1, -1)
-);
-
-float calculate_pcf(Light light)
+vec3 calculate_lighting(Light light, LightingData data)
 {
-    vec3 frag_to_light = frag_pos - light.position;
-
-    float current_depth = length(frag_to_light);
-
-    float shadow = 0.0;
-    float view_distance = length(view_pos - frag_pos);
-    float disk_radius = (1.0 + (view_distance / shadow_far)) / shadow_far;
-    float penumbra_width = calculate_penumbra_width(current_depth, light);
-
-    for (int i = 0; i < pcf_samples; ++i)
-    {
-        float closest_depth = texture(light.shadow_map, frag_to_light + sampling_disk[i] * disk_radius).r;
-        closest_depth *= shadow_far;
+#ifdef HAS_BUMP_MAP
+    data.light_pos = light.position * TBN;
+#else
+    data.light_pos = light.position;
+#endif
 
-        float filter_radius = calculate_filter_radius(penumbra_width, current_depth, closest_depth);
-
-        if (current_depth - shadow_bias > closest_depth - filter_radius)
-        {
-            shadow += 1.0;
-        }
-    }
-
-    shadow /= float(pcf_samples);
-
-    return shadow;
-}
+    vec3 light_dir = normalize(data.light_pos - data.frag_pos);
 
-float calculate_shadows(Light light)
-{
-    if (enable_soft_shadows)
+    // directional lights have no position, only the direction they shine in
+    if (light.is_directional)
     {
-        return calculate_pcf(light);
+#ifdef HAS_BUMP_MAP
+        light_dir = normalize(-light.direction * TBN);
+#else
+        light_dir = normalize(-light.direction);
+#endif
     }
-
-    vec3 frag_to_light = frag_pos - light.position;
-
-    float closest_depth = texture(light.shadow_map, frag_to_light).r;
-    closest_depth *= shadow_far;
-    float current_depth = length(frag_to_light);
-    float bias = 0.05;
-
-    return current_depth - bias > closest_depth ? 1.0 : 0.0;
-}
-
-vec3 calculate_lighting(Light light, LightingData data)
-{
-    data.light_pos = material.bump.enabled ? light.position * TBN : light.position;
-
-    vec3 light_dir = normalize(data.light_pos - data.frag_pos);
     vec3 halfway_dir = normalize(light_dir + data.view_dir);
 
     float diff = max(dot(data.norm, light_dir), 0.0);
@@ -200,7 +123,7 @@ vec3 calculate_lighting(Light light, LightingData data)
     vec3 diffuse = light.color * light.diffuse * diff * data.diffuse * light.power;
     vec3 ambient =  light.color * data.diffuse * light.ambient * light.power;
 
-    float spec = pow(max(dot(data.norm, halfway_dir), 0.0), material.shininess);
+    float spec = pow(max(dot(data.norm, halfway_dir), 0.0), draw.shininess);
     vec3 specular = light.color * data.specular * spec * light.specular * light.power;
 
     if (light.is_spot)
@@ -213,101 +136,108 @@ vec3 calculate_lighting(Light light, LightingData data)
         specular *= intensity;
     }
 
-    float attenuation = get_attenuation(light);
+    // directional lights are as strong everywhere
+    float attenuation = light.is_directional ? 1.0 : get_attenuation(light, frag_pos);
 
     ambient  *= attenuation;
     diffuse  *= attenuation;
     specular *= attenuation;
 
-    float shadow = material.cast_shadow ? calculate_shadows(light) : 0;
+#ifdef RECEIVE_SHADOWS
+    float shadow = calculate_shadows(light, frag_pos);
+#else
+    float shadow = 0.0;
+#endif
 
-    return ambient + (1 - shadow) * (diffuse + specular + material.emission);
+    return ambient + (1 - shadow) * (diffuse + specular);
 }
 
 vec4 calculate_depth()
 {
-    float z = gl_FragCoord.z * 2.0 - 1.0;
-    float linear_depth = (2.0 * camera_near * camera_far) / (camera_far + camera_near - z * (camera_far - camera_near));
-
-    return vec4(vec3(linear_depth / camera_far), 1.0);
+    return vec4(vec3(linear_depth(gl_FragCoord.z) / camera_far), 1.0);
 }
 
+#ifdef HAS_PARALLAX_MAP
 vec2 parallax_coords(vec3 view_dir)
 {
     const float min_layers = 8.0;
     const float max_layers = 32.0;
     const float layers = mix(max_layers, min_layers, max(dot(vec3(0.0, 0.0, 1.0), view_dir), 0.0));
     const float layer_depth = 1 / layers;
-    const vec2 delta_coords = view_dir.xy * material.depth_strength / layers;
+    const vec2 delta_coords = view_dir.xy * draw.depth_strength / layers;
 
     float current_layer_depth = 0;
 
     vec2  current_coords = tex_coords;
-    float current_depth_value = texture(material.depth.sampler, current_coords).r;
+    float current_depth_value = texture(depth_map, current_coords).r;
 
     while (current_layer_depth < current_depth_value)
     {
         current_coords -= delta_coords;
-        current_depth_value = texture(material.depth.sampler, current_coords).r;
+        current_depth_value = texture(depth_map, current_coords).r;
         current_layer_depth += layer_depth;
     }
 
     vec2 previous_coords = current_coords + delta_coords;
 
     float after_depth  = current_depth_value - current_layer_depth;
-    float before_depth = texture(material.depth.sampler, previous_coords).r - current_layer_depth + layer_depth;
+    float before_depth = texture(depth_map, previous_coords).r - current_layer_depth + layer_depth;
 
     float weight = after_depth / (after_depth - before_depth);
     vec2 final_coords = previous_coords * weight + current_coords * (1.0 - weight);
 
     return final_coords;
 }
+#endif
 
 void main()
 {
-    if (visualize_depth)
-    {
-        frag_color = calculate_depth();
-        return;
-    }
+    draw = draws[draw_index];
 
-    vec3 result;
+#ifdef VISUALIZE_DEPTH
+    frag_color = calculate_depth();
+    return;
+#endif
 
+    vec3 result = vec3(0);
+    bool unlit = false;
+
+    // the lighting happens in tangent space only when there is a normal map to match
+#ifdef HAS_BUMP_MAP
     data.frag_pos = frag_pos * TBN;
-    data.view_pos = view_pos * TBN;
+    data.view_pos = view_pos.xyz * TBN;
+#else
+    data.frag_pos = frag_pos;
+    data.view_pos = view_pos.xyz;
+#endif
     data.view_dir = normalize(data.view_pos - data.frag_pos);
 
     vec2 coords = tex_coords;
 
-    if (material.depth.enabled)
-    {
-        coords = parallax_coords(data.view_dir);
+#ifdef HAS_PARALLAX_MAP
+    coords = parallax_coords(normalize(view_pos.xyz * TBN - frag_pos * TBN));
 
-        if(coords.x > 1.0 || coords.y > 1.0 || coords.x < 0.0 || coords.y < 0.0)
-        {
-            discard;
-        }
+    if(coords.x > 1.0 || coords.y > 1.0 || coords.x < 0.0 || coords.y < 0.0)
+    {
+        discard;
     }
+#endif
 
-    if (material.bump.enabled)
-    {
-        vec3 bump_normal = texture(material.bump.sampler, coords).rgb;
+#ifdef HAS_BUMP_MAP
+    vec3 bump_normal = texture(bump_map, coords).rgb;
 
-        if (flip_normals)
-        {
-            bump_normal.y = -bump_normal.y;
-        }
+#ifdef FLIP_NORMALS
+    bump_normal.y = -bump_normal.y;
+#endif
 
-        bump_normal = bump_normal * 2 - 1.0;
-        bump_normal.xy *= material.bump_strength;
-        data.norm = normalize(bump_normal);
-    }
-    else
-    {
-        data.norm = normalize(normals);
-    }
+    bump_normal = bump_normal * 2 - 1.0;
+    bump_normal.xy *= draw.bump_strength;
+    data.norm = normalize(bump_normal);
+#else
+    data.norm = normalize(normals);
+#endif
 
-    vec4 diffuse = create_texture(material.diffuse, coords);
+    vec4 diffuse = sample_diffuse(coords);
 
     if (diffuse.a < 0.1)
     {
@@ -315,35 +245,42 @@ void main()
     }
 
     data.diffuse = diffuse.xyz;
-    data.specular = material.specular;
+    data.specular = draw.specular;
 
-    if (receive_lighting)
+#ifdef RECEIVE_LIGHT
+    // only the lights that can reach the cluster of the fragment
+    uvec2 cluster = clusters[cluster_index(gl_FragCoord.z)];
+
+    for (uint i = 0u; i < cluster.y; i++)
     {
-        for (int i = 0; i < light_count; i++)
-        {
-            if (lights[i].is_active)
-            {
-                result += calculate_lighting(lights[i], data);
-            }
-        }
+        result += calculate_lighting(lights[light_indices[cluster.x + i]], data);
     }
-    else
+
+    // directional lights reach every fragment so they are not binned into the clusters
+    for (uint i = 0u; i < directional_lights.y; i++)
     {
-        result += data.diffuse;
+        result += calculate_lighting(lights[directional_lights.x + i], data);
     }
 
-    if (any(greaterThan(material.color, vec3(0.0))))
+    // emission does not depend on the lights so it is added once
+    result += draw.emission;
+    unlit = !scene_has_lights();
+#else
+    result += data.diffuse;
+#endif
+
+    if (any(greaterThan(draw.color.rgb, vec3(0.0))))
     {
-        if (result.x == 0 && result.y == 0 && result.z == 0)
+        if (unlit)
         {
             result = vec3(1);
         }
-        result *= material.color;
+        result *= draw.color.rgb;
     }
 
     float brightness = dot(result, vec3(0.2126, 0.7152, 0.0722));
 
-    if (brightness > bright_threshold && contribute_bloom)
+    if (brightness > bright_threshold && has_flag(MAT_CONTRIBUTE_BLOOM))
     {
         bright_color = vec4(result, 1);
     }
@@ -352,5 +289,15 @@ void main()
         bright_color = vec4(0, 0, 0, 1);
     }
 
-    frag_color = vec4(result, diffuse.a * material.transparency);
+#ifdef WEIGHTED_OIT
+    // weighted blended transparency, nearer and more opaque layers weigh more in the averaged color.
+    // the second target multiplies the revealage by one minus the alpha so bloom is left out
+    float alpha = diffuse.a * draw.transparency;
+    float weight = clamp(alpha * max(1e-2, 3e3 * pow(1.0 - gl_FragCoord.z, 3.0)), 1e-2, 3e3);
+
+    frag_color = vec4(result * alpha, alpha) * weight;
+    bright_color = vec4(alpha);
+#else
+    frag_color = vec4(result, diffuse.a * draw.transparency);
+#endif
 }
\ No newline at end of file
@@ -3,37 +3,81 @@
 layout(location = 0) in vec3 in_pos;
 layout(location = 1) in vec3 in_normals;
 layout(location = 2) in vec2 in_tex_cord;
-layout(location = 3) in vec3 in_tangent;
-layout(location = 4) in vec3 in_bitangent;
+// w holds the sign of the bitangent
+layout(location = 3) in vec4 in_tangent;
 
-uniform mat4 model;
-uniform mat4 mvp;
+// must match DrawInfo in lighting.frag and GlDrawInfo in the renderer
+struct DrawInfo
+{
+    mat4 model;
+    // maps the stored vertex positions back to mesh space, xyz used
+    vec4 position_offset;
+    vec4 position_scale;
+    vec4 color;
+    float shininess;
+    float specular;
+    float emission;
+    float transparency;
+    float depth_strength;
+    float bump_strength;
+    float texture_scale;
+    uint flags;
+};
+
+layout(std430, binding = 0) readonly buffer DrawBuffer
+{
+    DrawInfo draws[];
+};
+
+// per view values, must match ConstantData in the renderer
+layout(std140, binding = 0) uniform FrameData
+{
+    mat4 view_projection;
+    vec4 view_pos;
+    float camera_near;
+    float camera_far;
+    float shadow_far;
+    vec4 cluster_scale;
+};
+
+// index of the first draw of the current multi draw in the draw buffer
+uniform int draw_offset;
 
 out vec2 tex_coords;
 out vec3 normals;
 out vec3 frag_pos;
+flat out int draw_index;
 
 out mat3 TBN;
 
-mat3 calculate_TBN()
+// the depth pre-pass computes the same position so the shading pass can test with GL_EQUAL
+invariant gl_Position;
+
+mat3 calculate_TBN(mat4 model)
 {
-    vec3 T = normalize(vec3(model * vec4(in_tangent, 0.0)));
+    vec3 T = normalize(vec3(model * vec4(in_tangent.xyz, 0.0)));
     vec3 N = normalize(vec3(model * vec4(in_normals, 0.0)));
 
     T = normalize(T - dot(T, N) * N);
 
-    vec3 B = cross(N, T);
+    vec3 B = cross(N, T) * in_tangent.w;
 
     return mat3(T, B, N);
 }
 
 void main()
 {
-    TBN = calculate_TBN();
+    draw_index = draw_offset + gl_DrawID;
+
+    DrawInfo draw = draws[draw_index];
+    mat4 model = draw.model;
+    vec3 position = draw.position_offset.xyz + in_pos * draw.position_scale.xyz;
 
-    frag_pos = vec3(model * vec4(in_pos, 1.0));
+    TBN = calculate_TBN(model);
 
-    gl_Position = mvp * vec4(in_pos, 1.0);
+    frag_pos = vec3(model * vec4(position, 1.0));
+
+    gl_Position = view_projection * vec4(frag_pos, 1.0);
     tex_coords = in_tex_cord;
     normals = mat3(transpose(inverse(model))) * in_normals;
-}
\ No newline at end of file
+}
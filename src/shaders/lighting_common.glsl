@@ -0,0 +1,282 @@
+// shared by the forward and the deferred lighting shaders, make_program pastes it where a shader includes it.
+// everything that reads the surface being shaded stays in the shaders, the functions here take what they need
+
+#define MAX_SHADOW_CASCADES 4
+
+// per view values, must match ConstantData in the renderer
+layout(std140, binding = 0) uniform FrameData
+{
+    mat4 view_projection;
+    vec4 view_pos;
+    float camera_near;
+    float camera_far;
+    float shadow_far;
+    // tiles per pixel in x and y, then the scale and bias that turn the log of the view depth into a slice
+    vec4 cluster_scale;
+    // the first directional light in the light buffer, how many there are and the shadow cascades in use
+    uvec4 directional_lights;
+    // the depth every cascade covers in world units
+    vec4 cascade_ranges;
+    mat4 cascade_transforms[MAX_SHADOW_CASCADES];
+};
+
+uniform int pcf_samples;
+uniform float shadow_bias;
+// the radius of the soft shadow filter in texels of the shadow map
+uniform float filter_radius;
+
+// the taps every soft shadow starts with, the rest of the kernel is only taken in the penumbra
+#define SHADOW_PROBES 4
+
+// must match GlLightData in the renderer
+struct Light
+{
+    vec3 position;
+    // past this distance the light is ignored
+    float range;
+    vec3 direction;
+    float cutoff;
+
+    vec3 color;
+    float outer_cutoff;
+    float ambient;
+    float diffuse;
+    float specular;
+
+    float power;
+
+    float constant;
+    float linear;
+    float quadratic;
+
+    // >= 0 when the light has a shadow, point and spot lights have theirs in the shadow atlas
+    int shadow_index;
+    bool is_spot;
+    bool is_directional;
+    // the size of a face in the atlas, in uv
+    float shadow_tile_size;
+    // the corners of the first two tiles of a point light in uv, spot lights only use the first
+    vec4 shadow_rect;
+    // projects world positions into the shadow map of a spot light
+    mat4 shadow_transform;
+    // the corner of the last face of a point light in uv
+    vec2 shadow_corner;
+};
+
+// must match LightClusters
+#define CLUSTER_TILES_X 16u
+#define CLUSTER_TILES_Y 9u
+#define CLUSTER_SLICES 24u
+
+layout(std430, binding = 1) readonly buffer LightBuffer
+{
+    Light lights[];
+};
+
+// offset into the light indices and the light count of every cluster
+layout(std430, binding = 2) readonly buffer ClusterBuffer
+{
+    uvec2 clusters[];
+};
+
+layout(std430, binding = 3) readonly buffer LightIndexBuffer
+{
+    uint light_indices[];
+};
+
+uniform sampler2DShadow shadow_atlas;
+uniform sampler2DArrayShadow cascade_shadow_map;
+
+float get_attenuation(Light light, vec3 position)
+{
+    float distance = length(light.position - position);
+
+    // fades the light out towards its range so it does not pop at the edge of the clusters it was binned into
+    float window = clamp(1.0 - pow(distance / light.range, 4.0), 0.0, 1.0);
+
+    return window * window / (light.constant + light.linear * distance +
+    		    light.quadratic * (distance * distance));
+}
+
+// the face of a cube a direction points at in the order they are rendered, +x -x +y -y +z -z,
+// and the coordinates on it the way cube map lookups pick them
+vec2 cube_face_coords(vec3 direction, out int face)
+{
+    vec3 size = abs(direction);
+
+    if (size.x >= size.y && size.x >= size.z)
+    {
+        face = direction.x > 0.0 ? 0 : 1;
+        return vec2(direction.x > 0.0 ? -direction.z : direction.z, -direction.y) / size.x * 0.5 + 0.5;
+    }
+
+    if (size.y >= size.z)
+    {
+        face = direction.y > 0.0 ? 2 : 3;
+        return vec2(direction.x, direction.y > 0.0 ? direction.z : -direction.z) / size.y * 0.5 + 0.5;
+    }
+
+    face = direction.z > 0.0 ? 4 : 5;
+    return vec2(direction.z > 0.0 ? direction.x : -direction.x, -direction.y) / size.z * 0.5 + 0.5;
+}
+
+// the first four faces of a point light are the quadrants of its first tile and the last two have a tile each
+vec2 face_corner(Light light, int face)
+{
+    if (face >= 4)
+    {
+        return face == 4 ? light.shadow_rect.zw : light.shadow_corner;
+    }
+
+    return light.shadow_rect.xy + vec2(face & 1, (face >> 1) & 1) * light.shadow_tile_size;
+}
+
+// one hardware filtered tap that compares against 2x2 texels, 1 where the position is lit.
+// a negative layer samples the atlas, otherwise that cascade
+float shadow_tap(vec2 coords, vec4 bounds, float depth, int layer)
+{
+    coords = clamp(coords, bounds.xy, bounds.zw);
+
+    if (layer < 0)
+    {
+        return texture(shadow_atlas, vec3(coords, depth));
+    }
+
+    return texture(cascade_shadow_map, vec4(coords, float(layer), depth));
+}
+
+#ifdef SOFT_SHADOWS
+// spread evenly over the disk whatever the count, the rotation changes per pixel so the banding turns into noise
+vec2 vogel_offset(int i, int count, float rotation)
+{
+    float radius = sqrt((float(i) + 0.5) / float(count));
+    float angle = float(i) * 2.3999632 + rotation;
+
+    return radius * vec2(cos(angle), sin(angle));
+}
+#endif
+
+// the lit fraction around coords, bounds keeps the taps inside the face they belong to
+float filter_shadow(vec2 coords, vec4 bounds, float depth, int layer, vec2 radius)
+{
+#ifdef SOFT_SHADOWS
+    float rotation = 6.2831853 * fract(52.9829189 * fract(dot(gl_FragCoord.xy, vec2(0.06711056, 0.00583715))));
+    float lit = 0.0;
+
+    for (int i = 0; i < SHADOW_PROBES; i++)
+    {
+        lit += shadow_tap(coords + vogel_offset(i, SHADOW_PROBES, rotation) * radius, bounds, depth, layer);
+    }
+
+    // probes that agree mean the position is not in a penumbra, which is most of the screen
+    if (lit == 0.0 || lit == float(SHADOW_PROBES) || pcf_samples <= SHADOW_PROBES)
+    {
+        return lit / float(SHADOW_PROBES);
+    }
+
+    lit = 0.0;
+
+    for (int i = 0; i < pcf_samples; i++)
+    {
+        lit += shadow_tap(coords + vogel_offset(i, pcf_samples, rotation) * radius, bounds, depth, layer);
+    }
+
+    return lit / float(pcf_samples);
+#else
+    return shadow_tap(coords, bounds, depth, layer);
+#endif
+}
+
+// the shadow of a point or spot light from its tiles in the atlas
+float calculate_atlas_shadows(Light light, vec3 position)
+{
+    vec3 frag_to_light = position - light.position;
+    int face = 0;
+    vec2 coords;
+
+    if (light.is_spot)
+    {
+        vec4 clip = light.shadow_transform * vec4(position, 1.0);
+        coords = clip.xy / clip.w * 0.5 + 0.5;
+
+        // nothing outside the cone was rendered, and the spot does not light it either
+        if (clip.w <= 0.0 || any(lessThan(coords, vec2(0.0))) || any(greaterThan(coords, vec2(1.0))))
+        {
+            return 0.0;
+        }
+    }
+    else
+    {
+        coords = cube_face_coords(frag_to_light, face);
+    }
+
+    vec2 corner = face_corner(light, face);
+    vec2 texel = 1.0 / vec2(textureSize(shadow_atlas, 0));
+    // the texels around the face belong to other faces or lights
+    vec4 bounds = vec4(corner + 0.5 * texel, corner + light.shadow_tile_size - 0.5 * texel);
+
+    // the maps store the distance to the light divided by shadow_far
+    float depth = (length(frag_to_light) - shadow_bias) / shadow_far;
+
+    return 1.0 - filter_shadow(corner + coords * light.shadow_tile_size, bounds, depth, -1, filter_radius * texel);
+}
+
+// the shadow of a directional light from the finest cascade that covers the position
+float calculate_cascade_shadows(vec3 position)
+{
+    for (uint i = 0u; i < directional_lights.z; i++)
+    {
+        vec3 coords = (cascade_transforms[i] * vec4(position, 1.0)).xyz * 0.5 + 0.5;
+
+        if (any(lessThan(coords, vec3(0.0))) || any(greaterThan(coords, vec3(1.0))))
+        {
+            continue;
+        }
+
+        vec2 texel = 1.0 / vec2(textureSize(cascade_shadow_map, 0).xy);
+        // the bias is in world units like the other lights, the depth of a cascade is linear over its range
+        float depth = coords.z - shadow_bias / cascade_ranges[i];
+
+        return 1.0 - filter_shadow(coords.xy, vec4(0.5 * texel, 1.0 - 0.5 * texel), depth, int(i), filter_radius * texel);
+    }
+
+    return 0.0;
+}
+
+float calculate_shadows(Light light, vec3 position)
+{
+    if (light.shadow_index < 0)
+    {
+        return 0.0;
+    }
+
+    if (light.is_directional)
+    {
+        return calculate_cascade_shadows(position);
+    }
+
+    return calculate_atlas_shadows(light, position);
+}
+
+// false when nothing lights the scene, lit surfaces then show their plain color instead of black
+bool scene_has_lights()
+{
+    return directional_lights.x + directional_lights.y > 0u;
+}
+
+// the view depth of a window space depth
+float linear_depth(float depth)
+{
+    float z = depth * 2.0 - 1.0;
+
+    return (2.0 * camera_near * camera_far) / (camera_far + camera_near - z * (camera_far - camera_near));
+}
+
+// the cluster of the fragment being shaded at the window space depth
+uint cluster_index(float depth)
+{
+    uvec2 tile = min(uvec2(gl_FragCoord.xy * cluster_scale.xy), uvec2(CLUSTER_TILES_X - 1u, CLUSTER_TILES_Y - 1u));
+    float slice = floor(log(linear_depth(depth)) * cluster_scale.z + cluster_scale.w);
+
+    return tile.x + CLUSTER_TILES_X * (tile.y + CLUSTER_TILES_Y * uint(clamp(slice, 0.0, float(CLUSTER_SLICES - 1u))));
+}
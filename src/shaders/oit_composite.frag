@@ -0,0 +1,45 @@
+#version 460 core
+
+// compiled in variant MULTISAMPLED, the targets are resolved per sample when the framebuffer is multisampled
+
+layout (location = 0) out vec4 frag_color;
+layout (location = 1) out vec4 bright_color;
+
+in vec2 tex_coords;
+
+// the weighted sum of the premultiplied colors and alphas, and the product of one minus every alpha
+#ifdef MULTISAMPLED
+uniform sampler2DMS accumulation;
+uniform sampler2DMS revealage;
+#else
+uniform sampler2D accumulation;
+uniform sampler2D revealage;
+#endif
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+
+#ifdef MULTISAMPLED
+    vec4 accum = texelFetch(accumulation, pixel, gl_SampleID);
+    float reveal = texelFetch(revealage, pixel, gl_SampleID).r;
+#else
+    vec4 accum = texelFetch(accumulation, pixel, 0);
+    float reveal = texelFetch(revealage, pixel, 0).r;
+#endif
+
+    // nothing transparent covers the pixel
+    if (reveal >= 1.0)
+    {
+        discard;
+    }
+
+    // half floats overflow when many bright layers overlap, keep the average finite
+    if (any(isinf(accum)))
+    {
+        accum.rgb = vec3(accum.a);
+    }
+
+    frag_color = vec4(accum.rgb / max(accum.a, 1e-5), 1.0 - reveal);
+    bright_color = vec4(0);
+}
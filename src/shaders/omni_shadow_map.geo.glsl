@@ -11,7 +11,8 @@ void main()
 {
     for (int face = 0; face < 6; ++face)
     {
-        gl_Layer = face;
+        // every face has its own viewport in the tiles of the light in the shadow atlas
+        gl_ViewportIndex = face;
 
         for (int i = 0; i < 3; ++i)
         {
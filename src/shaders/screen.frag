@@ -10,6 +10,10 @@ uniform vec2 resolution;
 uniform float gamma;
 uniform float exposure;
 uniform bool enable_bloom;
+uniform float bloom_strength;
+// the part of the screen texture the scene was rendered into and the last texel center inside it
+uniform vec2 screen_scale;
+uniform vec2 screen_max;
 
 vec4 pp_pixelate()
 {
@@ -142,13 +146,55 @@ vec3 uchimura(vec3 x)
   return uchimura(x, P, a, m, l, c, b);
 }
 
+// catmull-rom upscaling keeps edges sharper than bilinear. the middle two texels on each axis are merged into
+// one bilinear tap and the corners barely count, so the 4x4 filter only takes 5 taps
+vec3 upscale(vec2 coords)
+{
+    vec2 size = textureSize(screen_texture, 0);
+    vec2 position = coords * size;
+    vec2 center = floor(position - 0.5) + 0.5;
+    vec2 f = position - center;
+
+    vec2 w0 = f * (-0.5 + f * (1.0 - 0.5 * f));
+    vec2 w1 = 1.0 + f * f * (-2.5 + 1.5 * f);
+    vec2 w2 = f * (0.5 + f * (2.0 - 1.5 * f));
+    vec2 w3 = f * f * (-0.5 + 0.5 * f);
+
+    vec2 w12 = w1 + w2;
+    vec2 offset12 = w2 / w12;
+
+    vec2 t0 = min((center - 1.0) / size, screen_max);
+    vec2 t3 = min((center + 2.0) / size, screen_max);
+    vec2 t12 = min((center + offset12) / size, screen_max);
+
+    vec3 result = texture(screen_texture, vec2(t12.x, t0.y)).rgb * w12.x * w0.y
+        + texture(screen_texture, vec2(t0.x, t12.y)).rgb * w0.x * w12.y
+        + texture(screen_texture, vec2(t12.x, t12.y)).rgb * w12.x * w12.y
+        + texture(screen_texture, vec2(t3.x, t12.y)).rgb * w3.x * w12.y
+        + texture(screen_texture, vec2(t12.x, t3.y)).rgb * w12.x * w3.y;
+
+    float weight = w12.x * w0.y + w0.x * w12.y + w12.x * w12.y + w3.x * w12.y + w12.x * w3.y;
+
+    // the negative lobes can overshoot next to bright pixels
+    return max(result / weight, 0.0);
+}
+
 void main()
 {
-    vec3 screen_color = texture(screen_texture, tex_coords).rgb;
+    vec3 screen_color;
+
+    if (screen_scale.x < 1.0 || screen_scale.y < 1.0)
+    {
+        screen_color = upscale(tex_coords * screen_scale);
+    }
+    else
+    {
+        screen_color = texture(screen_texture, tex_coords).rgb;
+    }
 
     if (enable_bloom)
     {
-        screen_color += texture(bloom_texture, tex_coords).rgb;
+        screen_color += texture(bloom_texture, tex_coords).rgb * bloom_strength;
     }
 
     vec3 mapped = hable_filmic(screen_color);
@@ -3,8 +3,11 @@
 layout(location = 0) in vec3 in_pos;
 
 uniform mat4 model;
+// maps the stored vertex positions back to mesh space
+uniform vec3 position_offset;
+uniform vec3 position_scale;
 
 void main()
 {
-    gl_Position = model * vec4(in_pos, 1.0);
+    gl_Position = model * vec4(position_offset + in_pos * position_scale, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,6 @@
+#version 460
+
+// the cascades of directional lights only need the depth the rasterizer writes on its own
+void main()
+{
+}
@@ -0,0 +1,17 @@
+#version 460  core
+
+layout(location = 0) in vec3 in_pos;
+
+uniform mat4 model;
+// maps the stored vertex positions back to mesh space
+uniform vec3 position_offset;
+uniform vec3 position_scale;
+uniform mat4 shadow_transform;
+
+out vec4 frag_pos;
+
+void main()
+{
+    frag_pos = model * vec4(position_offset + in_pos * position_scale, 1.0);
+    gl_Position = shadow_transform * frag_pos;
+}
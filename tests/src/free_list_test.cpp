@@ -0,0 +1,83 @@
+#include <cstdio>
+
+#include "data/free_list.hpp"
+
+static int failures = 0;
+
+#define CHECK(expr) \
+	if (!(expr)) \
+	{ \
+		std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr); \
+		failures++; \
+	}
+
+int main()
+{
+	pge::FreeList list(100);
+
+	// ranges are handed out front to back
+	auto a = list.allocate(10);
+	auto b = list.allocate(20);
+	auto c = list.allocate(30);
+
+	CHECK(a == 0);
+	CHECK(b == 10);
+	CHECK(c == 30);
+	CHECK(list.free_space() == 40);
+	CHECK(list.fragments() == 1);
+
+	// more than the largest free range
+	CHECK(list.allocate(41) == pge::FreeList::INVALID);
+
+	// the freed range has a used range on both sides
+	list.free(b, 20);
+
+	CHECK(list.free_space() == 60);
+	CHECK(list.fragments() == 2);
+
+	// first fit takes the hole, the rest of it stays free
+	CHECK(list.allocate(5) == 10);
+	CHECK(list.fragments() == 2);
+
+	// a range merges with the free range after it
+	list.free(10, 5);
+	list.free(a, 10);
+
+	CHECK(list.fragments() == 2);
+	CHECK(list.free_space() == 70);
+	CHECK(list.allocate(25) == 0);
+
+	// the allocation goes back in front of the rest of the hole
+	list.free(0, 25);
+
+	CHECK(list.fragments() == 2);
+
+	// the range between two free ranges merges with both
+	list.free(c, 30);
+
+	CHECK(list.fragments() == 1);
+	CHECK(list.free_space() == 100);
+	CHECK(list.allocate(100) == 0);
+	CHECK(list.fragments() == 0);
+	CHECK(list.allocate(1) == pge::FreeList::INVALID);
+
+	// a range merges with the free range before it
+	list.free(0, 50);
+	list.free(50, 10);
+
+	CHECK(list.fragments() == 1);
+	CHECK(list.allocate(60) == 0);
+
+	list.reset(50);
+
+	CHECK(list.capacity() == 50);
+	CHECK(list.free_space() == 50);
+
+	if (failures > 0)
+	{
+		std::printf("%d checks failed\n", failures);
+		return 1;
+	}
+
+	return 0;
+}
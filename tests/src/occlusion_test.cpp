@@ -0,0 +1,71 @@
+#include <cstdio>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "graphics/occlusion.hpp"
+
+static int failures = 0;
+
+#define CHECK(expr) \
+	if (!(expr)) \
+	{ \
+		std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr); \
+		failures++; \
+	}
+
+// a quad facing the camera at depth z, the camera looks down -z from the origin
+static void rasterize_quad(pge::OcclusionBuffer &buffer, const glm::mat4 &mvp, glm::vec2 min, glm::vec2 max, float z)
+{
+	std::vector<pge::Vertex> vertices(4);
+
+	vertices[0].position = {min.x, min.y, z};
+	vertices[1].position = {max.x, min.y, z};
+	vertices[2].position = {max.x, max.y, z};
+	vertices[3].position = {min.x, max.y, z};
+
+	std::vector<uint32_t> indices = {0, 1, 2, 0, 2, 3};
+
+	buffer.rasterize(vertices, indices, mvp);
+}
+
+int main()
+{
+	auto projection = glm::perspective(glm::radians(90.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+	auto view = glm::lookAt(glm::vec3{0.0f}, {0.0f, 0.0f, -1.0f}, {0.0f, 1.0f, 0.0f});
+	auto mvp = projection * view;
+
+	pge::OcclusionBuffer buffer;
+
+	// a wall covering the whole screen
+	rasterize_quad(buffer, mvp, {-100.0f, -100.0f}, {100.0f, 100.0f}, -5.0f);
+
+	// behind the wall
+	CHECK(buffer.is_occluded({{-1.0f, -1.0f, -11.0f}, {1.0f, 1.0f, -9.0f}}, mvp));
+	// in front of the wall
+	CHECK(!buffer.is_occluded({{-1.0f, -1.0f, -3.0f}, {1.0f, 1.0f, -2.0f}}, mvp));
+	// reaching through the wall
+	CHECK(!buffer.is_occluded({{-1.0f, -1.0f, -9.0f}, {1.0f, 1.0f, -4.0f}}, mvp));
+	// crossing the near plane
+	CHECK(!buffer.is_occluded({{-1.0f, -1.0f, -9.0f}, {1.0f, 1.0f, 1.0f}}, mvp));
+
+	buffer.clear();
+
+	// a wall covering the left half of the screen, its edge ends 0.9 pixels right of the center
+	rasterize_quad(buffer, mvp, {-100.0f, -100.0f}, {0.05f, 100.0f}, -5.0f);
+
+	// behind the wall
+	CHECK(buffer.is_occluded({{-3.0f, -1.0f, -11.0f}, {-1.0f, 1.0f, -9.0f}}, mvp));
+	// beside the wall
+	CHECK(!buffer.is_occluded({{1.0f, -1.0f, -11.0f}, {3.0f, 1.0f, -9.0f}}, mvp));
+	// behind the wall but showing a fraction of a pixel past its edge, inside the pixel the edge crosses
+	CHECK(!buffer.is_occluded({{-3.0f, -1.0f, -10.0f}, {0.1055f, 1.0f, -10.0f}}, mvp));
+
+	if (failures > 0)
+	{
+		std::printf("%d checks failed\n", failures);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "data/radix_sort.hpp"
+
+static int failures = 0;
+
+#define CHECK(expr) \
+	if (!(expr)) \
+	{ \
+		std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr); \
+		failures++; \
+	}
+
+struct Item
+{
+	uint64_t key;
+	// the position before sorting, equal keys have to keep their order
+	uint32_t index;
+};
+
+static std::vector<Item> make_items(size_t count, uint64_t mask, uint32_t seed)
+{
+	std::mt19937_64 random(seed);
+	std::vector<Item> output;
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		output.push_back({random() & mask, i});
+	}
+
+	return output;
+}
+
+// sorts with both the radix sort and std::stable_sort and checks they agree
+static bool matches_stable_sort(std::vector<Item> items)
+{
+	auto expected = items;
+	std::vector<Item> scratch;
+
+	std::stable_sort(expected.begin(), expected.end(), [](const Item &a, const Item &b)
+	{
+		return a.key < b.key;
+	});
+
+	pge::radix_sort(items, scratch, [](const Item &item)
+	{
+		return item.key;
+	});
+
+	return std::equal(items.begin(), items.end(), expected.begin(), expected.end(), [](const Item &a, const Item &b)
+	{
+		return a.key == b.key && a.index == b.index;
+	});
+}
+
+int main()
+{
+	// every digit differs so no pass is skipped
+	CHECK(matches_stable_sort(make_items(1000, UINT64_MAX, 1)));
+	// few distinct keys in the high digits, most items share a key with others
+	CHECK(matches_stable_sort(make_items(1000, 0x0300'0000'0000'0300, 2)));
+	// only the lowest digit differs, a single pass runs and its result is in the scratch buffer
+	CHECK(matches_stable_sort(make_items(1000, 0xFF, 3)));
+	// two digits differ, the result of the second pass is back in the items
+	CHECK(matches_stable_sort(make_items(1000, 0xFF'0000'FF00, 4)));
+	CHECK(matches_stable_sort(make_items(1, UINT64_MAX, 5)));
+	CHECK(matches_stable_sort({}));
+
+	// every key is equal so every pass is skipped and the order stays as it is
+	std::vector<Item> same(100);
+	std::vector<Item> scratch;
+
+	for (uint32_t i = 0; i < same.size(); i++)
+	{
+		same[i] = {0xABCD, i};
+	}
+
+	pge::radix_sort(same, scratch, [](const Item &item)
+	{
+		return item.key;
+	});
+
+	for (uint32_t i = 0; i < same.size(); i++)
+	{
+		CHECK(same[i].index == i);
+	}
+
+	if (failures > 0)
+	{
+		std::printf("%d checks failed\n", failures);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,125 @@
+#include <cstdio>
+#include <vector>
+
+#include "graphics/shadow_atlas.hpp"
+
+static int failures = 0;
+
+#define CHECK(expr) \
+	if (!(expr)) \
+	{ \
+		std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr); \
+		failures++; \
+	}
+
+static bool overlaps(pge::ShadowAtlas::Tile a, pge::ShadowAtlas::Tile b)
+{
+	return a.position.x < b.position.x + b.size && b.position.x < a.position.x + a.size
+		&& a.position.y < b.position.y + b.size && b.position.y < a.position.y + a.size;
+}
+
+// every tile is inside the atlas and no two tiles share a texel
+static bool is_disjoint(const std::vector<pge::ShadowAtlas::Tile> &tiles, uint32_t size)
+{
+	for (size_t i = 0; i < tiles.size(); i++)
+	{
+		if (tiles[i].position.x + tiles[i].size > size || tiles[i].position.y + tiles[i].size > size)
+		{
+			return false;
+		}
+
+		for (size_t j = i + 1; j < tiles.size(); j++)
+		{
+			if (overlaps(tiles[i], tiles[j]))
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+int main()
+{
+	pge::ShadowAtlas atlas;
+
+	// levels of 1024, 512 and 256 texels
+	atlas.reset(1024, 256);
+
+	// sizes are rounded up to a power of two and clamped to the levels
+	auto rounded = atlas.allocate(300);
+	auto smallest = atlas.allocate(10);
+
+	CHECK(rounded && rounded->size == 512);
+	CHECK(smallest && smallest->size == 256);
+
+	atlas.free(*rounded);
+	atlas.free(*smallest);
+
+	// the whole atlas is one tile again once both are free
+	auto whole = atlas.allocate(5000);
+
+	CHECK(whole && whole->size == 1024);
+	CHECK(!atlas.allocate(256));
+
+	if (whole)
+	{
+		atlas.free(*whole);
+	}
+
+	// the atlas splits into sixteen of the smallest tiles and is full after them
+	std::vector<pge::ShadowAtlas::Tile> tiles;
+
+	while (auto tile = atlas.allocate(256))
+	{
+		tiles.push_back(*tile);
+	}
+
+	CHECK(tiles.size() == 16);
+	CHECK(is_disjoint(tiles, atlas.size()));
+	CHECK(!atlas.allocate(512));
+
+	// one used quarter keeps its parents from merging
+	for (size_t i = 1; i < tiles.size(); i++)
+	{
+		atlas.free(tiles[i]);
+	}
+
+	CHECK(!atlas.allocate(1024));
+
+	// three 512 tiles are whole again, the fourth has the used quarter
+	std::vector<pge::ShadowAtlas::Tile> mixed = {tiles[0]};
+
+	while (auto tile = atlas.allocate(512))
+	{
+		mixed.push_back(*tile);
+	}
+
+	CHECK(mixed.size() == 4);
+
+	while (auto tile = atlas.allocate(256))
+	{
+		mixed.push_back(*tile);
+	}
+
+	CHECK(mixed.size() == 7);
+	CHECK(is_disjoint(mixed, atlas.size()));
+
+	for (auto &tile : mixed)
+	{
+		atlas.free(tile);
+	}
+
+	whole = atlas.allocate(1024);
+
+	CHECK(whole && whole->position == glm::u16vec2(0));
+
+	if (failures > 0)
+	{
+		std::printf("%d checks failed\n", failures);
+		return 1;
+	}
+
+	return 0;
+}